@@ -0,0 +1,154 @@
+#include "EnvironmentLighting.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stb_image.h>
+
+#include "Logging/Logging.h"
+#include "Rendering/Platform/Material.h"
+#include "Util/CacheKey.h"
+#include "Util/FileIO.h"
+#include "Util/Image/TextureCache.h"
+
+using namespace Engine;
+
+namespace {
+	template<typename T>
+	std::shared_ptr<T> loadOrBake(const std::string& key, const std::function<TextureFileData()>& bake,
+		std::shared_ptr<T>(*fromFile)(const TextureFile&), std::shared_ptr<T>(*fromData)(const TextureFileData&)) {
+		auto cached = TextureCache::Load(key);
+		if (cached) {
+			auto texture = fromFile(*cached);
+			if (texture)
+				return texture;
+		}
+
+		// Empty if the bake failed
+		TextureFileData data = bake();
+		if (data.images.empty())
+			return nullptr;
+		TextureCache::Store(key, data);
+		return fromData(data);
+	}
+
+	// The environment resampled to a cubemap, decoded only when something actually has to be baked
+	class EnvironmentSource {
+	public:
+		EnvironmentSource(const std::string& path, uint32_t faceSize)
+			: _path(path), _faceSize(faceSize) {}
+
+		const TextureFileData* Get() {
+			if (_loaded)
+				return _cubemap.images.empty() ? nullptr : &_cubemap;
+			_loaded = true;
+
+			auto image = Texture::Utils::LoadFromFile(_path);
+			if (!image.data) {
+				ENGINE_ERROR("[EnvironmentLighting::FromEquirectangularFile] Failed to load {}", _path);
+				return nullptr;
+			}
+
+			uint32_t channels = Engine::Utils::ImageFormatChannelCount(image.format);
+			size_t count = (size_t)image.width * image.height * channels;
+			if (channels < 3) {
+				ENGINE_ERROR("[EnvironmentLighting::FromEquirectangularFile] {} has {} channels, expected colour", _path, channels);
+				stbi_image_free(image.data);
+				return nullptr;
+			}
+
+			// Low dynamic range images are used as they are stored, the same as the GPU conversion samples them
+			std::vector<float> converted;
+			const float* pixels = (const float*)image.data;
+			if (!FileIO::HasExtension(_path, ".hdr")) {
+				converted.resize(count);
+				for (size_t i = 0; i < count; i++)
+					converted[i] = ((const uint8_t*)image.data)[i] / 255.0f;
+				pixels = converted.data();
+			}
+
+			_cubemap = IBLBaker::CubemapFromEquirectangular(pixels, image.width, image.height, channels, _faceSize);
+			stbi_image_free(image.data);
+			return &_cubemap;
+		}
+
+		inline bool WasBaked() const { return _loaded; }
+	private:
+		std::string _path;
+		uint32_t _faceSize;
+		bool _loaded = false;
+		TextureFileData _cubemap;
+	};
+}
+
+std::shared_ptr<EnvironmentLighting> EnvironmentLighting::Utils::FromEquirectangularFile(const std::string& path, const IBLSettings& settings) {
+	std::string sourceSettings = std::to_string(settings.sourceSize) + "|baker=" + std::to_string(IBLBaker::VERSION);
+	std::string shKey = TextureCache::MakeKey(path, "ibl-sh|" + sourceSettings);
+	std::string specularKey = TextureCache::MakeKey(path, "ibl-specular|" + sourceSettings + "|" + std::to_string(settings.specularSize) + "|" +
+		std::to_string(settings.specularLevels) + "|" + std::to_string(settings.specularSamples));
+	if (shKey.empty()) {
+		ENGINE_ERROR("[EnvironmentLighting::FromEquirectangularFile] {} does not exist", path);
+		return nullptr;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto environment = std::make_shared<EnvironmentLighting>();
+	EnvironmentSource source(path, settings.sourceSize);
+
+	// Kept as a 9x1 image so it goes through the same cache as everything else
+	auto cachedSH = TextureCache::Load(shKey);
+	if (cachedSH && cachedSH->GetFormat() == ImageFormat::RGB32F && cachedSH->GetWidth() == 9 && cachedSH->GetSize(0) == sizeof(environment->irradianceSH.coefficients)) {
+		std::memcpy(environment->irradianceSH.coefficients, cachedSH->GetData(0), sizeof(environment->irradianceSH.coefficients));
+	}
+	else {
+		auto cubemap = source.Get();
+		if (!cubemap)
+			return nullptr;
+		environment->irradianceSH = IBLBaker::ProjectSH(*cubemap);
+
+		TextureFileData data;
+		data.format = ImageFormat::RGB32F;
+		data.width = 9;
+		data.height = 1;
+		auto bytes = (const uint8_t*)environment->irradianceSH.coefficients;
+		data.images.emplace_back(bytes, bytes + sizeof(environment->irradianceSH.coefficients));
+		TextureCache::Store(shKey, data);
+	}
+
+	// Cheap enough from the harmonics to not be worth a cache entry
+	environment->irradiance = TextureCubemap::Utils::FromTextureFileData(IBLBaker::RenderIrradiance(environment->irradianceSH, settings.irradianceSize));
+
+	environment->specular = loadOrBake<TextureCubemap>(specularKey, [&]() {
+		auto cubemap = source.Get();
+		return cubemap ? IBLBaker::PrefilterSpecular(*cubemap, settings.specularSize, settings.specularLevels, settings.specularSamples) : TextureFileData();
+	}, &TextureCubemap::Utils::FromTextureFile, &TextureCubemap::Utils::FromTextureFileData);
+	if (!environment->specular)
+		return nullptr;
+
+	// Independent of the environment, shared by all of them, so there is no source file to key it on
+	char brdfKey[32];
+	snprintf(brdfKey, sizeof(brdfKey), "ibl-brdf-%016llx", (unsigned long long)CacheKey::Hash(std::to_string(settings.brdfSize) + "|" +
+		std::to_string(settings.brdfSamples) + "|" + std::to_string(IBLBaker::VERSION)));
+	environment->brdf = loadOrBake<Texture2D>(brdfKey, [&]() {
+		return IBLBaker::IntegrateBRDF(settings.brdfSize, settings.brdfSamples);
+	}, &Texture2D::Utils::FromTextureFile, &Texture2D::Utils::FromTextureFileData);
+
+	SamplerSpec specularSampler = Sampler::Utils::Clamped();
+	specularSampler.mipFilter = MipmapFilter::Linear;
+	environment->specular->SetSampler(specularSampler);
+	if (environment->brdf)
+		environment->brdf->SetSampler(Sampler::Utils::Clamped());
+
+	float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	ENGINE_INFO("[EnvironmentLighting::FromEquirectangularFile] {} ready in {:.1f} ms{}", path, milliseconds, source.WasBaked() ? " (baked)" : "");
+	return environment;
+}
+
+void EnvironmentLighting::ApplyTo(Material& material) const {
+	material.SetTexture("irradianceMap", irradiance);
+	material.SetTexture("prefilterMap", specular);
+	material.SetTexture("brdfLUT", brdf);
+	// Roughness 1 maps to the last level, whatever IBLSettings::specularLevels was
+	material.SetUniform("prefilterMaxLod", specular ? (float)(specular->GetMipLevels() - 1) : 0.0f);
+}
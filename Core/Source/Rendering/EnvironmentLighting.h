@@ -0,0 +1,29 @@
+#pragma once
+#include <memory>
+#include <string>
+
+#include "Rendering/Platform/Texture2D.h"
+#include "Rendering/Platform/TextureCubeMap.h"
+#include "Util/Image/IBLBaker.h"
+
+namespace Engine {
+	class Material;
+
+	// Everything image based lighting samples for one environment: diffuse irradiance, a specular chain
+	// prefiltered for increasing roughness down its levels and the BRDF lookup of the split sum.
+	struct EnvironmentLighting {
+		SphericalHarmonics9 irradianceSH;
+		std::shared_ptr<TextureCubemap> irradiance;
+		std::shared_ptr<TextureCubemap> specular; // Level i is filtered for roughness i / (levels - 1)
+		std::shared_ptr<Texture2D> brdf;
+
+		// Sets irradianceMap, prefilterMap and brdfLUT, and prefilterMaxLod to the last level of the specular chain
+		void ApplyTo(Material& material) const;
+
+		struct Utils {
+			// Bakes on the CPU and keeps the results in the texture cache, later loads of an unchanged
+			// source with the same settings only map the cached files. nullptr if the image cannot be read.
+			static std::shared_ptr<EnvironmentLighting> FromEquirectangularFile(const std::string& path, const IBLSettings& settings = {});
+		};
+	};
+}
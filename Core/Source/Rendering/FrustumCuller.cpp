@@ -0,0 +1,218 @@
+#include "FrustumCuller.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define ENGINE_CULL_SSE
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC emits AVX instructions for the intrinsics regardless of /arch
+#define ENGINE_CULL_AVX
+#define ENGINE_TARGET_AVX
+#elif defined(__GNUC__)
+#define ENGINE_CULL_AVX
+#define ENGINE_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+using namespace Engine;
+
+void FrustumCuller::Clear() {
+	_count = 0;
+}
+
+void FrustumCuller::Reserve(uint32_t count) {
+	uint32_t padded = (count + LANE_PADDING - 1) / LANE_PADDING * LANE_PADDING;
+	if (padded <= _centerX.size())
+		return;
+
+	for (auto* array : { &_centerX, &_centerY, &_centerZ, &_extentX, &_extentY, &_extentZ })
+		array->resize(padded, 0.0f);
+}
+
+uint32_t FrustumCuller::Add(const BoundingBox& worldBounds) {
+	if (_count == _centerX.size())
+		Reserve(_count == 0 ? 256 : _count * 2);
+
+	glm::vec3 center = worldBounds.GetCenter();
+	glm::vec3 extents = worldBounds.GetSize() * 0.5f;
+	_centerX[_count] = center.x;
+	_centerY[_count] = center.y;
+	_centerZ[_count] = center.z;
+	_extentX[_count] = extents.x;
+	_extentY[_count] = extents.y;
+	_extentZ[_count] = extents.z;
+	return _count++;
+}
+
+uint32_t FrustumCuller::Add(const glm::vec3& center, float radius) {
+	return Add(BoundingBox(center - glm::vec3(radius), center + glm::vec3(radius)));
+}
+
+uint32_t FrustumCuller::Cull(const Frustum& frustum, std::vector<uint32_t>& visible, Path path) const {
+	if (!IsPathSupported(path))
+		path = Path::Scalar;
+
+	// Written through a raw pointer, so size for the worst case and trim afterwards
+	visible.resize(_count);
+	uint32_t count = 0;
+	switch (path) {
+	case Path::AVX: count = cullAVX(frustum, visible.data()); break;
+	case Path::SSE: count = cullSSE(frustum, visible.data()); break;
+	default: count = cullScalar(frustum, visible.data()); break;
+	}
+	visible.resize(count);
+	return count;
+}
+
+// An object is outside when its center is further behind a plane than the box reaches along the plane normal
+uint32_t FrustumCuller::cullScalar(const Frustum& frustum, uint32_t* visible) const {
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < _count; i++) {
+		bool inside = true;
+		for (const auto& plane : frustum.planes) {
+			float distance = plane.x * _centerX[i] + plane.y * _centerY[i] + plane.z * _centerZ[i] + plane.w;
+			float reach = std::abs(plane.x) * _extentX[i] + std::abs(plane.y) * _extentY[i] + std::abs(plane.z) * _extentZ[i];
+			if (distance + reach < 0.0f) {
+				inside = false;
+				break;
+			}
+		}
+		visible[count] = i;
+		count += inside ? 1 : 0;
+	}
+	return count;
+}
+
+uint32_t FrustumCuller::cullSSE(const Frustum& frustum, uint32_t* visible) const {
+#ifdef ENGINE_CULL_SSE
+	// Splat every plane component once, the loop then only loads bounds
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; p++) {
+		const glm::vec4& plane = frustum.planes[p];
+		planeX[p] = _mm_set1_ps(plane.x); absX[p] = _mm_set1_ps(std::abs(plane.x));
+		planeY[p] = _mm_set1_ps(plane.y); absY[p] = _mm_set1_ps(std::abs(plane.y));
+		planeZ[p] = _mm_set1_ps(plane.z); absZ[p] = _mm_set1_ps(std::abs(plane.z));
+		planeW[p] = _mm_set1_ps(plane.w);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < _count; i += 4) {
+		__m128 cx = _mm_loadu_ps(&_centerX[i]), cy = _mm_loadu_ps(&_centerY[i]), cz = _mm_loadu_ps(&_centerZ[i]);
+		__m128 ex = _mm_loadu_ps(&_extentX[i]), ey = _mm_loadu_ps(&_extentY[i]), ez = _mm_loadu_ps(&_extentZ[i]);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; p++) {
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)), _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+			__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), zero));
+		}
+
+		uint32_t mask = (uint32_t)_mm_movemask_ps(inside);
+		if (_count - i < 4)
+			mask &= (1u << (_count - i)) - 1;
+
+		for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1) {
+			visible[count] = i + lane;
+			count += mask & 1;
+		}
+	}
+	return count;
+#else
+	return cullScalar(frustum, visible);
+#endif
+}
+
+#ifdef ENGINE_CULL_AVX
+ENGINE_TARGET_AVX static uint32_t CullAVX8(const Frustum& frustum, uint32_t objectCount,
+	const float* centerX, const float* centerY, const float* centerZ,
+	const float* extentX, const float* extentY, const float* extentZ, uint32_t* visible) {
+	__m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; p++) {
+		const glm::vec4& plane = frustum.planes[p];
+		planeX[p] = _mm256_set1_ps(plane.x); absX[p] = _mm256_set1_ps(std::abs(plane.x));
+		planeY[p] = _mm256_set1_ps(plane.y); absY[p] = _mm256_set1_ps(std::abs(plane.y));
+		planeZ[p] = _mm256_set1_ps(plane.z); absZ[p] = _mm256_set1_ps(std::abs(plane.z));
+		planeW[p] = _mm256_set1_ps(plane.w);
+	}
+
+	const __m256 zero = _mm256_setzero_ps();
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < objectCount; i += 8) {
+		__m256 cx = _mm256_loadu_ps(centerX + i), cy = _mm256_loadu_ps(centerY + i), cz = _mm256_loadu_ps(centerZ + i);
+		__m256 ex = _mm256_loadu_ps(extentX + i), ey = _mm256_loadu_ps(extentY + i), ez = _mm256_loadu_ps(extentZ + i);
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p = 0; p < 6; p++) {
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], cx), _mm256_mul_ps(planeY[p], cy)), _mm256_add_ps(_mm256_mul_ps(planeZ[p], cz), planeW[p]));
+			__m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[p], ex), _mm256_mul_ps(absY[p], ey)), _mm256_mul_ps(absZ[p], ez));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_GE_OQ));
+		}
+
+		uint32_t mask = (uint32_t)_mm256_movemask_ps(inside);
+		if (objectCount - i < 8)
+			mask &= (1u << (objectCount - i)) - 1;
+
+		for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1) {
+			visible[count] = i + lane;
+			count += mask & 1;
+		}
+	}
+	return count;
+}
+#endif
+
+uint32_t FrustumCuller::cullAVX(const Frustum& frustum, uint32_t* visible) const {
+#ifdef ENGINE_CULL_AVX
+	return CullAVX8(frustum, _count, _centerX.data(), _centerY.data(), _centerZ.data(),
+		_extentX.data(), _extentY.data(), _extentZ.data(), visible);
+#else
+	return cullSSE(frustum, visible);
+#endif
+}
+
+static bool CpuSupportsAVX() {
+#if defined(ENGINE_CULL_AVX) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	bool osSavesYmm = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	// The OS must also preserve the upper halves of the registers on context switches
+	return osSavesYmm && avx && (_xgetbv(0) & 0x6) == 0x6;
+#elif defined(ENGINE_CULL_AVX)
+	return __builtin_cpu_supports("avx");
+#else
+	return false;
+#endif
+}
+
+bool FrustumCuller::IsPathSupported(Path path) {
+	static const bool avx = CpuSupportsAVX();
+	switch (path) {
+	case Path::Scalar: return true;
+#ifdef ENGINE_CULL_SSE
+	case Path::SSE: return true;
+#endif
+	case Path::AVX: return avx;
+	}
+	return false;
+}
+
+FrustumCuller::Path FrustumCuller::GetBestPath() {
+	if (IsPathSupported(Path::AVX))
+		return Path::AVX;
+	if (IsPathSupported(Path::SSE))
+		return Path::SSE;
+	return Path::Scalar;
+}
+
+const char* FrustumCuller::GetPathName(Path path) {
+	switch (path) {
+	case Path::Scalar: return "Scalar";
+	case Path::SSE: return "SSE";
+	case Path::AVX: return "AVX";
+	}
+	return "Unknown";
+}
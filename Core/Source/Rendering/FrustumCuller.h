@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Util/Math/Frustum.h"
+#include "Util/Math/BoundingBox.h"
+
+namespace Engine {
+	// Tests many world space bounds against a frustum at once. Bounds are kept as separate center and
+	// extent arrays so that 4 (SSE) or 8 (AVX) objects are tested per plane with a single set of instructions.
+	// The result is a compact list of the indices returned by Add, in ascending order.
+	class FrustumCuller {
+	public:
+		enum class Path { Scalar = 0, SSE, AVX };
+
+		void Clear();
+		void Reserve(uint32_t count);
+
+		// Returns the index the object will be reported with
+		uint32_t Add(const BoundingBox& worldBounds);
+		// Spheres are tested as the box around them, so they are kept slightly more often than needed
+		uint32_t Add(const glm::vec3& center, float radius);
+
+		// Overwrites the visible list, returns the number of visible objects
+		uint32_t Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const { return Cull(frustum, visible, GetBestPath()); }
+		uint32_t Cull(const Frustum& frustum, std::vector<uint32_t>& visible, Path path) const;
+
+		inline uint32_t GetCount() const { return _count; }
+
+		// Widest path compiled in and supported by the running CPU
+		static Path GetBestPath();
+		static bool IsPathSupported(Path path);
+		static const char* GetPathName(Path path);
+	private:
+		uint32_t cullScalar(const Frustum& frustum, uint32_t* visible) const;
+		uint32_t cullSSE(const Frustum& frustum, uint32_t* visible) const;
+		uint32_t cullAVX(const Frustum& frustum, uint32_t* visible) const;
+	private:
+		// Arrays are padded to a multiple of 8 so the wide paths never read past the end
+		static const uint32_t LANE_PADDING = 8;
+
+		uint32_t _count = 0;
+		std::vector<float> _centerX, _centerY, _centerZ;
+		std::vector<float> _extentX, _extentY, _extentZ;
+	};
+}
@@ -0,0 +1,90 @@
+#include "GLExtensions.h"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Logging/Logging.h"
+
+using namespace Engine;
+
+typedef void (APIENTRYP PFN_MultiDrawElementsIndirect)(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride);
+typedef void (APIENTRYP PFN_DrawElementsInstancedBaseVertexBaseInstance)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount, GLint baseVertex, GLuint baseInstance);
+typedef void (APIENTRYP PFN_BufferStorage)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFN_TexStorage2D)(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height);
+
+int GLExtensions::_majorVersion = 0;
+int GLExtensions::_minorVersion = 0;
+std::unordered_set<std::string> GLExtensions::_extensions;
+
+void* GLExtensions::_multiDrawElementsIndirect = nullptr;
+void* GLExtensions::_drawElementsInstancedBaseVertexBaseInstance = nullptr;
+void* GLExtensions::_bufferStorage = nullptr;
+void* GLExtensions::_texStorage2D = nullptr;
+float GLExtensions::_maxAnisotropy = 1.0f;
+bool GLExtensions::_s3tc = false;
+bool GLExtensions::_bptc = false;
+
+void GLExtensions::Load() {
+	glGetIntegerv(GL_MAJOR_VERSION, &_majorVersion);
+	glGetIntegerv(GL_MINOR_VERSION, &_minorVersion);
+
+	_extensions.clear();
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (GLint i = 0; i < extensionCount; i++)
+		_extensions.insert((const char*)glGetStringi(GL_EXTENSIONS, i));
+
+	_multiDrawElementsIndirect = nullptr;
+	if (HasVersion(4, 3) || HasExtension("GL_ARB_multi_draw_indirect"))
+		_multiDrawElementsIndirect = getProc("glMultiDrawElementsIndirect");
+
+	_drawElementsInstancedBaseVertexBaseInstance = nullptr;
+	if (HasVersion(4, 2) || HasExtension("GL_ARB_base_instance"))
+		_drawElementsInstancedBaseVertexBaseInstance = getProc("glDrawElementsInstancedBaseVertexBaseInstance");
+
+	_bufferStorage = nullptr;
+	if (HasVersion(4, 4) || HasExtension("GL_ARB_buffer_storage"))
+		_bufferStorage = getProc("glBufferStorage");
+
+	_texStorage2D = nullptr;
+	if (HasVersion(4, 2) || HasExtension("GL_ARB_texture_storage"))
+		_texStorage2D = getProc("glTexStorage2D");
+
+	_maxAnisotropy = 1.0f;
+	if (HasVersion(4, 6) || HasExtension("GL_ARB_texture_filter_anisotropic") || HasExtension("GL_EXT_texture_filter_anisotropic"))
+		glGetFloatv(MAX_TEXTURE_MAX_ANISOTROPY, &_maxAnisotropy);
+
+	_s3tc = HasExtension("GL_EXT_texture_compression_s3tc");
+	_bptc = HasVersion(4, 2) || HasExtension("GL_ARB_texture_compression_bptc");
+
+	ENGINE_INFO("[GLExtensions::Load] OpenGL {}.{}, {} extensions, multi draw indirect: {}, base instance: {}, buffer storage: {}, texture storage: {}, max anisotropy: {}, s3tc: {}, bptc: {}",
+		_majorVersion, _minorVersion, extensionCount, HasMultiDrawIndirect(), HasBaseInstance(), HasBufferStorage(), HasTextureStorage(), _maxAnisotropy, _s3tc, _bptc);
+}
+
+bool GLExtensions::HasExtension(const std::string& name) {
+	return _extensions.find(name) != _extensions.end();
+}
+
+bool GLExtensions::HasVersion(int major, int minor) {
+	return _majorVersion > major || (_majorVersion == major && _minorVersion >= minor);
+}
+
+void GLExtensions::MultiDrawElementsIndirect(uint32_t mode, uint32_t type, const void* indirect, int drawCount, int stride) {
+	((PFN_MultiDrawElementsIndirect)_multiDrawElementsIndirect)(mode, type, indirect, drawCount, stride);
+}
+
+void GLExtensions::DrawElementsInstancedBaseVertexBaseInstance(uint32_t mode, int count, uint32_t type, const void* indices, int instanceCount, int baseVertex, uint32_t baseInstance) {
+	((PFN_DrawElementsInstancedBaseVertexBaseInstance)_drawElementsInstancedBaseVertexBaseInstance)(mode, count, type, indices, instanceCount, baseVertex, baseInstance);
+}
+
+void GLExtensions::BufferStorage(uint32_t target, uint64_t size, const void* data, uint32_t flags) {
+	((PFN_BufferStorage)_bufferStorage)(target, (GLsizeiptr)size, data, flags);
+}
+
+void GLExtensions::TexStorage2D(uint32_t target, int levels, uint32_t internalFormat, int width, int height) {
+	((PFN_TexStorage2D)_texStorage2D)(target, levels, internalFormat, width, height);
+}
+
+void* GLExtensions::getProc(const char* name) {
+	return (void*)glfwGetProcAddress(name);
+}
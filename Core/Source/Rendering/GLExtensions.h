@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+namespace Engine {
+	// The loader is generated for a 3.3 core context, so anything newer is picked up here at runtime.
+	// Every entry point must be checked with its Has* function before being called.
+	class GLExtensions {
+	public:
+		static constexpr uint32_t DRAW_INDIRECT_BUFFER = 0x8F3F;
+		static constexpr uint32_t MAP_PERSISTENT_BIT = 0x0040;
+		static constexpr uint32_t MAP_COHERENT_BIT = 0x0080;
+		static constexpr uint32_t TEXTURE_MAX_ANISOTROPY = 0x84FE;
+		static constexpr uint32_t MAX_TEXTURE_MAX_ANISOTROPY = 0x84FF;
+		static constexpr uint32_t COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+		static constexpr uint32_t COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+		static constexpr uint32_t COMPRESSED_RGBA_BPTC_UNORM = 0x8E8C;
+
+		static void Load();
+
+		static bool HasExtension(const std::string& name);
+		static bool HasVersion(int major, int minor);
+		inline static int GetMajorVersion() { return _majorVersion; }
+		inline static int GetMinorVersion() { return _minorVersion; }
+
+		// GL 4.3 / ARB_multi_draw_indirect
+		inline static bool HasMultiDrawIndirect() { return _multiDrawElementsIndirect != nullptr; }
+		static void MultiDrawElementsIndirect(uint32_t mode, uint32_t type, const void* indirect, int drawCount, int stride);
+
+		// GL 4.2 / ARB_base_instance
+		inline static bool HasBaseInstance() { return _drawElementsInstancedBaseVertexBaseInstance != nullptr; }
+		static void DrawElementsInstancedBaseVertexBaseInstance(uint32_t mode, int count, uint32_t type, const void* indices, int instanceCount, int baseVertex, uint32_t baseInstance);
+
+		// GL 4.4 / ARB_buffer_storage
+		inline static bool HasBufferStorage() { return _bufferStorage != nullptr; }
+		static void BufferStorage(uint32_t target, uint64_t size, const void* data, uint32_t flags);
+
+		// GL 4.2 / ARB_texture_storage
+		inline static bool HasTextureStorage() { return _texStorage2D != nullptr; }
+		static void TexStorage2D(uint32_t target, int levels, uint32_t internalFormat, int width, int height);
+
+		// GL 4.6 / ARB_texture_filter_anisotropic / EXT_texture_filter_anisotropic, only a constant so nothing is loaded
+		inline static bool HasAnisotropicFiltering() { return _maxAnisotropy > 1.0f; }
+		inline static float GetMaxAnisotropy() { return _maxAnisotropy; }
+
+		// EXT_texture_compression_s3tc (BC1-BC3), RGTC (BC4, BC5) is core
+		inline static bool HasS3TC() { return _s3tc; }
+		// GL 4.2 / ARB_texture_compression_bptc (BC6H, BC7)
+		inline static bool HasBPTC() { return _bptc; }
+	private:
+		static void* getProc(const char* name);
+	private:
+		static int _majorVersion;
+		static int _minorVersion;
+		static std::unordered_set<std::string> _extensions;
+
+		// Stored untyped, the typed pointers need the GL calling convention from glad.h
+		static void* _multiDrawElementsIndirect;
+		static void* _drawElementsInstancedBaseVertexBaseInstance;
+		static void* _bufferStorage;
+		static void* _texStorage2D;
+		static float _maxAnisotropy;
+		static bool _s3tc;
+		static bool _bptc;
+	};
+}
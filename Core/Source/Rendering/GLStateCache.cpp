@@ -0,0 +1,227 @@
+#include "GLStateCache.h"
+
+#include <glad/glad.h>
+
+using namespace Engine;
+
+uint32_t GLStateCache::_program = GLStateCache::UNKNOWN;
+uint32_t GLStateCache::_vertexArray = GLStateCache::UNKNOWN;
+uint32_t GLStateCache::_activeTextureUnit = GLStateCache::UNKNOWN;
+uint32_t GLStateCache::_textures[GLStateCache::MAX_TEXTURE_UNITS][GLStateCache::SlotCount];
+uint32_t GLStateCache::_samplers[GLStateCache::MAX_TEXTURE_UNITS];
+GLStateCache::UniformBufferBinding GLStateCache::_uniformBuffers[GLStateCache::MAX_UNIFORM_BUFFER_BINDINGS];
+
+GLStateCache::TriState GLStateCache::_depthTest = GLStateCache::TriState::Unknown;
+GLStateCache::TriState GLStateCache::_depthMask = GLStateCache::TriState::Unknown;
+GLStateCache::TriState GLStateCache::_blend = GLStateCache::TriState::Unknown;
+GLStateCache::TriState GLStateCache::_cullFace = GLStateCache::TriState::Unknown;
+uint32_t GLStateCache::_srcBlend = GLStateCache::UNKNOWN;
+uint32_t GLStateCache::_dstBlend = GLStateCache::UNKNOWN;
+uint32_t GLStateCache::_cullMode = GLStateCache::UNKNOWN;
+
+GLStateStats GLStateCache::_stats{};
+GLStateStats GLStateCache::_lastFrameStats{};
+uint64_t GLStateCache::_frameIndex = 0;
+
+static bool GetTextureSlot(uint32_t target, uint32_t& slot) {
+	switch (target) {
+	case GL_TEXTURE_2D: slot = 0; return true;
+	case GL_TEXTURE_CUBE_MAP: slot = 1; return true;
+	}
+	return false;
+}
+
+bool GLStateCache::filter(bool redundant) {
+	if (redundant)
+		_stats.skipped++;
+	else
+		_stats.issued++;
+	return redundant;
+}
+
+void GLStateCache::UseProgram(uint32_t program) {
+	if (filter(_program == program)) return;
+	_program = program;
+	glUseProgram(program);
+}
+
+void GLStateCache::BindVertexArray(uint32_t vertexArray) {
+	if (filter(_vertexArray == vertexArray)) return;
+	_vertexArray = vertexArray;
+	glBindVertexArray(vertexArray);
+}
+
+void GLStateCache::BindTexture(uint32_t unit, uint32_t target, uint32_t texture) {
+	if (!filter(_activeTextureUnit == unit)) {
+		_activeTextureUnit = unit;
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+	BindTexture(target, texture);
+}
+
+void GLStateCache::BindTexture(uint32_t target, uint32_t texture) {
+	uint32_t slot;
+	if (_activeTextureUnit >= MAX_TEXTURE_UNITS || !GetTextureSlot(target, slot)) {
+		// Untracked unit or target, always issue
+		_stats.issued++;
+		glBindTexture(target, texture);
+		return;
+	}
+
+	uint32_t& bound = _textures[_activeTextureUnit][slot];
+	if (filter(bound == texture)) return;
+	bound = texture;
+	glBindTexture(target, texture);
+}
+
+void GLStateCache::BindSampler(uint32_t unit, uint32_t sampler) {
+	if (unit >= MAX_TEXTURE_UNITS) {
+		_stats.issued++;
+		glBindSampler(unit, sampler);
+		return;
+	}
+
+	// Sampler bindings are per unit, the active unit does not matter
+	if (filter(_samplers[unit] == sampler)) return;
+	_samplers[unit] = sampler;
+	glBindSampler(unit, sampler);
+}
+
+void GLStateCache::BindUniformBufferBase(uint32_t bindingPoint, uint32_t buffer) {
+	if (bindingPoint >= MAX_UNIFORM_BUFFER_BINDINGS) {
+		_stats.issued++;
+		glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, buffer);
+		return;
+	}
+
+	// A whole buffer binding is stored with a zero size
+	UniformBufferBinding& bound = _uniformBuffers[bindingPoint];
+	if (filter(bound.buffer == buffer && bound.offset == 0 && bound.size == 0)) return;
+	bound = { buffer, 0, 0 };
+	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, buffer);
+}
+
+void GLStateCache::BindUniformBufferRange(uint32_t bindingPoint, uint32_t buffer, uint64_t offset, uint64_t size) {
+	if (bindingPoint >= MAX_UNIFORM_BUFFER_BINDINGS) {
+		_stats.issued++;
+		glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, buffer, (GLintptr)offset, (GLsizeiptr)size);
+		return;
+	}
+
+	UniformBufferBinding& bound = _uniformBuffers[bindingPoint];
+	if (filter(bound.buffer == buffer && bound.offset == offset && bound.size == size)) return;
+	bound = { buffer, offset, size };
+	glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, buffer, (GLintptr)offset, (GLsizeiptr)size);
+}
+
+#define SET_CAPABILITY(cached, capability, enabled) { \
+	TriState state = toTriState(enabled); \
+	if (filter(cached == state)) return; \
+	cached = state; \
+	if (enabled) glEnable(capability); else glDisable(capability); }
+
+void GLStateCache::SetDepthTest(bool enabled) {
+	SET_CAPABILITY(_depthTest, GL_DEPTH_TEST, enabled);
+}
+
+void GLStateCache::SetBlend(bool enabled) {
+	SET_CAPABILITY(_blend, GL_BLEND, enabled);
+}
+
+void GLStateCache::SetCullFace(bool enabled) {
+	SET_CAPABILITY(_cullFace, GL_CULL_FACE, enabled);
+}
+
+void GLStateCache::SetDepthMask(bool enabled) {
+	TriState state = toTriState(enabled);
+	if (filter(_depthMask == state)) return;
+	_depthMask = state;
+	glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::SetBlendFunc(BlendFactor src, BlendFactor dst) {
+	if (filter(_srcBlend == (uint32_t)src && _dstBlend == (uint32_t)dst)) return;
+	_srcBlend = (uint32_t)src;
+	_dstBlend = (uint32_t)dst;
+	glBlendFunc((GLenum)src, (GLenum)dst);
+}
+
+void GLStateCache::SetCullMode(bool cullFront, bool cullBack) {
+	uint32_t mode;
+	if (cullFront && cullBack)
+		mode = GL_FRONT_AND_BACK;
+	else if (cullFront)
+		mode = GL_FRONT;
+	else if (cullBack)
+		mode = GL_BACK;
+	else
+		return;
+
+	if (filter(_cullMode == mode)) return;
+	_cullMode = mode;
+	glCullFace(mode);
+}
+
+void GLStateCache::ApplyContext(const GraphicsContext& context) {
+	SetDepthTest(context.EnableDepthTest);
+	SetBlend(context.EnableBlend);
+	SetBlendFunc(context.SrcBlendFactor, context.DstBlendFactor);
+	SetCullFace(context.EnableCullFace);
+	SetCullMode(context.CullFront, context.CullBack);
+}
+
+void GLStateCache::Invalidate() {
+	_program = UNKNOWN;
+	_vertexArray = UNKNOWN;
+	_activeTextureUnit = UNKNOWN;
+
+	for (auto& unit : _textures)
+		for (auto& texture : unit)
+			texture = UNKNOWN;
+
+	for (auto& sampler : _samplers)
+		sampler = UNKNOWN;
+
+	for (auto& binding : _uniformBuffers)
+		binding = { UNKNOWN, 0, 0 };
+
+	_depthTest = _depthMask = _blend = _cullFace = TriState::Unknown;
+	_srcBlend = _dstBlend = UNKNOWN;
+	_cullMode = UNKNOWN;
+}
+
+void GLStateCache::OnProgramDeleted(uint32_t program) {
+	if (_program == program)
+		_program = UNKNOWN;
+}
+
+void GLStateCache::OnVertexArrayDeleted(uint32_t vertexArray) {
+	if (_vertexArray == vertexArray)
+		_vertexArray = UNKNOWN;
+}
+
+void GLStateCache::OnTextureDeleted(uint32_t texture) {
+	for (auto& unit : _textures)
+		for (auto& bound : unit)
+			if (bound == texture)
+				bound = UNKNOWN;
+}
+
+void GLStateCache::OnSamplerDeleted(uint32_t sampler) {
+	for (auto& bound : _samplers)
+		if (bound == sampler)
+			bound = UNKNOWN;
+}
+
+void GLStateCache::OnBufferDeleted(uint32_t buffer) {
+	for (auto& binding : _uniformBuffers)
+		if (binding.buffer == buffer)
+			binding = { UNKNOWN, 0, 0 };
+}
+
+void GLStateCache::NewFrame() {
+	_lastFrameStats = _stats;
+	_stats = {};
+	_frameIndex++;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+
+#include "GraphicsContext.h"
+
+namespace Engine {
+	struct GLStateStats {
+		uint64_t issued = 0;
+		uint64_t skipped = 0;
+	};
+
+	// Shadows the bound GL objects and fixed function state so that redundant calls are filtered out.
+	// Everything in the engine that changes tracked state must go through here, external code
+	// that touches GL directly (eg. ImGui) must be followed by Invalidate().
+	class GLStateCache {
+	public:
+		static const uint32_t MAX_TEXTURE_UNITS = 32;
+		static const uint32_t MAX_UNIFORM_BUFFER_BINDINGS = 36;
+
+		static void UseProgram(uint32_t program);
+		static void BindVertexArray(uint32_t vertexArray);
+
+		// Binds to the given unit, making it the active unit
+		static void BindTexture(uint32_t unit, uint32_t target, uint32_t texture);
+		// Binds to the currently active unit, used when editing a texture
+		static void BindTexture(uint32_t target, uint32_t texture);
+		static void BindSampler(uint32_t unit, uint32_t sampler);
+
+		static void BindUniformBufferBase(uint32_t bindingPoint, uint32_t buffer);
+		static void BindUniformBufferRange(uint32_t bindingPoint, uint32_t buffer, uint64_t offset, uint64_t size);
+
+		static void SetDepthTest(bool enabled);
+		static void SetDepthMask(bool enabled);
+		static void SetBlend(bool enabled);
+		static void SetBlendFunc(BlendFactor src, BlendFactor dst);
+		static void SetCullFace(bool enabled);
+		static void SetCullMode(bool cullFront, bool cullBack);
+
+		static void ApplyContext(const GraphicsContext& context);
+
+		// Forget everything, the next request for any state is always issued
+		static void Invalidate();
+
+		// Deleted names can be recycled by the driver, so they must not be remembered as bound
+		static void OnProgramDeleted(uint32_t program);
+		static void OnVertexArrayDeleted(uint32_t vertexArray);
+		static void OnTextureDeleted(uint32_t texture);
+		static void OnSamplerDeleted(uint32_t sampler);
+		static void OnBufferDeleted(uint32_t buffer);
+
+		// Moves the running counters into the last frame stats
+		static void NewFrame();
+		// Frames started so far, for anything that needs to know when it was last used
+		static uint64_t GetFrameIndex() { return _frameIndex; }
+		static const GLStateStats& GetStats() { return _stats; }
+		static const GLStateStats& GetLastFrameStats() { return _lastFrameStats; }
+	private:
+		static bool filter(bool redundant);
+	private:
+		static constexpr uint32_t UNKNOWN = 0xFFFFFFFF;
+
+		enum class TriState : uint8_t { Unknown, Off, On };
+		enum TextureSlot : uint32_t { Slot2D = 0, SlotCube, SlotCount };
+
+		struct UniformBufferBinding { uint32_t buffer; uint64_t offset; uint64_t size; };
+
+		static TriState toTriState(bool enabled) { return enabled ? TriState::On : TriState::Off; }
+
+		static uint32_t _program;
+		static uint32_t _vertexArray;
+		static uint32_t _activeTextureUnit;
+		static uint32_t _textures[MAX_TEXTURE_UNITS][SlotCount];
+		static uint32_t _samplers[MAX_TEXTURE_UNITS];
+		static UniformBufferBinding _uniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS];
+
+		static TriState _depthTest, _depthMask, _blend, _cullFace;
+		static uint32_t _srcBlend, _dstBlend;
+		static uint32_t _cullMode;
+
+		static GLStateStats _stats;
+		static GLStateStats _lastFrameStats;
+		static uint64_t _frameIndex;
+	};
+}
@@ -0,0 +1,221 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+#include <glad/glad.h>
+
+#include "Logging/Logging.h"
+
+using namespace Engine;
+
+bool RangeAllocator::Allocate(uint32_t count, uint32_t& offset) {
+	for (auto it = _freeRanges.begin(); it != _freeRanges.end(); it++) {
+		if (it->second < count)
+			continue;
+
+		offset = it->first;
+		uint32_t remaining = it->second - count;
+		_freeRanges.erase(it);
+		if (remaining > 0)
+			_freeRanges[offset + count] = remaining;
+		return true;
+	}
+	return false;
+}
+
+void RangeAllocator::Free(uint32_t offset, uint32_t count) {
+	auto it = _freeRanges.emplace(offset, count).first;
+
+	// Merge with the following range
+	auto next = std::next(it);
+	if (next != _freeRanges.end() && it->first + it->second == next->first) {
+		it->second += next->second;
+		_freeRanges.erase(next);
+	}
+
+	// Merge with the preceding range
+	if (it != _freeRanges.begin()) {
+		auto prev = std::prev(it);
+		if (prev->first + prev->second == it->first) {
+			prev->second += it->second;
+			_freeRanges.erase(it);
+		}
+	}
+}
+
+const GeometryAllocation& GeometryPool::Acquire(VertexArrayObject& source) {
+	auto it = _entries.find(source.GetUniqueId());
+	if (it != _entries.end())
+		return it->second.allocation;
+
+	if (!Utils::CanPool(source))
+		return _invalid;
+
+	uint32_t vertexCount = source.GetVertexCount();
+	uint32_t indexCount = source.GetIndexCount();
+	std::string layoutKey = Utils::GetLayoutKey(source);
+
+	uint32_t vertexOffset = 0, indexOffset = 0;
+	int32_t pageIndex = findPage(layoutKey, vertexCount, indexCount, vertexOffset, indexOffset);
+	if (pageIndex < 0) {
+		createPage(source, layoutKey, vertexCount, indexCount);
+		pageIndex = findPage(layoutKey, vertexCount, indexCount, vertexOffset, indexOffset);
+	}
+
+	const std::shared_ptr<Page>& page = _pages[pageIndex];
+
+	// Copy every stream and the indices on the GPU, indices stay relative to the mesh and are offset by the base vertex
+	for (uint32_t i = 0; i < source.GetVertexBufferCount(); i++) {
+		const auto& src = source.GetVertexBuffer(i);
+		uint32_t stride = src.GetLayout().GetStride();
+		Utils::CopyBuffer(src.GetHandle(), page->vertexArray->GetVertexBuffer(i).GetHandle(),
+			0, (uint64_t)vertexOffset * stride, (uint64_t)vertexCount * stride);
+		page->vertexBytes += (uint64_t)vertexCount * stride;
+	}
+
+	const auto& srcIndices = source.GetIndexBuffer();
+	uint64_t indexSize = GetLTypeSize(srcIndices.GetType());
+	Utils::CopyBuffer(srcIndices.GetHandle(), page->vertexArray->GetIndexBuffer().GetHandle(),
+		0, indexOffset * indexSize, indexCount * indexSize);
+
+	auto lease = std::make_shared<Lease>();
+	lease->page = page;
+	lease->allocation.vertexArray = page->vertexArray.get();
+	lease->allocation.page = (uint32_t)pageIndex;
+	lease->allocation.baseVertex = (int32_t)vertexOffset;
+	lease->allocation.vertexCount = vertexCount;
+	lease->allocation.firstIndex = indexOffset;
+	lease->allocation.indexCount = indexCount;
+	page->allocations++;
+
+	// From here on the mesh draws from the page as well, its own buffers are released
+	source.MoveToSharedBuffers(page->vertexBuffers, page->indexBuffer, vertexOffset, indexOffset, lease);
+
+	Entry entry;
+	entry.allocation = lease->allocation;
+	entry.lease = lease;
+	return _entries.emplace(source.GetUniqueId(), entry).first->second.allocation;
+}
+
+void GeometryPool::NewFrame() {
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		if (it->second.lease.expired())
+			it = _entries.erase(it);
+		else
+			it++;
+	}
+}
+
+const GeometryPoolStats& GeometryPool::GetStats() {
+	_stats = {};
+	_stats.pages = (uint32_t)_pages.size();
+	for (const auto& page : _pages) {
+		_stats.allocations += page->allocations;
+		_stats.vertexBytes += page->vertexBytes;
+	}
+	return _stats;
+}
+
+int32_t GeometryPool::findPage(const std::string& layoutKey, uint32_t vertexCount, uint32_t indexCount, uint32_t& vertexOffset, uint32_t& indexOffset) {
+	for (uint32_t i = 0; i < (uint32_t)_pages.size(); i++) {
+		Page& page = *_pages[i];
+		if (page.layoutKey != layoutKey)
+			continue;
+
+		if (!page.vertices.Allocate(vertexCount, vertexOffset))
+			continue;
+
+		if (!page.indices.Allocate(indexCount, indexOffset)) {
+			page.vertices.Free(vertexOffset, vertexCount);
+			continue;
+		}
+
+		return (int32_t)i;
+	}
+	return -1;
+}
+
+void GeometryPool::createPage(const VertexArrayObject& source, const std::string& layoutKey, uint32_t vertexCount, uint32_t indexCount) {
+	// Meshes bigger than a page get a page of their own
+	uint32_t pageVertices = std::max(_pageVertices, vertexCount);
+	uint32_t pageIndices = std::max(_pageIndices, indexCount);
+
+	auto page = std::make_shared<Page>();
+	page->layoutKey = layoutKey;
+	page->vertices = RangeAllocator(pageVertices);
+	page->indices = RangeAllocator(pageIndices);
+	page->vertexArray = std::make_shared<VertexArrayObject>();
+
+	for (uint32_t i = 0; i < source.GetVertexBufferCount(); i++) {
+		auto vbo = std::make_shared<VertexBufferObject>(BufferUsage::Static);
+		vbo->Allocate(pageVertices, source.GetVertexBuffer(i).GetLayout());
+		page->vertexArray->AddVertexBuffer(vbo);
+		page->vertexBuffers.push_back(vbo);
+	}
+
+	page->indexBuffer = std::make_shared<IndexBufferObject>(BufferUsage::Static);
+	page->indexBuffer->Allocate(source.GetIndexBuffer().GetType(), pageIndices);
+	page->vertexArray->SetIndexBuffer(page->indexBuffer);
+
+	page->vertexArray->Compute();
+	page->vertexArray->SetDrawMode(source.GetDrawMode());
+
+	// Position decoding stays with each mesh's own model matrix, only the shader switch belongs to the page
+	VertexDecoding decoding;
+	decoding.octahedralNormals = source.GetVertexDecoding().octahedralNormals;
+	page->vertexArray->SetVertexDecoding(decoding);
+
+	_pages.push_back(std::move(page));
+}
+
+void GeometryPool::Page::Free(const GeometryAllocation& allocation) {
+	vertices.Free((uint32_t)allocation.baseVertex, allocation.vertexCount);
+	indices.Free(allocation.firstIndex, allocation.indexCount);
+
+	for (uint32_t i = 0; i < vertexArray->GetVertexBufferCount(); i++)
+		vertexBytes -= (uint64_t)allocation.vertexCount * vertexArray->GetVertexBuffer(i).GetLayout().GetStride();
+	allocations--;
+}
+
+GeometryPool::Lease::~Lease() {
+	if (auto owner = page.lock())
+		owner->Free(allocation);
+}
+
+bool GeometryPool::Utils::CanPool(const VertexArrayObject& source) {
+	// Already in a pool, or read back often enough to want its data on the CPU, which shared buffers cannot give
+	if (!source.HasIndices() || source.GetVertexBufferCount() == 0 || source.HasSharedBuffers() || source.GetIndexBuffer().HasShadowCopy())
+		return false;
+	for (uint32_t i = 0; i < source.GetVertexBufferCount(); i++) {
+		if (source.GetVertexBuffer(i).HasShadowCopy())
+			return false;
+	}
+
+	// Every stream must hold the same number of vertices for a single base vertex to work
+	uint32_t vertexCount = source.GetVertexBuffer(0).GetCount();
+	for (uint32_t i = 1; i < source.GetVertexBufferCount(); i++) {
+		if (source.GetVertexBuffer(i).GetCount() != vertexCount)
+			return false;
+	}
+
+	return vertexCount > 0 && source.GetIndexBuffer().GetCount() > 0;
+}
+
+std::string GeometryPool::Utils::GetLayoutKey(const VertexArrayObject& source) {
+	// Meshes can only share a page if streams, index type, draw mode and normal encoding all match
+	std::string key = std::to_string((uint32_t)source.GetDrawMode()) + ":" + std::to_string((uint32_t)source.GetIndexBuffer().GetType())
+		+ (source.GetVertexDecoding().octahedralNormals ? ":oct" : "");
+	for (uint32_t i = 0; i < source.GetVertexBufferCount(); i++) {
+		key += "|";
+		for (const auto& component : source.GetVertexBuffer(i).GetLayout().GetComponents())
+			key += std::to_string((uint32_t)component.Type) + "x" + std::to_string(component.Count) + "/" + std::to_string(component.Divisor) + (component.Normalized ? "n" : "") + ",";
+	}
+	return key;
+}
+
+void GeometryPool::Utils::CopyBuffer(uint32_t src, uint32_t dst, uint64_t srcOffset, uint64_t dstOffset, uint64_t size) {
+	glBindBuffer(GL_COPY_READ_BUFFER, src);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, dst);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)srcOffset, (GLintptr)dstOffset, (GLsizeiptr)size);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
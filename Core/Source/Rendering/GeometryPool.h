@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+#include "Rendering/Platform/Buffer/VertexArrayObject.h"
+
+namespace Engine {
+	// Where a mesh lives inside a pool page, drawn with glDrawElementsBaseVertex style offsets
+	struct GeometryAllocation {
+		VertexArrayObject* vertexArray = nullptr;
+		uint32_t page = 0;
+		int32_t baseVertex = 0;
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+
+		inline bool IsValid() const { return vertexArray != nullptr; }
+	};
+
+	struct GeometryPoolStats {
+		uint32_t pages = 0;
+		uint32_t allocations = 0;
+		uint64_t vertexBytes = 0;
+	};
+
+	// First fit allocator over [0, size), freed ranges are merged with their neighbours
+	class RangeAllocator {
+	public:
+		RangeAllocator(uint32_t size = 0) { if (size > 0) _freeRanges[0] = size; }
+
+		bool Allocate(uint32_t count, uint32_t& offset);
+		void Free(uint32_t offset, uint32_t count);
+	private:
+		std::map<uint32_t, uint32_t> _freeRanges; // offset -> count
+	};
+
+	// Moves the vertices and indices of indexed meshes into a few large buffers, one page per distinct vertex
+	// layout, so that every mesh in a page can be drawn without switching VAOs. A mesh is copied on the GPU the
+	// first time it is acquired and then draws from its page too (see VertexArrayObject::MoveToSharedBuffers),
+	// its own buffers are freed so the data is only held once. Its range is freed when the mesh is destroyed,
+	// pages are created on demand.
+	class GeometryPool {
+	public:
+		static const uint32_t DEFAULT_PAGE_VERTICES = 1 << 18;
+		static const uint32_t DEFAULT_PAGE_INDICES = 1 << 20;
+
+		GeometryPool(uint32_t pageVertices = DEFAULT_PAGE_VERTICES, uint32_t pageIndices = DEFAULT_PAGE_INDICES)
+			: _pageVertices(pageVertices), _pageIndices(pageIndices) {}
+
+		// Returns where the vertex array lives in the pool, an invalid allocation if it cannot be pooled
+		const GeometryAllocation& Acquire(VertexArrayObject& source);
+
+		// Forgets meshes that have been destroyed since the last call
+		void NewFrame();
+
+		const GeometryPoolStats& GetStats();
+	private:
+		struct Page {
+			std::string layoutKey;
+			std::shared_ptr<VertexArrayObject> vertexArray;
+			// The page's buffers, which pooled meshes share
+			std::vector<std::shared_ptr<VertexBufferObject>> vertexBuffers;
+			std::shared_ptr<IndexBufferObject> indexBuffer;
+			RangeAllocator vertices;
+			RangeAllocator indices;
+			uint32_t allocations = 0;
+			uint64_t vertexBytes = 0;
+
+			void Free(const GeometryAllocation& allocation);
+		};
+
+		// Held by the pooled vertex array, gives its range back when the mesh goes away. Pages are shared
+		// with the vertex arrays in them, so this is safe even after the pool itself is gone.
+		struct Lease {
+			std::weak_ptr<Page> page;
+			GeometryAllocation allocation;
+
+			~Lease();
+		};
+
+		struct Entry {
+			GeometryAllocation allocation;
+			std::weak_ptr<Lease> lease;
+		};
+
+		int32_t findPage(const std::string& layoutKey, uint32_t vertexCount, uint32_t indexCount, uint32_t& vertexOffset, uint32_t& indexOffset);
+		void createPage(const VertexArrayObject& source, const std::string& layoutKey, uint32_t vertexCount, uint32_t indexCount);
+
+		struct Utils {
+			static bool CanPool(const VertexArrayObject& source);
+			static std::string GetLayoutKey(const VertexArrayObject& source);
+			static void CopyBuffer(uint32_t src, uint32_t dst, uint64_t srcOffset, uint64_t dstOffset, uint64_t size);
+		};
+	private:
+		uint32_t _pageVertices;
+		uint32_t _pageIndices;
+
+		std::vector<std::shared_ptr<Page>> _pages;
+		std::unordered_map<uint64_t, Entry> _entries; // VertexArrayObject unique id -> entry
+		GeometryAllocation _invalid;
+		GeometryPoolStats _stats;
+	};
+}
@@ -0,0 +1,64 @@
+#include "ObjectDataBuffer.h"
+
+#include <cstring>
+#include <algorithm>
+#include <glad/glad.h>
+
+using namespace Engine;
+
+uint32_t ObjectDataBuffer::Push(const glm::mat4& model, uint32_t entityId) {
+	return Push(model, glm::transpose(glm::inverse(glm::mat3(model))), entityId);
+}
+
+uint32_t ObjectDataBuffer::Push(const glm::mat4& model, const glm::mat3& normalMatrix, uint32_t entityId) {
+	initStride();
+	if ((_count + 1) * _stride > _data.size())
+		_data.resize(std::max<size_t>(_data.size() * 2, (_count + 1) * _stride));
+
+	ObjectData data{};
+	data.model = model;
+	data.normalMatrix = glm::mat4(normalMatrix);
+	data.entityId = entityId;
+	memcpy(_data.data() + _count * _stride, &data, sizeof(ObjectData));
+
+	return _count++;
+}
+
+void ObjectDataBuffer::Upload() {
+	initStride();
+
+	// Always room for one entry, so the binding point holds a full sized block even on an empty frame
+	uint32_t needed = std::max(_count, 1u);
+	if (needed > _capacity) {
+		_capacity = std::max(needed, _capacity * 2);
+		_ubo = std::make_unique<UniformBufferObject>(_capacity * _stride, _bindingPoint, BufferUsage::Stream);
+	}
+
+	if (_count > 0) {
+		_ubo->SetData(_data.data(), _count * _stride);
+	}
+	else {
+		ObjectData identity{};
+		identity.model = glm::mat4(1.0f);
+		identity.normalMatrix = glm::mat4(1.0f);
+		_ubo->SetData(&identity, sizeof(ObjectData));
+	}
+
+	// Replaces whatever range the previous frame left bound, draws still select their own entry
+	Bind(0);
+}
+
+void ObjectDataBuffer::Bind(uint32_t index) const {
+	_ubo->BindRange(_bindingPoint, index * _stride, sizeof(ObjectData));
+}
+
+void ObjectDataBuffer::initStride() {
+	if (_stride != 0)
+		return;
+
+	// Range binds must start on a multiple of the offset alignment
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	uint32_t align = (uint32_t)std::max(alignment, 1);
+	_stride = ((uint32_t)sizeof(ObjectData) + align - 1) / align * align;
+}
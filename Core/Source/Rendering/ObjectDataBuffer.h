@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Rendering/Platform/Buffer/UniformBufferObject.h"
+
+namespace Engine {
+	// Matches the std140 ObjectData block:
+	// layout (std140) uniform ObjectData { mat4 model; mat4 normalMatrix; uint entityId; };
+	struct ObjectData {
+		glm::mat4 model;
+		glm::mat4 normalMatrix;
+		uint32_t entityId;
+		uint32_t padding[3];
+	};
+
+	// Per frame object data for every draw, written in one contiguous upload. Each draw then
+	// selects its own entry with a range bind, entries are spaced by the uniform buffer offset alignment.
+	class ObjectDataBuffer {
+	public:
+		static const uint32_t DEFAULT_BINDING_POINT = 2;
+
+		ObjectDataBuffer(uint32_t bindingPoint = DEFAULT_BINDING_POINT)
+			: _bindingPoint(bindingPoint) {}
+
+		void Clear() { _count = 0; }
+		// Returns the index to pass to Bind
+		uint32_t Push(const glm::mat4& model, uint32_t entityId);
+		// For models that also transform the stored vertices into local space, which normals must not see
+		uint32_t Push(const glm::mat4& model, const glm::mat3& normalMatrix, uint32_t entityId);
+		// Binds entry 0, an identity entry if nothing was pushed
+		void Upload();
+		void Bind(uint32_t index) const;
+
+		inline uint32_t GetCount() const { return _count; }
+		inline uint32_t GetStride() const { return _stride; }
+		inline uint32_t GetBindingPoint() const { return _bindingPoint; }
+	private:
+		void initStride();
+	private:
+		uint32_t _bindingPoint;
+		uint32_t _stride = 0;
+		uint32_t _count = 0;
+		uint32_t _capacity = 0;
+		std::vector<uint8_t> _data;
+		std::unique_ptr<UniformBufferObject> _ubo;
+	};
+}
@@ -2,6 +2,10 @@
 
 #include <glad/glad.h>
 #include "Logging/Logging.h"
+#include "Rendering/GLStateCache.h"
+#include "Rendering/GLExtensions.h"
+
+#include <algorithm>
 
 using namespace Engine;
 
@@ -25,51 +29,194 @@ TextureType OpenGLTextureTypeToTextureType(uint32_t type) {
 	return TextureType::Tex2D;
 }
 
+TextureStats BaseTexture::_stats{};
+
 BaseTexture::BaseTexture(TextureType type, const TextureSpec& spec)
-	: _format(spec.format), _type(type), _internalType(TextureTypeToOpenGLTextureType(type)),
+	: _id(0), _type(type), _format(spec.format),
 	_width(spec.width), _height(spec.height),
-	_id(0),
+	_mipLevels(spec.mipLevels == 0 ? GetFullMipCount(spec.width, spec.height) : std::min(spec.mipLevels, GetFullMipCount(spec.width, spec.height))),
+	_internalType(TextureTypeToOpenGLTextureType(type)),
 	_internalFormat(0), _dataFormat(0), _dataType(0) {
 
 	_internalFormat = Utils::ImageFormatToOpenGLInternalFormat(spec.format);
 	_dataFormat = Utils::ImageFormatToOpenGLDataFormat(spec.format);
 	_dataType = Utils::ImageFormatToOpenGLDataType(spec.format);
+	if (spec.halfFloatData && _dataType == GL_FLOAT) {
+		_dataType = GL_HALF_FLOAT;
+		_halfFloatData = true;
+	}
 
 	glGenTextures(1, &_id);
+
+	_storageSize = computeStorageSize();
+	_stats.textures++;
+	_stats.storageBytes += _storageSize;
 }
 
 BaseTexture::~BaseTexture() {
+	_stats.textures--;
+	_stats.storageBytes -= _storageSize;
+	GLStateCache::OnTextureDeleted(_id);
 	glDeleteTextures(1, &_id);
 }
 
 void BaseTexture::Bind(uint32_t slot) const {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	BindInternal();
+	GLStateCache::BindTexture(slot, _internalType, _id);
+	_lastBoundFrame = GLStateCache::GetFrameIndex();
+	GLStateCache::BindSampler(slot, _sampler ? _sampler->GetInstanceID() : 0);
 }
 
 void BaseTexture::Unbind() const {
-	glBindTexture(_internalType, 0);
+	GLStateCache::BindTexture(_internalType, 0);
 }
 
 void BaseTexture::BindInternal() const {
-	glBindTexture(_internalType, _id);
+	GLStateCache::BindTexture(_internalType, _id);
+}
+
+void BaseTexture::GenerateMipmaps() {
+	if (_mipLevels <= 1)
+		return;
+
+	if (Utils::ImageFormatIsCompressed(_format)) {
+		ENGINE_WARN("[BaseTexture::GenerateMipmaps] Compressed textures cannot generate mipmaps, upload every level instead");
+		return;
+	}
+
+	BindInternal();
+	glGenerateMipmap(_internalType);
+}
+
+uint32_t BaseTexture::GetFullMipCount(uint32_t width, uint32_t height) {
+	uint32_t levels = 1;
+	for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+		levels++;
+	return levels;
+}
+
+void BaseTexture::AllocateStorage() {
+	BindInternal();
+
+	if (GLExtensions::HasTextureStorage()) {
+		GLExtensions::TexStorage2D(_internalType, _mipLevels, _internalFormat, _width, _height);
+	}
+	else {
+		uint32_t faces = _type == TextureType::TexCubemap ? 6 : 1;
+		uint32_t target = _type == TextureType::TexCubemap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : _internalType;
+		for (uint32_t level = 0; level < _mipLevels; level++) {
+			uint32_t width = std::max(_width >> level, 1u);
+			uint32_t height = std::max(_height >> level, 1u);
+			for (uint32_t face = 0; face < faces; face++) {
+				if (Utils::ImageFormatIsCompressed(_format))
+					glCompressedTexImage2D(target + face, level, _internalFormat, width, height, 0, (GLsizei)Utils::ImageFormatLevelSize(_format, width, height), nullptr);
+				else
+					glTexImage2D(target + face, level, _internalFormat, width, height, 0, _dataFormat, _dataType, nullptr);
+			}
+		}
+	}
+
+	// Without immutable storage the texture is only complete if it does not expect levels it never got
+	glTexParameteri(_internalType, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(_internalType, GL_TEXTURE_MAX_LEVEL, _mipLevels - 1);
+	// Filtering comes from the sampler, this only applies where none is bound (eg. ImGui)
+	glTexParameteri(_internalType, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+}
+
+uint64_t BaseTexture::computeStorageSize() const {
+	uint64_t size = 0;
+	for (uint32_t level = 0; level < _mipLevels; level++)
+		size += Utils::ImageFormatStorageSize(_format, std::max(_width >> level, 1u), std::max(_height >> level, 1u));
+	return _type == TextureType::TexCubemap ? size * 6 : size;
+}
+
+uint64_t BaseTexture::GetLevelDataSize(uint32_t level) const {
+	uint32_t width = std::max(_width >> level, 1u);
+	uint32_t height = std::max(_height >> level, 1u);
+	if (_halfFloatData)
+		return (uint64_t)width * height * Utils::ImageFormatChannelCount(_format) * 2;
+	return Utils::ImageFormatLevelSize(_format, width, height);
 }
 
-void BaseTexture::SetDataInternal(uint32_t target, void* data) {
-	glTexImage2D(target, 0, _internalFormat, _width, _height, 0, _dataFormat, _dataType, data);
+void BaseTexture::SetDataInternal(uint32_t target, const void* data, uint32_t level) {
+	SetRowsInternal(target, level, 0, std::max(_height >> level, 1u), data);
+}
+
+void BaseTexture::SetRowsInternal(uint32_t target, uint32_t level, uint32_t y, uint32_t height, const void* data) {
+	if (level >= _mipLevels) {
+		ENGINE_ERROR("[BaseTexture::SetRowsInternal] Level {} is out of range, the texture has {} levels", level, _mipLevels);
+		return;
+	}
+
+	// Image data is tightly packed, rows of small levels are rarely a multiple of 4 bytes
+	uint32_t width = std::max(_width >> level, 1u);
+	uint32_t levelHeight = std::max(_height >> level, 1u);
+	height = std::min(height, levelHeight - std::min(y, levelHeight));
+	if (Utils::ImageFormatIsCompressed(_format)) {
+		// Uploaded as is, no conversion by the driver
+		GLsizei size = (GLsizei)Utils::ImageFormatLevelSize(_format, width, height);
+		glCompressedTexSubImage2D(target, level, 0, y, width, height, _internalFormat, size, data);
+	}
+	else {
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(target, level, 0, y, width, height, _dataFormat, _dataType, data);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
 	GLenum error = glGetError();
 	if (error != GL_NO_ERROR) {
-		ENGINE_ERROR("[BaseTexture::SetDataInternal] Error setting texture data: {}", error);
+		ENGINE_ERROR("[BaseTexture::SetRowsInternal] Error setting texture data: {}", error);
 	}
 }
 
+void BaseTexture::SetBaseLevel(uint32_t level) {
+	_baseLevel = std::min(level, _mipLevels - 1);
+	BindInternal();
+	glTexParameteri(_internalType, GL_TEXTURE_BASE_LEVEL, _baseLevel);
+}
+
+std::vector<uint8_t> BaseTexture::GetDataInternal(uint32_t target, uint32_t level) const {
+	if (level >= _mipLevels)
+		return {};
+
+	std::vector<uint8_t> data(GetLevelDataSize(level));
+	ReadLevelInternal(target, level, data.data());
+	return data;
+}
+
+void BaseTexture::ReadLevelInternal(uint32_t target, uint32_t level, void* data) const {
+	BindInternal();
+	if (Utils::ImageFormatIsCompressed(_format)) {
+		glGetCompressedTexImage(target, level, data);
+	}
+	else {
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glGetTexImage(target, level, _dataFormat, _dataType, data);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	}
+}
+
+void BaseTexture::SwapInternal(BaseTexture& other) {
+	std::swap(_id, other._id);
+	std::swap(_format, other._format);
+	std::swap(_width, other._width);
+	std::swap(_height, other._height);
+	std::swap(_mipLevels, other._mipLevels);
+	std::swap(_baseLevel, other._baseLevel);
+	std::swap(_halfFloatData, other._halfFloatData);
+	std::swap(_sampler, other._sampler);
+	std::swap(_internalFormat, other._internalFormat);
+	std::swap(_dataFormat, other._dataFormat);
+	std::swap(_dataType, other._dataType);
+	std::swap(_storageSize, other._storageSize);
+}
+
 #include <stb_image.h>
 #include "Util/FileIO.h"
 
 namespace Engine::Texture::Utils {
-	FileTextureData LoadFromFile(const std::string& path) {
+	FileTextureData LoadFromFile(const std::string& path, bool flipV) {
 		FileTextureData data;
 		int channels;
+		stbi_set_flip_vertically_on_load_thread(flipV);
 		if (FileIO::HasExtension(path, ".hdr")) {
 			float* fdata = stbi_loadf(path.c_str(), &data.width, &data.height, &channels, 0);
 			if (fdata) {
@@ -78,8 +225,9 @@ namespace Engine::Texture::Utils {
 				case 3: data.format = ImageFormat::RGB16F; break;
 				case 4: data.format = ImageFormat::RGBA16F; break;
 				default:
-					ENGINE_ERROR("Texture::LoadFromFile] Unsupported number of channels: {}", channels);
+					ENGINE_ERROR("[Texture::LoadFromFile] Unsupported number of channels: {}", channels);
 					stbi_image_free(fdata);
+					data.data = nullptr;
 					break;
 				}
 				return data;
@@ -91,11 +239,13 @@ namespace Engine::Texture::Utils {
 				data.data = udata;
 				switch (channels) {
 				case 1: data.format = ImageFormat::R8; break;
+				case 2: data.format = ImageFormat::RG8; break;
 				case 3: data.format = ImageFormat::RGB8; break;
 				case 4: data.format = ImageFormat::RGBA8; break;
 				default:
 					ENGINE_ERROR("[Texture::LoadFromFile] Unsupported number of channels: {}", channels);
 					stbi_image_free(udata);
+					data.data = nullptr;
 					break;
 				}
 				return data;
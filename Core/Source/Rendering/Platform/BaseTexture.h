@@ -1,7 +1,11 @@
 #pragma once
 #include <cstdint>
 
+#include <memory>
+#include <vector>
+
 #include "ImageFormat.h"
+#include "Sampler.h"
 
 namespace Engine {
 	enum class TextureType {
@@ -13,6 +17,13 @@ namespace Engine {
 		uint32_t width = 1;
 		uint32_t height = 1;
 		ImageFormat format = ImageFormat::RGBA8;
+		uint32_t mipLevels = 1; // 0 allocates the full chain down to 1x1
+		bool halfFloatData = false; // Float formats are uploaded and read back as half floats rather than floats
+	};
+
+	struct TextureStats {
+		uint32_t textures = 0;
+		uint64_t storageBytes = 0; // Estimated from the formats and sizes, see ImageFormatStorageSize
 	};
 
 	class BaseTexture {
@@ -23,22 +34,68 @@ namespace Engine {
 		void Bind(uint32_t slot) const;
 		void Unbind() const;
 
+		// Fills every level below the base from the base level on the GPU
+		void GenerateMipmaps();
+
+		// Finest level that is sampled, levels above it can still be missing while they stream in
+		void SetBaseLevel(uint32_t level);
+		inline uint32_t GetBaseLevel() const { return _baseLevel; }
+
+		// Bound along with the texture, shared with every other texture sampled the same way
+		inline void SetSampler(std::shared_ptr<Sampler> sampler) { _sampler = sampler; }
+		inline void SetSampler(const SamplerSpec& spec) { _sampler = Sampler::Utils::Get(spec); }
+		inline std::shared_ptr<Sampler> GetSampler() const { return _sampler; }
+
 		inline uint32_t GetInstanceID() const { return _id; }
 		inline TextureType GetType() const { return _type; }
 		inline uint32_t GetWidth() const { return _width; }
 		inline uint32_t GetHeight() const { return _height; }
 		inline ImageFormat GetFormat() const { return _format; }
+		inline uint32_t GetMipLevels() const { return _mipLevels; }
+		inline bool IsHalfFloatData() const { return _halfFloatData; }
+
+		// Bytes of client data for one face of a level, as passed to SetData
+		uint64_t GetLevelDataSize(uint32_t level) const;
+		// Estimated GPU bytes of every level and face
+		inline uint64_t GetStorageSize() const { return _storageSize; }
+		// GLStateCache frame index of the last Bind
+		inline uint64_t GetLastBoundFrame() const { return _lastBoundFrame; }
+
+		static const TextureStats& GetStats() { return _stats; }
+
+		static uint32_t GetFullMipCount(uint32_t width, uint32_t height);
 	protected:
 		void BindInternal() const;
-		void SetDataInternal(uint32_t target, void* data);
+		// Allocates every level of every face at once, immutable where the driver supports it
+		void AllocateStorage();
+		void SetDataInternal(uint32_t target, const void* data, uint32_t level = 0);
+		// Rows y to y + height of a level, y must be a multiple of the block height for compressed formats.
+		// With a pixel unpack buffer bound data is an offset into it.
+		void SetRowsInternal(uint32_t target, uint32_t level, uint32_t y, uint32_t height, const void* data);
+		std::vector<uint8_t> GetDataInternal(uint32_t target, uint32_t level) const;
+		// With a pixel pack buffer bound data is an offset into it
+		void ReadLevelInternal(uint32_t target, uint32_t level, void* data) const;
+		// Exchanges the GL textures and everything describing them, the type must match
+		void SwapInternal(BaseTexture& other);
 	protected:
 		uint32_t _id;
 		TextureType _type;
 		ImageFormat _format;
 
 		uint32_t _width, _height;
+		uint32_t _mipLevels;
+		uint32_t _baseLevel = 0;
+		bool _halfFloatData = false;
+		std::shared_ptr<Sampler> _sampler;
 		uint32_t _internalType;
 		uint32_t _internalFormat, _dataFormat, _dataType;
+
+		uint64_t _storageSize = 0;
+		mutable uint64_t _lastBoundFrame = 0;
+
+		static TextureStats _stats;
+	private:
+		uint64_t computeStorageSize() const;
 	};
 }
 
@@ -46,10 +103,11 @@ namespace Engine {
 
 namespace Engine::Texture::Utils {
 	struct FileTextureData {
-		int32_t width, height;
-		ImageFormat format;
-		void* data;
+		int32_t width = 0, height = 0;
+		ImageFormat format = ImageFormat::None;
+		void* data = nullptr; // Freed with stbi_image_free, nullptr if loading failed
 	};
 
-	FileTextureData LoadFromFile(const std::string& path);
+	// Safe to call from any thread, the flip only applies to the calling thread
+	FileTextureData LoadFromFile(const std::string& path, bool flipV = false);
 }
\ No newline at end of file
@@ -8,7 +8,8 @@ namespace Engine {
 		UnsignedShort = 0x1403,
 		Int = 0x1404,
 		UnsignedInt = 0x1405,
-		Float = 0x1406
+		Float = 0x1406,
+		HalfFloat = 0x140B
 	};
 
 	static size_t GetLTypeSize(LType size) {
@@ -18,6 +19,7 @@ namespace Engine {
 			return sizeof(char);
 		case LType::Short:
 		case LType::UnsignedShort:
+		case LType::HalfFloat:
 			return sizeof(short);
 		case LType::Int:
 		case LType::UnsignedInt:
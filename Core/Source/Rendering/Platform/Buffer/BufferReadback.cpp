@@ -0,0 +1,94 @@
+#include "BufferReadback.h"
+#include <glad/glad.h>
+
+#include <cstring>
+
+#include "Logging/Logging.h"
+
+using namespace Engine;
+
+std::shared_ptr<BufferReadback> BufferReadback::Request(uint32_t sourceBuffer, uint64_t offset, uint64_t size) {
+	std::shared_ptr<BufferReadback> readback(new BufferReadback());
+	readback->_size = size;
+	if (size == 0) {
+		readback->_resolved = true;
+		return readback;
+	}
+
+	glGenBuffers(1, &readback->_stagingBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, readback->_stagingBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_READ);
+	glBindBuffer(GL_COPY_READ_BUFFER, sourceBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)offset, 0, (GLsizeiptr)size);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	readback->_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	// Submit now, otherwise polling could wait on a fence the driver has not sent yet
+	glFlush();
+	return readback;
+}
+
+std::shared_ptr<BufferReadback> BufferReadback::FromData(std::vector<uint8_t> data) {
+	std::shared_ptr<BufferReadback> readback(new BufferReadback());
+	readback->_size = data.size();
+	readback->_data = std::move(data);
+	readback->_resolved = true;
+	return readback;
+}
+
+BufferReadback::~BufferReadback() {
+	if (_fence)
+		glDeleteSync((GLsync)_fence);
+	if (_stagingBuffer)
+		glDeleteBuffers(1, &_stagingBuffer);
+}
+
+bool BufferReadback::IsReady() {
+	if (_resolved || !_fence)
+		return true;
+
+	GLenum result = glClientWaitSync((GLsync)_fence, 0, 0);
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED;
+}
+
+void BufferReadback::Wait() {
+	if (_resolved || !_fence)
+		return;
+
+	GLenum result;
+	do {
+		result = glClientWaitSync((GLsync)_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	} while (result == GL_TIMEOUT_EXPIRED);
+
+	if (result == GL_WAIT_FAILED)
+		ENGINE_ERROR("[BufferReadback::Wait] Waiting on the readback fence failed");
+}
+
+const std::vector<uint8_t>& BufferReadback::GetData() {
+	if (!_resolved)
+		resolve();
+	return _data;
+}
+
+void BufferReadback::resolve() {
+	Wait();
+
+	_data.resize(_size);
+	glBindBuffer(GL_COPY_READ_BUFFER, _stagingBuffer);
+	const void* mapped = glMapBufferRange(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)_size, GL_MAP_READ_BIT);
+	if (mapped) {
+		std::memcpy(_data.data(), mapped, _size);
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+	}
+	else {
+		ENGINE_ERROR("[BufferReadback::resolve] Failed to map the staging buffer");
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	glDeleteSync((GLsync)_fence);
+	glDeleteBuffers(1, &_stagingBuffer);
+	_fence = nullptr;
+	_stagingBuffer = 0;
+	_resolved = true;
+}
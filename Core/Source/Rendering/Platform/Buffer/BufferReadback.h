@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+namespace Engine {
+	// A copy of part of a GPU buffer on its way back to the CPU. The copy is made into a staging buffer on
+	// the GPU timeline and fenced, so requesting it never stalls, the data is only read once the fence has passed.
+	class BufferReadback {
+	public:
+		static std::shared_ptr<BufferReadback> Request(uint32_t sourceBuffer, uint64_t offset, uint64_t size);
+		// Already complete, for data that is available on the CPU
+		static std::shared_ptr<BufferReadback> FromData(std::vector<uint8_t> data);
+
+		~BufferReadback();
+
+		BufferReadback(const BufferReadback&) = delete;
+		BufferReadback& operator=(const BufferReadback&) = delete;
+
+		// Polls the fence without waiting
+		bool IsReady();
+		// Blocks until the GPU has finished the copy
+		void Wait();
+		// Waits if needed, the staging buffer is read and released on the first call
+		const std::vector<uint8_t>& GetData();
+
+		inline uint64_t GetSize() const { return _size; }
+	private:
+		BufferReadback() = default;
+		void resolve();
+	private:
+		uint32_t _stagingBuffer = 0;
+		void* _fence = nullptr; // GLsync
+		uint64_t _size = 0;
+		bool _resolved = false;
+		std::vector<uint8_t> _data;
+	};
+}
@@ -2,11 +2,13 @@
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cstring>
+
 using namespace Engine;
 
 IndexBufferObject::IndexBufferObject(BufferUsage usage) : _id(0), _usage(usage), _count(0), _type(LType::UnsignedByte) {
 	glGenBuffers(1, &_id);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _id);
 }
 
 IndexBufferObject::~IndexBufferObject() {
@@ -23,13 +25,51 @@ void IndexBufferObject::Unbind() const {
 
 void IndexBufferObject::SetData(const void* data, LType type, uint32_t count) {
 	_type = type; _count = count;
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _id);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(GetLTypeSize(type) * count), data, (GLenum)_usage);
+	// Uploaded through the copy target so the element binding of whichever VAO is bound stays intact
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _id);
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(GetLTypeSize(type) * count), data, (GLenum)_usage);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	if (_shadowCopyEnabled) {
+		_shadowCopy.assign(GetLTypeSize(type) * count, 0);
+		if (data)
+			std::memcpy(_shadowCopy.data(), data, _shadowCopy.size());
+	}
 }
 
-std::vector<uint8_t> IndexBufferObject::GetRawData() const {
-	std::vector<uint8_t> rawData(_count * GetLTypeSize(_type));
-	Bind();
-	glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, rawData.size(), rawData.data());
+void IndexBufferObject::Allocate(LType type, uint32_t count) {
+	SetData(nullptr, type, count);
+}
+
+std::vector<uint8_t> IndexBufferObject::GetRawData(uint64_t offset, uint64_t size) const {
+	uint64_t dataSize = _shadowCopyEnabled ? _shadowCopy.size() : (uint64_t)_count * GetLTypeSize(_type);
+	offset = std::min(offset, dataSize);
+	size = std::min(size, dataSize - offset);
+
+	if (_shadowCopyEnabled)
+		return std::vector<uint8_t>(_shadowCopy.begin() + offset, _shadowCopy.begin() + offset + size);
+
+	std::vector<uint8_t> rawData(size);
+	glBindBuffer(GL_COPY_READ_BUFFER, _id);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, offset, rawData.size(), rawData.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
 	return rawData;
 }
+
+std::shared_ptr<BufferReadback> IndexBufferObject::ReadRawDataAsync(uint64_t offset, uint64_t size) const {
+	if (_shadowCopyEnabled)
+		return BufferReadback::FromData(GetRawData(offset, size));
+
+	uint64_t dataSize = (uint64_t)_count * GetLTypeSize(_type);
+	offset = std::min(offset, dataSize);
+	return BufferReadback::Request(_id, offset, std::min(size, dataSize - offset));
+}
+
+void IndexBufferObject::SetShadowCopyEnabled(bool enabled) {
+	if (enabled == _shadowCopyEnabled)
+		return;
+
+	// Seeded from the GPU once, kept up to date by every write after that
+	_shadowCopy = enabled ? GetRawData() : std::vector<uint8_t>();
+	_shadowCopyEnabled = enabled;
+}
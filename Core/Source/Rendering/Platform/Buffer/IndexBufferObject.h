@@ -1,7 +1,9 @@
 #pragma once
 #include <cstdint>
 #include <vector>
+#include <memory>
 #include "BufferCommon.h"
+#include "BufferReadback.h"
 
 namespace Engine {
 	class IndexBufferObject {
@@ -13,15 +15,29 @@ namespace Engine {
 		void Unbind() const;
 
 		void SetData(const void* data, LType type, uint32_t count);
+		// Allocates storage for count indices without uploading anything
+		void Allocate(LType type, uint32_t count);
 
-		std::vector<uint8_t> GetRawData() const;
+		// Returns the shadow copy when there is one, otherwise blocks until the GPU has caught up.
+		// Both reads cover the whole buffer by default, ranges are in bytes and clamped to the data.
+		std::vector<uint8_t> GetRawData(uint64_t offset = 0, uint64_t size = UINT64_MAX) const;
+		// Starts copying the data back without stalling, poll the returned handle
+		std::shared_ptr<BufferReadback> ReadRawDataAsync(uint64_t offset = 0, uint64_t size = UINT64_MAX) const;
+
+		// Keep a CPU copy of everything written through SetData, for buffers that are read back often
+		void SetShadowCopyEnabled(bool enabled);
+		inline bool HasShadowCopy() const { return _shadowCopyEnabled; }
 
 		inline uint32_t GetCount() const { return _count; }
 		inline LType GetType() const { return _type; }
+		inline uint32_t GetHandle() const { return _id; }
 	private:
 		uint32_t _id;
 		BufferUsage _usage;
 		LType _type;
 		uint32_t _count;
+
+		bool _shadowCopyEnabled = false;
+		std::vector<uint8_t> _shadowCopy;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "IndirectBufferObject.h"
+
+#include <glad/glad.h>
+
+#include "Rendering/GLExtensions.h"
+#include "Rendering/GLStateCache.h"
+
+using namespace Engine;
+
+IndirectBufferObject::IndirectBufferObject(BufferUsage usage) : _id(0), _usage(usage) {
+	glGenBuffers(1, &_id);
+}
+
+IndirectBufferObject::~IndirectBufferObject() {
+	GLStateCache::OnBufferDeleted(_id);
+	glDeleteBuffers(1, &_id);
+}
+
+void IndirectBufferObject::Bind() const {
+	glBindBuffer(GLExtensions::DRAW_INDIRECT_BUFFER, _id);
+}
+
+void IndirectBufferObject::Unbind() const {
+	glBindBuffer(GLExtensions::DRAW_INDIRECT_BUFFER, 0);
+}
+
+void IndirectBufferObject::SetData(const void* data, uint64_t size) {
+	_size = size;
+	glBindBuffer(GLExtensions::DRAW_INDIRECT_BUFFER, _id);
+	glBufferData(GLExtensions::DRAW_INDIRECT_BUFFER, (GLsizeiptr)size, data, (GLenum)_usage);
+	glBindBuffer(GLExtensions::DRAW_INDIRECT_BUFFER, 0);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include "BufferCommon.h"
+
+namespace Engine {
+	// Draw commands for glMultiDrawElementsIndirect, read from the GPU instead of passed with the draw
+	class IndirectBufferObject {
+	public:
+		IndirectBufferObject(BufferUsage usage = BufferUsage::Stream);
+		~IndirectBufferObject();
+
+		IndirectBufferObject(const IndirectBufferObject&) = delete;
+		IndirectBufferObject& operator=(const IndirectBufferObject&) = delete;
+
+		void Bind() const;
+		void Unbind() const;
+
+		// Replaces the whole contents with fresh storage, so draws still reading the old commands never stall the write
+		void SetData(const void* data, uint64_t size);
+
+		inline uint64_t GetSize() const { return _size; }
+		inline uint32_t GetHandle() const { return _id; }
+	private:
+		uint32_t _id;
+		BufferUsage _usage;
+		uint64_t _size = 0;
+	};
+}
@@ -0,0 +1,151 @@
+#include "StreamingBuffer.h"
+#include <glad/glad.h>
+
+#include <cstring>
+
+#include "Rendering/GLExtensions.h"
+#include "Logging/Logging.h"
+
+using namespace Engine;
+
+StreamingBuffer::StreamingBuffer(uint64_t regionSize) {
+	create(regionSize);
+}
+
+StreamingBuffer::~StreamingBuffer() {
+	destroy();
+}
+
+void StreamingBuffer::BeginFrame() {
+	_region = (_region + 1) % REGION_COUNT;
+	_head = 0;
+	waitForRegion(_region);
+}
+
+void StreamingBuffer::EndFrame() {
+	Unmap();
+	if (_fences[_region])
+		glDeleteSync((GLsync)_fences[_region]);
+	_fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool StreamingBuffer::Reserve(uint64_t size) {
+	if (size <= _regionSize)
+		return false;
+
+	// Whatever the GPU still reads from the old buffer stays alive until it is done with it
+	uint64_t regionSize = _regionSize;
+	while (regionSize < size)
+		regionSize *= 2;
+
+	destroy();
+	create(regionSize);
+	_stats.reallocations++;
+	return true;
+}
+
+void* StreamingBuffer::Map(uint64_t size, uint64_t alignment, uint64_t& offset) {
+	Unmap();
+
+	uint64_t regionStart = _region * _regionSize;
+	uint64_t start = regionStart + _head;
+	if (alignment > 1)
+		start = (start + alignment - 1) / alignment * alignment;
+
+	if (start + size > regionStart + _regionSize) {
+		ENGINE_WARN("[StreamingBuffer::Map] {} bytes do not fit in a {} byte region, call Reserve first", size, _regionSize);
+		return nullptr;
+	}
+
+	offset = start;
+	_head = start + size - regionStart;
+	_stats.bytesWritten += size;
+	_stats.allocations++;
+
+	if (_persistentMapping)
+		return _persistentMapping + start;
+
+	// The fence already guarantees the GPU is done with this range, so the driver must not wait or keep the old contents
+	glBindBuffer(GL_ARRAY_BUFFER, _id);
+	void* pointer = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)start, (GLsizeiptr)size,
+		GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	_mapped = pointer != nullptr;
+	return pointer;
+}
+
+void StreamingBuffer::Unmap() {
+	if (!_mapped)
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, _id);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	_mapped = false;
+}
+
+bool StreamingBuffer::Write(const void* data, uint64_t size, uint64_t alignment, uint64_t& offset) {
+	void* pointer = Map(size, alignment, offset);
+	if (!pointer)
+		return false;
+
+	std::memcpy(pointer, data, size);
+	Unmap();
+	return true;
+}
+
+void StreamingBuffer::create(uint64_t regionSize) {
+	// Regions start on a boundary that suits any attribute type
+	_regionSize = (regionSize + 255) / 256 * 256;
+	_region = 0;
+	_head = 0;
+
+	uint64_t size = _regionSize * REGION_COUNT;
+	glGenBuffers(1, &_id);
+	glBindBuffer(GL_ARRAY_BUFFER, _id);
+
+	if (GLExtensions::HasBufferStorage()) {
+		uint32_t flags = GL_MAP_WRITE_BIT | GLExtensions::MAP_PERSISTENT_BIT | GLExtensions::MAP_COHERENT_BIT;
+		GLExtensions::BufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+		_persistentMapping = (uint8_t*)glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)size, flags);
+		if (!_persistentMapping)
+			ENGINE_ERROR("[StreamingBuffer::create] Failed to persistently map {} bytes", size);
+	}
+	else {
+		glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+void StreamingBuffer::destroy() {
+	for (auto& fence : _fences) {
+		if (fence)
+			glDeleteSync((GLsync)fence);
+		fence = nullptr;
+	}
+
+	if (_persistentMapping || _mapped) {
+		glBindBuffer(GL_ARRAY_BUFFER, _id);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	_persistentMapping = nullptr;
+	_mapped = false;
+
+	glDeleteBuffers(1, &_id);
+	_id = 0;
+}
+
+void StreamingBuffer::waitForRegion(uint32_t region) {
+	GLsync fence = (GLsync)_fences[region];
+	if (!fence)
+		return;
+
+	// Only counts as a wait if the GPU has not already passed the fence
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		_stats.waits++;
+		do {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+
+	glDeleteSync(fence);
+	_fences[region] = nullptr;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+
+namespace Engine {
+	struct StreamingBufferStats {
+		uint64_t bytesWritten = 0;
+		uint32_t allocations = 0;
+		uint32_t waits = 0;         // Frames that had to wait for the GPU to release a region
+		uint32_t reallocations = 0;
+	};
+
+	// Vertex data rewritten every frame. The buffer is split into regions used in turn, each one fenced
+	// once the frame's draws are issued, so the CPU writes into a region the GPU is no longer reading
+	// and the driver never has to synchronise or copy. With ARB_buffer_storage the buffer stays mapped
+	// for its whole life, otherwise each write maps its range unsynchronized.
+	class StreamingBuffer {
+	public:
+		static const uint32_t REGION_COUNT = 3;
+		static const uint64_t DEFAULT_REGION_SIZE = 1 << 20;
+
+		StreamingBuffer(uint64_t regionSize = DEFAULT_REGION_SIZE);
+		~StreamingBuffer();
+
+		StreamingBuffer(const StreamingBuffer&) = delete;
+		StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+		// Moves to the next region, waiting if the GPU is still reading it
+		void BeginFrame();
+		// Fences the region, call once every draw using this frame's data has been issued
+		void EndFrame();
+
+		// Grows the regions so that size bytes fit in one frame. Returns true if the GL buffer was replaced,
+		// anything referencing it (eg. vertex array attributes) must be set up again.
+		bool Reserve(uint64_t size);
+
+		// Returns size writable bytes at an offset that is a multiple of alignment, which can be any value
+		// so that vertex offsets can be drawn with glDrawArrays first. nullptr if the region is full.
+		void* Map(uint64_t size, uint64_t alignment, uint64_t& offset);
+		// Must follow Map before drawing, does nothing when persistently mapped
+		void Unmap();
+		// Map, copy and Unmap in one, false if the data does not fit
+		bool Write(const void* data, uint64_t size, uint64_t alignment, uint64_t& offset);
+
+		inline uint32_t GetHandle() const { return _id; }
+		inline uint64_t GetRegionSize() const { return _regionSize; }
+		inline bool IsPersistent() const { return _persistentMapping != nullptr; }
+		inline const StreamingBufferStats& GetStats() const { return _stats; }
+	private:
+		void create(uint64_t regionSize);
+		void destroy();
+		void waitForRegion(uint32_t region);
+	private:
+		uint32_t _id = 0;
+		uint64_t _regionSize = 0;
+		uint32_t _region = 0;
+		uint64_t _head = 0; // Write position inside the current region
+
+		void* _fences[REGION_COUNT] = {}; // GLsync
+		uint8_t* _persistentMapping = nullptr;
+		bool _mapped = false;
+
+		StreamingBufferStats _stats;
+	};
+}
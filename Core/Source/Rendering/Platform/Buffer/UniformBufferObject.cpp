@@ -1,6 +1,8 @@
 #include "UniformBufferObject.h"
 #include <glad/glad.h>
 
+#include "Rendering/GLStateCache.h"
+
 using namespace Engine;
 
 UniformBufferObject::UniformBufferObject(uint32_t size, uint32_t bindingPoint, BufferUsage usage) 
@@ -9,10 +11,11 @@ UniformBufferObject::UniformBufferObject(uint32_t size, uint32_t bindingPoint, B
 	glBindBuffer(GL_UNIFORM_BUFFER, _id);
 	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, (GLenum)usage);
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
-	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, _id);
+	GLStateCache::BindUniformBufferBase(bindingPoint, _id);
 }
 
 UniformBufferObject::~UniformBufferObject() {
+	GLStateCache::OnBufferDeleted(_id);
 	glDeleteBuffers(1, &_id);
 }
 
@@ -29,3 +32,11 @@ void UniformBufferObject::SetData(const void* data, uint32_t size, uint32_t offs
 	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
+
+void UniformBufferObject::BindBase(uint32_t bindingPoint) const {
+	GLStateCache::BindUniformBufferBase(bindingPoint, _id);
+}
+
+void UniformBufferObject::BindRange(uint32_t bindingPoint, uint32_t offset, uint32_t size) const {
+	GLStateCache::BindUniformBufferRange(bindingPoint, _id, offset, size);
+}
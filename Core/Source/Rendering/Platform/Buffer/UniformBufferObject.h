@@ -11,6 +11,13 @@ namespace Engine {
 		void Bind();
 		void Unbind();
 		void SetData(const void* data, uint32_t size, uint32_t offset = 0);
+
+		// Attach the whole buffer or a slice of it to a binding point other than the one it was created with
+		void BindBase(uint32_t bindingPoint) const;
+		void BindRange(uint32_t bindingPoint, uint32_t offset, uint32_t size) const;
+
+		inline uint32_t GetHandle() const { return _id; }
+		inline uint32_t GetBindingPoint() const { return _bindingPoint; }
 	private:
 		uint32_t _id;
 		uint32_t _bindingPoint;
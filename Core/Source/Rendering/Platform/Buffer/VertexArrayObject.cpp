@@ -2,48 +2,151 @@
 
 #include <glad/glad.h>
 
+#include "Rendering/GLStateCache.h"
+
 using namespace Engine;
 
-VertexArrayObject::VertexArrayObject() : _id(0), _hasIndices(false) {
+static uint64_t NextUniqueId = 1;
+
+VertexArrayObject::VertexArrayObject() : _id(0), _uniqueId(NextUniqueId++), _hasIndices(false) {
 	glGenVertexArrays(1, &_id);
-	glBindVertexArray(_id);
+	GLStateCache::BindVertexArray(_id);
 }
 
 VertexArrayObject::~VertexArrayObject() {
+	GLStateCache::OnVertexArrayDeleted(_id);
 	glDeleteVertexArrays(1, &_id);
+	if (_instancedId != 0) {
+		GLStateCache::OnVertexArrayDeleted(_instancedId);
+		glDeleteVertexArrays(1, &_instancedId);
+	}
 }
 
 void VertexArrayObject::Bind() const {
-	glBindVertexArray(_id);
+	GLStateCache::BindVertexArray(_id);
+}
+
+void VertexArrayObject::BindInstanced() const {
+	GLStateCache::BindVertexArray(_instancedId != 0 ? _instancedId : _id);
 }
 
 void VertexArrayObject::Unbind() const {
-	glBindVertexArray(0);
+	GLStateCache::BindVertexArray(0);
 }
 
 void VertexArrayObject::AddVertexBuffer(const std::shared_ptr<VertexBufferObject>& vertexBuffer) {
 	_vertexBuffers.push_back(vertexBuffer);
 }
 
+void VertexArrayObject::AddVertexBuffer(const std::shared_ptr<StreamingBuffer>& streamingBuffer, const VertexLayout& layout) {
+	_streamingBuffers.push_back({ streamingBuffer, layout });
+}
+
 void VertexArrayObject::SetIndexBuffer(const std::shared_ptr<IndexBufferObject>& indexBuffer) {
 	_hasIndices = true;
 	_indexBuffer = indexBuffer;
 }
 
 void VertexArrayObject::Compute() {
-	glBindVertexArray(_id);
+	GLStateCache::BindVertexArray(_id);
+	setMeshAttributes();
+
+	if (_instancedId != 0) {
+		GLStateCache::BindVertexArray(_instancedId);
+		setMeshAttributes();
+		setAttributes(_instanceBuffer->GetHandle(), _instanceBuffer->GetLayout(), _instanceLocation, (uint64_t)_instanceOffset * _instanceBuffer->GetLayout().GetStride());
+	}
+}
+
+void VertexArrayObject::SetShadowCopyEnabled(bool enabled) {
+	// A copy of a shared buffer would hold every mesh in it, ranges of it are read back from the GPU instead
+	if (HasSharedBuffers())
+		return;
+
+	for (const auto& vertexBuffer : _vertexBuffers)
+		vertexBuffer->SetShadowCopyEnabled(enabled);
+	if (HasIndices())
+		_indexBuffer->SetShadowCopyEnabled(enabled);
+}
+
+void VertexArrayObject::MoveToSharedBuffers(const std::vector<std::shared_ptr<VertexBufferObject>>& vertexBuffers, const std::shared_ptr<IndexBufferObject>& indexBuffer,
+	uint32_t baseVertex, uint32_t firstIndex, const std::shared_ptr<void>& owner) {
+	_vertexCount = GetVertexCount();
+	_indexCount = GetIndexCount();
+	_baseVertex = baseVertex;
+	_firstIndex = firstIndex;
+	_sharedOwner = owner;
+
+	_vertexBuffers = vertexBuffers;
+	_indexBuffer = indexBuffer;
+	Compute();
+}
+
+std::vector<uint8_t> VertexArrayObject::GetRawVertexData(uint32_t stream) const {
+	uint64_t stride = _vertexBuffers[stream]->GetLayout().GetStride();
+	return _vertexBuffers[stream]->GetRawData(_baseVertex * stride, GetVertexCount() * stride);
+}
+
+std::shared_ptr<BufferReadback> VertexArrayObject::ReadRawVertexDataAsync(uint32_t stream) const {
+	uint64_t stride = _vertexBuffers[stream]->GetLayout().GetStride();
+	return _vertexBuffers[stream]->ReadRawDataAsync(_baseVertex * stride, GetVertexCount() * stride);
+}
+
+std::shared_ptr<BufferReadback> VertexArrayObject::ReadRawIndexDataAsync() const {
+	uint64_t indexSize = GetLTypeSize(_indexBuffer->GetType());
+	return _indexBuffer->ReadRawDataAsync(_firstIndex * indexSize, GetIndexCount() * indexSize);
+}
+
+void VertexArrayObject::SetInstanceBuffer(const std::shared_ptr<VertexBufferObject>& instanceBuffer, uint32_t firstLocation) {
+	_instanceBuffer = instanceBuffer;
+	_instanceLocation = firstLocation;
+	_instanceOffset = 0;
+
+	// Built once with the mesh attributes, after that only the instance attributes are re-pointed
+	if (_instancedId == 0) {
+		glGenVertexArrays(1, &_instancedId);
+		GLStateCache::BindVertexArray(_instancedId);
+		setMeshAttributes();
+	}
+
+	GLStateCache::BindVertexArray(_instancedId);
+	setAttributes(_instanceBuffer->GetHandle(), _instanceBuffer->GetLayout(), _instanceLocation, 0);
+}
+
+void VertexArrayObject::SetInstanceOffset(uint32_t firstInstance) {
+	if (!_instanceBuffer || firstInstance == _instanceOffset)
+		return;
+
+	_instanceOffset = firstInstance;
+	GLStateCache::BindVertexArray(_instancedId);
+	setAttributes(_instanceBuffer->GetHandle(), _instanceBuffer->GetLayout(), _instanceLocation, (uint64_t)firstInstance * _instanceBuffer->GetLayout().GetStride());
+}
+
+void VertexArrayObject::setMeshAttributes() {
 	uint32_t index = 0;
-	for (const auto& vertexBuffer : _vertexBuffers) {
-		vertexBuffer->Bind();
-		const auto& layout = vertexBuffer->GetLayout();
-		uint32_t offset = 0;
-		for (const auto& component : layout.GetComponents()) {
-			glVertexAttribPointer(index, component.Count, (GLenum)component.Type, false, layout.GetStride(), (const void*)(intptr_t)offset);
+	for (const auto& vertexBuffer : _vertexBuffers)
+		index = setAttributes(vertexBuffer->GetHandle(), vertexBuffer->GetLayout(), index, (uint64_t)_baseVertex * vertexBuffer->GetLayout().GetStride());
+	for (const auto& [streamingBuffer, layout] : _streamingBuffers)
+		index = setAttributes(streamingBuffer->GetHandle(), layout, index, 0);
+	if (HasIndices())
+		_indexBuffer->Bind();
+}
+
+uint32_t VertexArrayObject::setAttributes(uint32_t buffer, const VertexLayout& layout, uint32_t firstLocation, uint64_t baseOffset) {
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	uint32_t index = firstLocation;
+	uint64_t offset = baseOffset;
+	for (const auto& component : layout.GetComponents()) {
+		uint32_t locationCount = component.GetLocationCount();
+		uint32_t locationSize = component.Count / locationCount;
+		uint32_t locationBytes = component.GetByteSize() / locationCount;
+		for (uint32_t i = 0; i < locationCount; i++) {
+			glVertexAttribPointer(index, locationSize, (GLenum)component.Type, component.Normalized, layout.GetStride(), (const void*)(intptr_t)(offset + i * locationBytes));
 			glEnableVertexAttribArray(index);
-			offset += component.GetByteSize();
+			glVertexAttribDivisor(index, component.Divisor);
 			index++;
 		}
+		offset += component.GetByteSize();
 	}
-	if (HasIndices())
-		_indexBuffer->Bind();
-}
\ No newline at end of file
+	return index;
+}
@@ -1,11 +1,15 @@
 #pragma once
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <vector>
 
 #include "BufferCommon.h"
+#include "Util/Math/BoundingBox.h"
 
 #include "VertexBufferObject.h"
 #include "IndexBufferObject.h"
+#include "StreamingBuffer.h"
 
 namespace Engine {
 	enum class DrawMode {
@@ -18,36 +22,127 @@ namespace Engine {
 		TriangleFan = 0x0006
 	};
 
+	// Undoes the encodings a mesh was imported with (see MeshImportSettings), the defaults are plain float attributes
+	struct VertexDecoding {
+		// Stored positions are mapped to local space by scale then offset
+		glm::vec3 positionScale = glm::vec3(1.0f);
+		glm::vec3 positionOffset = glm::vec3(0.0f);
+		// Normals and tangents hold two octahedral coordinates, decoded by shaders with an `octahedralNormals` bool
+		bool octahedralNormals = false;
+
+		inline bool HasPositionTransform() const { return positionScale != glm::vec3(1.0f) || positionOffset != glm::vec3(0.0f); }
+		inline glm::mat4 GetPositionTransform() const {
+			glm::mat4 transform(1.0f);
+			transform[0][0] = positionScale.x;
+			transform[1][1] = positionScale.y;
+			transform[2][2] = positionScale.z;
+			transform[3] = glm::vec4(positionOffset, 1.0f);
+			return transform;
+		}
+	};
+
 	class VertexArrayObject {
 	public:
 		VertexArrayObject();
 		~VertexArrayObject();
 
 		void Bind() const;
+		// The mesh attributes plus the instance attributes, the plain vertex array if there is no instance buffer
+		void BindInstanced() const;
 		void Unbind() const;
 
 		void AddVertexBuffer(const std::shared_ptr<VertexBufferObject>& vertexBuffer);
+		// Attributes read from the start of the buffer, draws pick their data with a first vertex
+		void AddVertexBuffer(const std::shared_ptr<StreamingBuffer>& streamingBuffer, const VertexLayout& layout);
 		void SetIndexBuffer(const std::shared_ptr<IndexBufferObject>& indexBuffer);
 
 		void Compute();
 
+		// Applies to the vertex and index buffers, see VertexBufferObject::SetShadowCopyEnabled
+		void SetShadowCopyEnabled(bool enabled);
+
+		// Instance attributes come from a separate buffer starting at a fixed location, so one instance
+		// buffer can be shared by every mesh no matter how many attributes the mesh itself has.
+		// They live on a second vertex array used by BindInstanced, so plain draws of the mesh keep the
+		// default values at those locations.
+		void SetInstanceBuffer(const std::shared_ptr<VertexBufferObject>& instanceBuffer, uint32_t firstLocation);
+		// Re-points the instance attributes so that instance 0 reads the given element of the instance buffer
+		void SetInstanceOffset(uint32_t firstInstance);
+		inline const std::shared_ptr<VertexBufferObject>& GetInstanceBuffer() const { return _instanceBuffer; }
+
+		// Replaces the vertex and index buffers with ranges of larger buffers shared with other meshes, and lets go
+		// of the old ones. The attributes start at baseVertex so the indices stay relative to the mesh. owner is
+		// kept alive for as long as the vertex array uses the ranges.
+		void MoveToSharedBuffers(const std::vector<std::shared_ptr<VertexBufferObject>>& vertexBuffers, const std::shared_ptr<IndexBufferObject>& indexBuffer,
+			uint32_t baseVertex, uint32_t firstIndex, const std::shared_ptr<void>& owner);
+		inline bool HasSharedBuffers() const { return _sharedOwner != nullptr; }
+
+		// Shared buffers hold other meshes too, use the counts and reads below for this one
 		inline const IndexBufferObject& GetIndexBuffer() const { return *_indexBuffer; }
 		inline uint32_t GetVertexBufferCount() const { return (uint32_t)_vertexBuffers.size(); }
 		inline const VertexBufferObject& GetVertexBuffer(int index) const { return *_vertexBuffers[index]; }
 
 		inline bool HasIndices() const { return _hasIndices; }
-		inline uint32_t GetCount() const { return _hasIndices ? _indexBuffer->GetCount() : _vertexBuffers[0]->GetCount(); }
+		inline uint32_t GetCount() const { return _hasIndices ? GetIndexCount() : GetVertexCount(); }
+		inline uint32_t GetVertexCount() const { return HasSharedBuffers() ? _vertexCount : _vertexBuffers[0]->GetCount(); }
+		inline uint32_t GetIndexCount() const { return HasSharedBuffers() ? _indexCount : _indexBuffer->GetCount(); }
+		// Where the indices start in the index buffer, for draws
+		inline uint32_t GetFirstIndex() const { return _firstIndex; }
+
+		std::vector<uint8_t> GetRawVertexData(uint32_t stream) const;
+		std::shared_ptr<BufferReadback> ReadRawVertexDataAsync(uint32_t stream) const;
+		std::shared_ptr<BufferReadback> ReadRawIndexDataAsync() const;
+
+		template <typename T>
+		std::vector<T> GetVertexData(uint32_t stream) const {
+			std::vector<uint8_t> rawData = GetRawVertexData(stream);
+			std::vector<T> data(rawData.size() / sizeof(T));
+			std::memcpy(data.data(), rawData.data(), data.size() * sizeof(T));
+			return data;
+		}
+
+		// Unique for the lifetime of the program, unlike the GL name or the address
+		inline uint64_t GetUniqueId() const { return _uniqueId; }
 
 		inline DrawMode GetDrawMode() const { return _drawMode; }
 		inline void SetDrawMode(DrawMode mode) { _drawMode = mode; }
 
+		// Local space bounds of the positions, invalid if unknown
+		inline const BoundingBox& GetBounds() const { return _bounds; }
+		inline void SetBounds(const BoundingBox& bounds) { _bounds = bounds; }
+
+		// The bounds stay in local space, only the attributes are encoded
+		inline const VertexDecoding& GetVertexDecoding() const { return _vertexDecoding; }
+		inline void SetVertexDecoding(const VertexDecoding& decoding) { _vertexDecoding = decoding; }
+
 		bool show = true;
+	private:
+		// Into the currently bound vertex array
+		void setMeshAttributes();
+		// Returns the next free location
+		uint32_t setAttributes(uint32_t buffer, const VertexLayout& layout, uint32_t firstLocation, uint64_t baseOffset);
 	private:
 		uint32_t _id;
+		uint64_t _uniqueId;
 		std::vector<std::shared_ptr<VertexBufferObject>> _vertexBuffers;
+		std::vector<std::pair<std::shared_ptr<StreamingBuffer>, VertexLayout>> _streamingBuffers;
+
+		// Only set with shared buffers
+		std::shared_ptr<void> _sharedOwner;
+		uint32_t _baseVertex = 0;
+		uint32_t _firstIndex = 0;
+		uint32_t _vertexCount = 0;
+		uint32_t _indexCount = 0;
+
+		uint32_t _instancedId = 0;
+		std::shared_ptr<VertexBufferObject> _instanceBuffer;
+		uint32_t _instanceLocation = 0;
+		uint32_t _instanceOffset = 0;
 
 		bool _hasIndices;
 		std::shared_ptr<IndexBufferObject> _indexBuffer;
 		DrawMode _drawMode = DrawMode::Triangles;
+		BoundingBox _bounds;
+		VertexDecoding _vertexDecoding;
 	};
 }
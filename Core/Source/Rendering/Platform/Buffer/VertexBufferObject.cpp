@@ -1,16 +1,27 @@
 #include "VertexBufferObject.h"
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cstring>
+
+#include "Logging/Logging.h"
+
 using namespace Engine;
 
+VertexBufferStats VertexBufferObject::_stats{};
+
 VertexBufferObject::VertexBufferObject(BufferUsage usage, uint64_t initialCapacity)
-    : _id(0), _usage(usage), _count(0), _capacity(initialCapacity) {
+    : _id(0), _usage(usage), _count(0), _capacity(0) {
     glGenBuffers(1, &_id);
-    glBindBuffer(GL_ARRAY_BUFFER, _id);
-    glBufferData(GL_ARRAY_BUFFER, _capacity * sizeof(float), nullptr, static_cast<GLenum>(_usage));
+    _stats.buffers++;
+    if (initialCapacity > 0)
+        reallocate(initialCapacity);
 }
 
 VertexBufferObject::~VertexBufferObject() {
+    _stats.buffers--;
+    _stats.allocatedBytes -= _capacity;
+    _stats.usedBytes -= _usedSize;
     glDeleteBuffers(1, &_id);
 }
 
@@ -25,28 +36,119 @@ void VertexBufferObject::Unbind() const {
 void VertexBufferObject::SetData(const void* data, uint32_t count, const VertexLayout& layout) {
     _layout = layout;
     _count = count;
-    uint64_t requiredSize = count * layout.GetStride();
-
-    glBindBuffer(GL_ARRAY_BUFFER, _id);
+    uint64_t requiredSize = (uint64_t)count * layout.GetStride();
 
+    // Storage created at exactly the required size takes the data along, one call instead of two
+    bool uploaded = false;
     if (requiredSize > _capacity) {
-        // If the new data exceeds the current capacity, reallocate the buffer
-        _capacity = requiredSize;
-        glBufferData(GL_ARRAY_BUFFER, _capacity, nullptr, (GLenum)_usage);
+        _underusedUploads = 0;
+        uint64_t capacity = std::max(requiredSize, (uint64_t)(_capacity * GROWTH_FACTOR));
+        uploaded = capacity == requiredSize && data;
+        reallocate(capacity, uploaded ? data : nullptr);
+        _stats.reallocations++;
+    }
+    else if (requiredSize < _capacity / SHRINK_DIVISOR && ++_underusedUploads >= SHRINK_DELAY) {
+        _underusedUploads = 0;
+        reallocate(std::max(requiredSize * 2, (uint64_t)1));
+        _stats.shrinks++;
+    }
+    else {
+        if (requiredSize >= _capacity / SHRINK_DIVISOR)
+            _underusedUploads = 0;
+
+        // Fresh storage for the new contents, draws still reading the old contents are not waited for
+        if (_usage != BufferUsage::Static && requiredSize > 0) {
+            reallocate(_capacity);
+            _stats.orphans++;
+        }
     }
 
-    // Use glBufferSubData to update the buffer
-    glBufferSubData(GL_ARRAY_BUFFER, 0, requiredSize, data);
+    setUsedSize(requiredSize);
+    if (_shadowCopyEnabled) {
+        _shadowCopy.assign(requiredSize, 0);
+        if (data)
+            std::memcpy(_shadowCopy.data(), data, requiredSize);
+    }
+
+    if (data && requiredSize > 0) {
+        if (!uploaded) {
+            glBindBuffer(GL_ARRAY_BUFFER, _id);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, requiredSize, data);
+        }
+        _stats.uploadedBytes += requiredSize;
+    }
+}
+
+void VertexBufferObject::Allocate(uint32_t count, const VertexLayout& layout) {
+    _layout = layout;
+    _count = count;
+    _underusedUploads = 0;
+    reallocate((uint64_t)count * layout.GetStride());
+    setUsedSize((uint64_t)count * layout.GetStride());
+    if (_shadowCopyEnabled)
+        _shadowCopy.assign(_usedSize, 0);
 }
 
 void VertexBufferObject::UpdateSubData(const void* data, uint64_t offset, uint64_t size) {
+    if (offset + size > _capacity) {
+        ENGINE_ERROR("[VertexBufferObject::UpdateSubData] Writing {} bytes at {} overflows the {} byte buffer", size, offset, _capacity);
+        return;
+    }
+
     glBindBuffer(GL_ARRAY_BUFFER, _id);
     glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+    _stats.uploadedBytes += size;
+
+    if (_shadowCopyEnabled) {
+        if (_shadowCopy.size() < offset + size)
+            _shadowCopy.resize(offset + size, 0);
+        std::memcpy(_shadowCopy.data() + offset, data, size);
+    }
 }
 
-std::vector<uint8_t> Engine::VertexBufferObject::GetRawData() const {
-    std::vector<uint8_t> rawData(_count * _layout.GetStride());
+std::vector<uint8_t> Engine::VertexBufferObject::GetRawData(uint64_t offset, uint64_t size) const {
+    uint64_t dataSize = _shadowCopyEnabled ? std::min<uint64_t>(_shadowCopy.size(), _usedSize) : (uint64_t)_count * _layout.GetStride();
+    offset = std::min(offset, dataSize);
+    size = std::min(size, dataSize - offset);
+
+    if (_shadowCopyEnabled)
+        return std::vector<uint8_t>(_shadowCopy.begin() + offset, _shadowCopy.begin() + offset + size);
+
+    std::vector<uint8_t> rawData(size);
     Bind();
-    glGetBufferSubData(GL_ARRAY_BUFFER, 0, rawData.size(), rawData.data());
+    glGetBufferSubData(GL_ARRAY_BUFFER, offset, rawData.size(), rawData.data());
     return rawData;
-}
\ No newline at end of file
+}
+
+std::shared_ptr<BufferReadback> VertexBufferObject::ReadRawDataAsync(uint64_t offset, uint64_t size) const {
+    if (_shadowCopyEnabled)
+        return BufferReadback::FromData(GetRawData(offset, size));
+
+    uint64_t dataSize = (uint64_t)_count * _layout.GetStride();
+    offset = std::min(offset, dataSize);
+    return BufferReadback::Request(_id, offset, std::min(size, dataSize - offset));
+}
+
+void VertexBufferObject::SetShadowCopyEnabled(bool enabled) {
+    if (enabled == _shadowCopyEnabled)
+        return;
+
+    // Seeded from the GPU once, kept up to date by every write after that
+    _shadowCopy = enabled ? GetRawData() : std::vector<uint8_t>();
+    _shadowCopyEnabled = enabled;
+}
+
+void VertexBufferObject::reallocate(uint64_t capacity, const void* data) {
+    glBindBuffer(GL_ARRAY_BUFFER, _id);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)capacity, data, (GLenum)_usage);
+
+    _stats.allocatedBytes += capacity;
+    _stats.allocatedBytes -= _capacity;
+    _capacity = capacity;
+}
+
+void VertexBufferObject::setUsedSize(uint64_t size) {
+    _stats.usedBytes += size;
+    _stats.usedBytes -= _usedSize;
+    _usedSize = size;
+}
@@ -3,18 +3,29 @@
 #include <cstdint>
 #include <string>
 #include <vector>
+#include <memory>
 
 #include "BufferCommon.h"
+#include "BufferReadback.h"
 
 namespace Engine {
 	struct VertexComponent {
 		std::string Name;
 		LType Type;
 		uint32_t Count;
+		// 0 advances per vertex, N advances once every N instances
+		uint32_t Divisor = 0;
+		// Integer types read as [0, 1] (unsigned) or [-1, 1] (signed) instead of their integer value
+		bool Normalized = false;
 
 		uint32_t GetByteSize() const {
 			return (uint32_t)GetLTypeSize(Type) * Count;
 		}
+
+		// Matrices take one attribute location per column, eg. 16 floats is 4 locations of 4
+		uint32_t GetLocationCount() const {
+			return Count > 4 ? (Count + 3) / 4 : 1;
+		}
 	};
 
 	class VertexLayout {
@@ -49,9 +60,27 @@ namespace Engine {
 		std::vector<VertexComponent> _components;
 	};
 
+	// Totals over every live vertex buffer, in bytes
+	struct VertexBufferStats {
+		uint32_t buffers = 0;
+		uint64_t allocatedBytes = 0;
+		uint64_t usedBytes = 0;
+		uint64_t uploadedBytes = 0;
+		uint32_t reallocations = 0;
+		uint32_t shrinks = 0;
+		uint32_t orphans = 0;
+	};
+
+	// Capacity grows geometrically so that data growing a little every frame only reallocates a few times,
+	// and only shrinks after staying well below capacity for a while. Buffers that are not Static are
+	// orphaned before being rewritten so the driver can hand out fresh storage instead of waiting for the GPU.
 	class VertexBufferObject {
 	public:
 		static const uint64_t DEFAULT_INITIAL_CAPACITY = 1000 * sizeof(float) * 4;
+		static constexpr float GROWTH_FACTOR = 1.5f;
+		// Shrink to twice the used size once less than a quarter is used for this many uploads in a row
+		static const uint32_t SHRINK_DIVISOR = 4;
+		static const uint32_t SHRINK_DELAY = 120;
 
 		VertexBufferObject(BufferUsage usage = BufferUsage::Static, uint64_t initialCapacity = DEFAULT_INITIAL_CAPACITY);
 		~VertexBufferObject();
@@ -63,13 +92,27 @@ namespace Engine {
 		void Unbind() const;
 
 		void SetData(const void* data, uint32_t count, const VertexLayout& layout);
+		// Allocates storage for count vertices without uploading anything
+		void Allocate(uint32_t count, const VertexLayout& layout);
 		void UpdateSubData(const void* data, uint64_t offset, uint64_t size);
 
 		inline const VertexLayout& GetLayout() const { return _layout; }
 		inline uint32_t GetCount() const { return _count; }
+		// In bytes
 		inline uint64_t GetCapacity() const { return _capacity; }
+		inline uint64_t GetSize() const { return _usedSize; }
+		inline uint32_t GetHandle() const { return _id; }
+
+		// Returns the shadow copy when there is one, otherwise blocks until the GPU has caught up.
+		// Both reads cover the whole buffer by default, ranges are in bytes and clamped to the data.
+		std::vector<uint8_t> GetRawData(uint64_t offset = 0, uint64_t size = UINT64_MAX) const;
+		// Starts copying the data back without stalling, poll the returned handle
+		std::shared_ptr<BufferReadback> ReadRawDataAsync(uint64_t offset = 0, uint64_t size = UINT64_MAX) const;
 
-		std::vector<uint8_t> GetRawData() const;
+		// Keep a CPU copy of everything written through SetData and UpdateSubData, for buffers that are read back often.
+		// Writes made directly on the GPU (eg. buffer copies) are not seen by the copy.
+		void SetShadowCopyEnabled(bool enabled);
+		inline bool HasShadowCopy() const { return _shadowCopyEnabled; }
 
 		template <typename T>
 		std::vector<T> GetData() const {
@@ -79,11 +122,24 @@ namespace Engine {
 			std::memcpy(data.data(), rawData.data(), rawData.size());
 			return data;
 		}
+
+		static const VertexBufferStats& GetStats() { return _stats; }
+	private:
+		// Replaces the storage, the old contents are lost. data fills the new storage when given.
+		void reallocate(uint64_t capacity, const void* data = nullptr);
+		void setUsedSize(uint64_t size);
 	private:
 		uint32_t _id;
 		BufferUsage _usage;
 		VertexLayout _layout;
 		uint32_t _count;
 		uint64_t _capacity;
+		uint64_t _usedSize = 0;
+		uint32_t _underusedUploads = 0;
+
+		bool _shadowCopyEnabled = false;
+		std::vector<uint8_t> _shadowCopy;
+
+		static VertexBufferStats _stats;
 	};
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "ImageFormat.h"
 #include <glad/glad.h>
 #include "Logging/Logging.h"
+#include "Rendering/GLExtensions.h"
+
+#include <algorithm>
 
 using namespace Engine;
 
@@ -25,6 +28,7 @@ uint32_t Utils::ImageFormatToOpenGLDataFormat(ImageFormat format) {
     case ImageFormat::RG8UI:
     case ImageFormat::RG16UI:
     case ImageFormat::RG32UI:
+    case ImageFormat::BC5:
         return GL_RG;
     case ImageFormat::RGB8:
     case ImageFormat::RGB16F:
@@ -35,6 +39,7 @@ uint32_t Utils::ImageFormatToOpenGLDataFormat(ImageFormat format) {
     case ImageFormat::RGB8UI:
     case ImageFormat::RGB16UI:
     case ImageFormat::RGB32UI:
+    case ImageFormat::BC1:
         return GL_RGB;
     case ImageFormat::RGBA8:
     case ImageFormat::RGBA16F:
@@ -45,6 +50,8 @@ uint32_t Utils::ImageFormatToOpenGLDataFormat(ImageFormat format) {
     case ImageFormat::RGBA8UI:
     case ImageFormat::RGBA16UI:
     case ImageFormat::RGBA32UI:
+    case ImageFormat::BC3:
+    case ImageFormat::BC7:
         return GL_RGBA;
     case ImageFormat::D16:
     case ImageFormat::D24:
@@ -101,6 +108,10 @@ uint32_t Utils::ImageFormatToOpenGLInternalFormat(ImageFormat format) {
     case ImageFormat::D32F:     return GL_DEPTH_COMPONENT32F;
     case ImageFormat::D24S8:    return GL_DEPTH24_STENCIL8;
     case ImageFormat::D32FS8:   return GL_DEPTH32F_STENCIL8;
+    case ImageFormat::BC1:      return GLExtensions::COMPRESSED_RGB_S3TC_DXT1;
+    case ImageFormat::BC3:      return GLExtensions::COMPRESSED_RGBA_S3TC_DXT5;
+    case ImageFormat::BC5:      return GL_COMPRESSED_RG_RGTC2;
+    case ImageFormat::BC7:      return GLExtensions::COMPRESSED_RGBA_BPTC_UNORM;
     }
     ENGINE_ASSERT(false, "[ImageFormatToOpenGLInternalFormat] Invalid image format!");
     return 0;
@@ -112,6 +123,10 @@ uint32_t Utils::ImageFormatToOpenGLDataType(ImageFormat format) {
     case ImageFormat::RG8:
     case ImageFormat::RGB8:
     case ImageFormat::RGBA8:
+    case ImageFormat::BC1:
+    case ImageFormat::BC3:
+    case ImageFormat::BC5:
+    case ImageFormat::BC7:
         return GL_UNSIGNED_BYTE;
     case ImageFormat::R16F:
     case ImageFormat::RG16F:
@@ -165,3 +180,105 @@ uint32_t Utils::ImageFormatToOpenGLDataType(ImageFormat format) {
     ENGINE_ASSERT(false, "[ImageFormatToOpenGLDataType] Invalid image format!");
     return 0;
 }
+
+
+uint32_t Utils::ImageFormatChannelCount(ImageFormat format) {
+    switch (ImageFormatToOpenGLDataFormat(format)) {
+    case GL_RED:
+    case GL_DEPTH_COMPONENT:
+        return 1;
+    case GL_RG:
+    case GL_DEPTH_STENCIL:
+        return 2;
+    case GL_RGB:
+        return 3;
+    case GL_RGBA:
+        return 4;
+    }
+    return 0;
+}
+
+uint32_t Utils::ImageFormatDataSize(ImageFormat format) {
+    if (ImageFormatIsCompressed(format))
+        return 0;
+
+    switch (ImageFormatToOpenGLDataType(format)) {
+    case GL_UNSIGNED_BYTE:
+    case GL_BYTE:
+        return ImageFormatChannelCount(format);
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+        return ImageFormatChannelCount(format) * 2;
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+    case GL_FLOAT:
+        return ImageFormatChannelCount(format) * 4;
+    case GL_UNSIGNED_INT_24_8:
+        return 4;
+    case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+        return 8;
+    }
+    return 0;
+}
+
+bool Utils::ImageFormatIsCompressed(ImageFormat format) {
+    return ImageFormatBlockSize(format) != 0;
+}
+
+uint32_t Utils::ImageFormatBlockSize(ImageFormat format) {
+    switch (format) {
+    case ImageFormat::BC1:
+        return 8;
+    case ImageFormat::BC3:
+    case ImageFormat::BC5:
+    case ImageFormat::BC7:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+uint64_t Utils::ImageFormatLevelSize(ImageFormat format, uint32_t width, uint32_t height) {
+    if (ImageFormatIsCompressed(format))
+        return (uint64_t)((width + 3) / 4) * ((height + 3) / 4) * ImageFormatBlockSize(format);
+    return (uint64_t)width * height * ImageFormatDataSize(format);
+}
+
+uint64_t Utils::ImageFormatStorageSize(ImageFormat format, uint32_t width, uint32_t height) {
+    if (ImageFormatIsCompressed(format))
+        return ImageFormatLevelSize(format, width, height);
+
+    uint32_t channelSize;
+    switch (format) {
+    case ImageFormat::R16F:
+    case ImageFormat::RG16F:
+    case ImageFormat::RGB16F:
+    case ImageFormat::RGBA16F:
+        channelSize = 2;
+        break;
+    case ImageFormat::D24:
+    case ImageFormat::D24S8:
+    case ImageFormat::D32F:
+        return (uint64_t)width * height * 4;
+    case ImageFormat::D32FS8:
+        return (uint64_t)width * height * 8;
+    default:
+        channelSize = ImageFormatDataSize(format) / std::max(ImageFormatChannelCount(format), 1u);
+        break;
+    }
+
+    uint32_t channels = ImageFormatChannelCount(format);
+    return (uint64_t)width * height * (channels == 3 ? 4 : channels) * channelSize;
+}
+
+bool Utils::ImageFormatIsSupported(ImageFormat format) {
+    switch (format) {
+    case ImageFormat::BC1:
+    case ImageFormat::BC3:
+        return GLExtensions::HasS3TC();
+    case ImageFormat::BC7:
+        return GLExtensions::HasBPTC();
+    default:
+        return true;
+    }
+}
\ No newline at end of file
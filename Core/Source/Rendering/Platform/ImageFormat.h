@@ -49,11 +49,11 @@ namespace Engine {
         D32F,
         D24S8,
         D32FS8,
-        // Compressed formats (if needed)
-        // DXT1,
-        // DXT3,
-        // DXT5,
-        // etc.
+        // Block compressed formats, 4x4 texel blocks
+        BC1,    // RGB, 8 bytes per block
+        BC3,    // RGBA, 16 bytes per block
+        BC5,    // RG, 16 bytes per block, for tangent space normals
+        BC7,    // RGBA, 16 bytes per block, higher quality than BC1/BC3
     };
 
     namespace Utils {
@@ -62,5 +62,25 @@ namespace Engine {
         uint32_t ImageFormatToOpenGLInternalFormat(ImageFormat format);
 
         uint32_t ImageFormatToOpenGLDataType(ImageFormat format);
+
+        uint32_t ImageFormatChannelCount(ImageFormat format);
+
+        // Bytes per pixel of the client side data passed when uploading, not of the GPU storage. 0 for compressed formats.
+        uint32_t ImageFormatDataSize(ImageFormat format);
+
+        bool ImageFormatIsCompressed(ImageFormat format);
+
+        // Bytes per 4x4 block of a compressed format
+        uint32_t ImageFormatBlockSize(ImageFormat format);
+
+        // Bytes of client data for one level of one face, whole blocks for compressed formats
+        uint64_t ImageFormatLevelSize(ImageFormat format, uint32_t width, uint32_t height);
+
+        // Bytes the GPU keeps for one level of one face. Three channel formats are counted as four since
+        // drivers pad them, so this is an estimate rather than what the driver reports.
+        uint64_t ImageFormatStorageSize(ImageFormat format, uint32_t width, uint32_t height);
+
+        // False for compressed formats the driver cannot sample
+        bool ImageFormatIsSupported(ImageFormat format);
     }
 }
\ No newline at end of file
@@ -1,19 +1,35 @@
 #include "Material.h"
 
+#include <cstring>
+#include "Logging/Logging.h"
+
 using namespace Engine;
 
 // Material implementation
 
 Material::Material(std::shared_ptr<Shader> shader)
 	: _shader(shader) {
+	setupMaterialBlock();
 	SetDefaultUniformsAndTextures(*shader);
 }
 
 void Material::Bind() const {
-	for (const auto& [name, value] : _uniformMap) {
-		std::visit([&, name = name](auto&& value) {
-			_shader->SetUniform(name, value);
-		}, value);
+	_shader->Bind();
+
+	if (_materialUbo) {
+		uint32_t size = (uint32_t)_materialData.size();
+		if (_materialDataDirty) {
+			_materialUbo->SetData(_materialData.data(), size);
+			_materialDataDirty = false;
+		}
+		_materialUbo->BindRange(MATERIAL_DATA_BINDING_POINT, 0, size);
+	}
+
+	for (const auto& uniform : _uniforms) {
+		if (!uniform.handle.IsValid() || uniform.blockMember) continue;
+		std::visit([&](auto&& value) {
+			_shader->SetUniform(uniform.handle, value);
+		}, uniform.value);
 	}
 
 	for (const auto& [name, uniformTexture] : _textureMap) {
@@ -30,6 +46,12 @@ void Material::SetShader(std::shared_ptr<Shader> shader) {
 	if (_shader == shader) return;
 
 	_shader = shader;
+	setupMaterialBlock();
+
+	// Re-resolve existing uniforms against the new shader
+	for (auto& uniform : _uniforms)
+		resolveUniform(uniform);
+
 	SetDefaultUniformsAndTextures(*shader);
 }
 
@@ -68,21 +90,34 @@ std::vector<std::string> Engine::Material::GetTextureNames() const {
 }
 
 void Material::SetUniform(const std::string& name, UniformValue value) {
-	_uniformMap[name] = value;
+	auto it = _uniformIndices.find(name);
+	if (it != _uniformIndices.end()) {
+		auto& uniform = _uniforms[it->second];
+		if (uniform.value == value) return;
+
+		uniform.value = value;
+		if (uniform.blockMember)
+			writeMaterialData(uniform);
+		return;
+	}
+
+	_uniformIndices[name] = (uint32_t)_uniforms.size();
+	_uniforms.push_back({ name, {}, value });
+	resolveUniform(_uniforms.back());
 }
 
 std::optional<UniformValue> Material::GetUniformValue(const std::string& name) const {
-	auto it = _uniformMap.find(name);
-	if (it != _uniformMap.end()) {
-		return it->second;
+	auto it = _uniformIndices.find(name);
+	if (it != _uniformIndices.end()) {
+		return _uniforms[it->second].value;
 	}
 	return std::nullopt;
 }
 
 std::vector<std::string> Material::GetUniformNames() const {
 	std::vector<std::string> names;
-	for (const auto& [name, _] : _uniformMap) {
-		names.push_back(name);
+	for (const auto& uniform : _uniforms) {
+		names.push_back(uniform.name);
 	}
 	return names;
 }
@@ -90,7 +125,13 @@ std::vector<std::string> Material::GetUniformNames() const {
 void Material::SetDefaultUniformsAndTextures(Shader& shader) {
 	auto& uniforms = shader.GetUniformInfos();
 	uint32_t textureIndex = 0;
-	for (const auto& [name, info] : uniforms) {
+	for (const auto& info : uniforms) {
+		const std::string& name = info.name;
+
+		// Members of other blocks (eg. camera data) are fed by the render pipeline, not the material
+		if (info.blockIndex >= 0 && info.blockIndex != _materialBlockIndex)
+			continue;
+
 		if (info.type == UniformType::Sampler2D || info.type == UniformType::SamplerCube) {
 			_textureMap[info.name] = { nullptr, textureIndex };
 			shader.SetUniform(info.name, (int)textureIndex);
@@ -99,33 +140,89 @@ void Material::SetDefaultUniformsAndTextures(Shader& shader) {
 		else {
 			switch (info.type) {
 			case UniformType::Bool:
-				_uniformMap[name] = false;
+				SetUniform(name, false);
 				break;
 			case UniformType::Int:
-				_uniformMap[name] = 0;
+				SetUniform(name, 0);
 				break;
 			case UniformType::Float:
-				_uniformMap[name] = 0.0f;
+				SetUniform(name, 0.0f);
 				break;
 			case UniformType::Vec2:
-				_uniformMap[name] = glm::vec2(0.0f);
+				SetUniform(name, glm::vec2(0.0f));
 				break;
 			case UniformType::Vec3:
-				_uniformMap[name] = glm::vec3(0.0f);
+				SetUniform(name, glm::vec3(0.0f));
 				break;
 			case UniformType::Vec4:
-				_uniformMap[name] = glm::vec4(0.0f);
+				SetUniform(name, glm::vec4(0.0f));
 				break;
 			case UniformType::Mat2:
-				_uniformMap[name] = glm::mat2(1.0f);
+				SetUniform(name, glm::mat2(1.0f));
 				break;
 			case UniformType::Mat3:
-				_uniformMap[name] = glm::mat3(1.0f);
+				SetUniform(name, glm::mat3(1.0f));
 				break;
 			case UniformType::Mat4:
-				_uniformMap[name] = glm::mat4(1.0f);
+				SetUniform(name, glm::mat4(1.0f));
 				break;
 			}
 		}
 	}
 }
+
+void Material::setupMaterialBlock() {
+	_materialBlockIndex = -1;
+	_materialData.clear();
+	_materialUbo = nullptr;
+
+	const UniformBlockInfo* block = _shader->GetUniformBlockInfo(MATERIAL_DATA_BLOCK_NAME);
+	if (block == nullptr)
+		return;
+
+	_shader->BindUniformBlock(MATERIAL_DATA_BLOCK_NAME, MATERIAL_DATA_BINDING_POINT);
+
+	_materialBlockIndex = (int32_t)block->index;
+	_materialData.assign(block->size, 0);
+	_materialUbo = std::make_shared<UniformBufferObject>(block->size, MATERIAL_DATA_BINDING_POINT, BufferUsage::Dynamic);
+	_materialDataDirty = true;
+}
+
+void Material::resolveUniform(MaterialUniform& uniform) {
+	uniform.handle = _shader->GetUniformHandle(uniform.name);
+	uniform.blockMember = uniform.handle.IsValid() && _materialBlockIndex >= 0
+		&& _shader->GetUniformInfo(uniform.handle).blockIndex == _materialBlockIndex;
+
+	if (uniform.blockMember)
+		writeMaterialData(uniform);
+}
+
+void Material::writeMaterialData(const MaterialUniform& uniform) {
+	const UniformInfo& info = _shader->GetUniformInfo(uniform.handle);
+
+	// UniformValue alternatives are declared in the same order as UniformType
+	if (uniform.value.index() != (size_t)info.type) {
+		ENGINE_WARN("[Material::writeMaterialData] Value of uniform '{}' does not match its type in the shader", uniform.name);
+		return;
+	}
+
+	uint8_t* dst = _materialData.data() + info.blockOffset;
+	std::visit([&](auto&& value) {
+		using T = std::decay_t<decltype(value)>;
+		if constexpr (std::is_same_v<T, bool>) {
+			// std140 bools are 4 bytes
+			int32_t intValue = value ? 1 : 0;
+			memcpy(dst, &intValue, sizeof(int32_t));
+		}
+		else if constexpr (std::is_same_v<T, glm::mat2> || std::is_same_v<T, glm::mat3> || std::is_same_v<T, glm::mat4>) {
+			// Matrix columns are padded out to the matrix stride
+			for (int c = 0; c < T::length(); c++)
+				memcpy(dst + c * info.matrixStride, &value[c], sizeof(value[c]));
+		}
+		else {
+			memcpy(dst, &value, sizeof(T));
+		}
+	}, uniform.value);
+
+	_materialDataDirty = true;
+}
@@ -10,6 +10,7 @@
 
 #include "Shader.h"
 #include "Texture2D.h"
+#include "Buffer/UniformBufferObject.h"
 
 namespace Engine {
 	using UniformValue = std::variant<bool, int, float, glm::vec2, glm::vec3, glm::vec4, glm::mat2, glm::mat3, glm::mat4>;
@@ -23,8 +24,14 @@ namespace Engine {
 		virtual void Unbind() const = 0;
 	};
 
+	// Parameters declared in a std140 block named MaterialData (without an instance name) are packed into
+	// a per material uniform buffer, which is only re-uploaded after a change. Everything else is set as a
+	// plain uniform on every bind.
 	class Material : public IRenderableMaterial {
 	public:
+		static const uint32_t MATERIAL_DATA_BINDING_POINT = 1;
+		static constexpr const char* MATERIAL_DATA_BLOCK_NAME = "MaterialData";
+
 		Material(std::shared_ptr<Shader> shader);
 		~Material() override = default;
 
@@ -50,8 +57,21 @@ namespace Engine {
 		void SetDefaultUniformsAndTextures(Shader& shader);
 
 	protected:
+		// Uniform values are kept in a flat array with their handle pre-resolved against the current shader
+		struct MaterialUniform { std::string name; UniformHandle handle; UniformValue value; bool blockMember = false; };
+
 		std::shared_ptr<Shader> _shader;
-		std::unordered_map<std::string, UniformValue> _uniformMap;
+		std::vector<MaterialUniform> _uniforms;
+		std::unordered_map<std::string, uint32_t> _uniformIndices;
 		std::unordered_map<std::string, UniformTexture> _textureMap;
+
+		int32_t _materialBlockIndex = -1;
+		std::vector<uint8_t> _materialData;
+		std::shared_ptr<UniformBufferObject> _materialUbo;
+		mutable bool _materialDataDirty = false;
+	private:
+		void setupMaterialBlock();
+		void resolveUniform(MaterialUniform& uniform);
+		void writeMaterialData(const MaterialUniform& uniform);
 	};
 }
@@ -4,4 +4,55 @@ using namespace Engine;
 
 void Mesh::AddSubmesh(std::shared_ptr<VertexArrayObject> submesh) {
 	_submeshes.push_back(submesh);
+
+	if (!submesh->GetBounds().IsValid())
+		_hasUnknownBounds = true;
+
+	if (_hasUnknownBounds)
+		_bounds = BoundingBox();
+	else
+		_bounds.GrowToInclude(submesh->GetBounds());
+}
+
+void Mesh::SetShadowCopyEnabled(bool enabled) {
+	for (const auto& submesh : _submeshes)
+		submesh->SetShadowCopyEnabled(enabled);
+}
+
+
+std::shared_ptr<Mesh> Mesh::Utils::FromMeshFile(const MeshFile& file) {
+	auto mesh = std::make_shared<Mesh>();
+	for (uint32_t i = 0; i < file.GetSubmeshCount(); i++)
+		mesh->AddSubmesh(CreateSubmesh(file.GetSubmesh(i)));
+	return mesh;
 }
+
+std::shared_ptr<Mesh> Mesh::Utils::FromMeshFileData(const MeshFileData& data) {
+	auto mesh = std::make_shared<Mesh>();
+	for (const auto& submesh : data.submeshes)
+		mesh->AddSubmesh(CreateSubmesh(submesh.GetView()));
+	return mesh;
+}
+
+std::shared_ptr<VertexArrayObject> Mesh::Utils::CreateSubmesh(const SubmeshView& submesh) {
+	auto vao = std::make_shared<VertexArrayObject>();
+
+	for (const auto& stream : submesh.streams) {
+		// No initial capacity, so the storage is created with the data in a single glBufferData
+		auto vbo = std::make_shared<VertexBufferObject>(BufferUsage::Static, 0);
+		vbo->SetData(stream.data, stream.vertexCount, stream.layout);
+		vao->AddVertexBuffer(vbo);
+	}
+
+	if (submesh.indexCount > 0) {
+		auto ibo = std::make_shared<IndexBufferObject>();
+		ibo->SetData(submesh.indices, submesh.indexType, submesh.indexCount);
+		vao->SetIndexBuffer(ibo);
+	}
+
+	vao->Compute();
+	vao->SetDrawMode(submesh.drawMode);
+	vao->SetBounds(submesh.bounds);
+	vao->SetVertexDecoding(submesh.decoding);
+	return vao;
+}
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <memory>
 
 #include "Rendering/Platform/Buffer/VertexArrayObject.h"
+#include "Util/Math/BoundingBox.h"
+#include "Util/Mesh/MeshFile.h"
 
 namespace Engine {
 	class Mesh {
@@ -21,8 +23,24 @@ namespace Engine {
 
 		inline uint32_t GetSubmeshCount() const { return (uint32_t)_submeshes.size(); }
 		inline const VertexArrayObject& GetSubmesh(int index) const { return *_submeshes[index]; }
+		inline VertexArrayObject& GetSubmesh(int index) { return *_submeshes[index]; }
+
+		// Union of the submesh bounds, invalid if any submesh has unknown bounds
+		inline const BoundingBox& GetBounds() const { return _bounds; }
+
+		// Keeps a CPU copy of every submesh buffer, for meshes that are exported or picked often
+		void SetShadowCopyEnabled(bool enabled);
+
+		struct Utils {
+			// One vertex array per submesh, every stream and index list uploaded straight from the mapping
+			static std::shared_ptr<Mesh> FromMeshFile(const MeshFile& file);
+			static std::shared_ptr<Mesh> FromMeshFileData(const MeshFileData& data);
+			static std::shared_ptr<VertexArrayObject> CreateSubmesh(const SubmeshView& submesh);
+		};
 	private:
 		std::string _name;
 		std::vector<std::shared_ptr<VertexArrayObject>> _submeshes;
+		BoundingBox _bounds;
+		bool _hasUnknownBounds = false;
 	};
 }
\ No newline at end of file
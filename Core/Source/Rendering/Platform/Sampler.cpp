@@ -0,0 +1,94 @@
+#include "Sampler.h"
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Rendering/GLExtensions.h"
+#include "Rendering/GLStateCache.h"
+#include "Logging/Logging.h"
+
+using namespace Engine;
+
+static uint32_t TextureWrapToOpenGLWrap(TextureWrap wrap) {
+	switch (wrap) {
+	case TextureWrap::Repeat: return GL_REPEAT;
+	case TextureWrap::MirroredRepeat: return GL_MIRRORED_REPEAT;
+	case TextureWrap::ClampToEdge: return GL_CLAMP_TO_EDGE;
+	case TextureWrap::ClampToBorder: return GL_CLAMP_TO_BORDER;
+	}
+
+	ENGINE_ERROR("[TextureWrapToOpenGLWrap] Unsupported texture wrap");
+	return GL_REPEAT;
+}
+
+static uint32_t MinFilterToOpenGLFilter(TextureFilter filter, MipmapFilter mipFilter) {
+	bool linear = filter == TextureFilter::Linear;
+	switch (mipFilter) {
+	case MipmapFilter::None: return linear ? GL_LINEAR : GL_NEAREST;
+	case MipmapFilter::Nearest: return linear ? GL_LINEAR_MIPMAP_NEAREST : GL_NEAREST_MIPMAP_NEAREST;
+	case MipmapFilter::Linear: return linear ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR;
+	}
+
+	ENGINE_ERROR("[MinFilterToOpenGLFilter] Unsupported mipmap filter");
+	return GL_LINEAR;
+}
+
+Sampler::Sampler(const SamplerSpec& spec)
+	: _id(0), _spec(spec) {
+	glGenSamplers(1, &_id);
+
+	glSamplerParameteri(_id, GL_TEXTURE_MIN_FILTER, MinFilterToOpenGLFilter(spec.minFilter, spec.mipFilter));
+	glSamplerParameteri(_id, GL_TEXTURE_MAG_FILTER, spec.magFilter == TextureFilter::Linear ? GL_LINEAR : GL_NEAREST);
+	glSamplerParameteri(_id, GL_TEXTURE_WRAP_S, TextureWrapToOpenGLWrap(spec.wrapS));
+	glSamplerParameteri(_id, GL_TEXTURE_WRAP_T, TextureWrapToOpenGLWrap(spec.wrapT));
+	glSamplerParameteri(_id, GL_TEXTURE_WRAP_R, TextureWrapToOpenGLWrap(spec.wrapR));
+	glSamplerParameterf(_id, GL_TEXTURE_LOD_BIAS, spec.lodBias);
+
+	if (GLExtensions::HasAnisotropicFiltering()) {
+		float anisotropy = std::clamp(spec.maxAnisotropy, 1.0f, GLExtensions::GetMaxAnisotropy());
+		glSamplerParameterf(_id, GLExtensions::TEXTURE_MAX_ANISOTROPY, anisotropy);
+	}
+}
+
+Sampler::~Sampler() {
+	GLStateCache::OnSamplerDeleted(_id);
+	glDeleteSamplers(1, &_id);
+}
+
+void Sampler::Bind(uint32_t unit) const {
+	GLStateCache::BindSampler(unit, _id);
+}
+
+std::shared_ptr<Sampler> Sampler::Utils::Get(const SamplerSpec& spec) {
+	// Only a handful of specs are ever in use, a linear search is enough. Weak references let the
+	// samplers go with the last texture using them instead of outliving the context.
+	static std::vector<std::weak_ptr<Sampler>> samplers;
+
+	for (auto it = samplers.begin(); it != samplers.end();) {
+		auto sampler = it->lock();
+		if (!sampler) {
+			it = samplers.erase(it);
+			continue;
+		}
+		if (sampler->GetSpec() == spec)
+			return sampler;
+		++it;
+	}
+
+	auto sampler = std::make_shared<Sampler>(spec);
+	samplers.push_back(sampler);
+	return sampler;
+}
+
+SamplerSpec Sampler::Utils::Default() {
+	return SamplerSpec{};
+}
+
+SamplerSpec Sampler::Utils::Clamped() {
+	SamplerSpec spec;
+	spec.mipFilter = MipmapFilter::None;
+	spec.wrapS = spec.wrapT = spec.wrapR = TextureWrap::ClampToEdge;
+	spec.maxAnisotropy = 1.0f;
+	return spec;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+namespace Engine {
+	enum class TextureFilter {
+		Nearest,
+		Linear
+	};
+
+	enum class MipmapFilter {
+		None,    // Only the base level is sampled
+		Nearest,
+		Linear
+	};
+
+	enum class TextureWrap {
+		Repeat,
+		MirroredRepeat,
+		ClampToEdge,
+		ClampToBorder
+	};
+
+	struct SamplerSpec {
+		TextureFilter minFilter = TextureFilter::Linear;
+		TextureFilter magFilter = TextureFilter::Linear;
+		MipmapFilter mipFilter = MipmapFilter::Linear;
+		TextureWrap wrapS = TextureWrap::Repeat;
+		TextureWrap wrapT = TextureWrap::Repeat;
+		TextureWrap wrapR = TextureWrap::Repeat;
+		float maxAnisotropy = 16.0f; // Clamped to what the driver supports, 1 disables anisotropic filtering
+		float lodBias = 0.0f;
+
+		bool operator==(const SamplerSpec& other) const {
+			return minFilter == other.minFilter && magFilter == other.magFilter && mipFilter == other.mipFilter &&
+				wrapS == other.wrapS && wrapT == other.wrapT && wrapR == other.wrapR &&
+				maxAnisotropy == other.maxAnisotropy && lodBias == other.lodBias;
+		}
+	};
+
+	// Filtering and wrapping state kept apart from the textures, so every texture sampled the same way
+	// shares one GL object and switching textures does not touch their parameters.
+	class Sampler {
+	public:
+		Sampler(const SamplerSpec& spec);
+		~Sampler();
+
+		Sampler(const Sampler&) = delete;
+		Sampler& operator=(const Sampler&) = delete;
+
+		void Bind(uint32_t unit) const;
+
+		inline uint32_t GetInstanceID() const { return _id; }
+		inline const SamplerSpec& GetSpec() const { return _spec; }
+
+		struct Utils {
+			// Returns the sampler already created for this spec if one is still alive
+			static std::shared_ptr<Sampler> Get(const SamplerSpec& spec);
+
+			// Trilinear, anisotropic and repeating, for material textures
+			static SamplerSpec Default();
+			// Bilinear and clamped, for cubemaps and render targets
+			static SamplerSpec Clamped();
+		};
+	private:
+		uint32_t _id;
+		SamplerSpec _spec;
+	};
+}
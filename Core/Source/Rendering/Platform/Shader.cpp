@@ -3,6 +3,8 @@
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "Rendering/GLStateCache.h"
+
 using namespace Engine;
 
 uint32_t ShaderTypeToOpenGLType(ShaderStage type) {
@@ -20,6 +22,7 @@ Shader::Shader() {
 }
 
 Shader::~Shader() {
+	GLStateCache::OnProgramDeleted(_id);
 	glDeleteProgram(_id);
 }
 
@@ -49,11 +52,11 @@ void Shader::Link() {
 }
 
 void Shader::Bind() const {
-	glUseProgram(_id);
+	GLStateCache::UseProgram(_id);
 }
 
 void Shader::Unbind() const {
-	glUseProgram(0);
+	GLStateCache::UseProgram(0);
 }
 
 std::vector<ShaderStage> Engine::Shader::GetAttachedTypes() const {
@@ -82,6 +85,28 @@ uint32_t Shader::compileShader(uint32_t type, const char* source) {
 }
 
 void Shader::preloadUniforms() {
+	_uniforms.clear();
+	_uniformIndices.clear();
+	_uniformBlockInfos.clear();
+
+	int32_t numBlocks = 0;
+	glGetProgramiv(_id, GL_ACTIVE_UNIFORM_BLOCKS, &numBlocks);
+	int32_t maxBlockNameLength = 0;
+	glGetProgramiv(_id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+
+	std::vector<char> blockNameBuffer(maxBlockNameLength);
+	for (uint32_t i = 0; i < (uint32_t)numBlocks; i++) {
+		GLsizei nameLength = 0;
+		GLint dataSize = 0;
+		glGetActiveUniformBlockName(_id, i, maxBlockNameLength, &nameLength, blockNameBuffer.data());
+		glGetActiveUniformBlockiv(_id, i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+		_uniformBlockInfos.push_back(UniformBlockInfo{
+			std::string(blockNameBuffer.data(), nameLength),
+			i,
+			(uint32_t)dataSize
+		});
+	}
+
 	int32_t numUniforms = 0;
 	glGetProgramiv(_id, GL_ACTIVE_UNIFORMS, &numUniforms);
 	int32_t maxUniformNameLength = 0;
@@ -95,7 +120,7 @@ void Shader::preloadUniforms() {
 		glGetActiveUniform(_id, i, maxUniformNameLength, &nameLength, &size, &type, uniformNameBuffer.data());
 
 		std::string uniformName(uniformNameBuffer.data(), nameLength);
-		uint32_t location = glGetUniformLocation(_id, uniformName.c_str());
+		int32_t location = glGetUniformLocation(_id, uniformName.c_str());
 
 		UniformType utype;
 		switch (type) {
@@ -115,86 +140,143 @@ void Shader::preloadUniforms() {
 			utype = UniformType::Int;
 		}
 
-		_uniformsMap[uniformName] = UniformInfo{
+		GLint blockIndex = -1, blockOffset = -1, matrixStride = 0;
+		glGetActiveUniformsiv(_id, 1, &i, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+		glGetActiveUniformsiv(_id, 1, &i, GL_UNIFORM_OFFSET, &blockOffset);
+		glGetActiveUniformsiv(_id, 1, &i, GL_UNIFORM_MATRIX_STRIDE, &matrixStride);
+
+		_uniformIndices[uniformName] = (int32_t)_uniforms.size();
+		_uniforms.push_back(UniformInfo{
 			uniformName,
 			location,
-			utype
-		};
+			utype,
+			blockIndex,
+			blockOffset,
+			matrixStride
+		});
 	}
 }
 
-// Checks if uniform exists
-bool Shader::uniformExists(const std::string& name) {
-	if (_uniformsMap.find(name) == _uniformsMap.end()) {
-		ENGINE_ERROR("[Shader::uniformExists] Uniform {} not found!", name);
-		return false;
-	}
-	return true;
+UniformHandle Shader::GetUniformHandle(const std::string& name) const {
+	auto it = _uniformIndices.find(name);
+	if (it == _uniformIndices.end())
+		return {};
+	return { it->second };
 }
 
-// Requires name to exist
-int Shader::getUniformLocation(const std::string& name) {
-	return _uniformsMap[name].location;
+// Logs if the uniform does not exist
+UniformHandle Shader::findUniform(const std::string& name) {
+	UniformHandle handle = GetUniformHandle(name);
+	if (!handle.IsValid())
+		ENGINE_ERROR("[Shader::findUniform] Uniform {} not found!", name);
+	return handle;
 }
 
-#define CHECK_UNIFORM_EXISTS {if (!uniformExists(name)) return false; else glUseProgram(_id);}
+#define RESOLVE_UNIFORM_HANDLE UniformHandle handle = findUniform(name); if (!handle.IsValid()) return false; else Bind();
 
 bool Shader::SetUniform(const std::string& name, bool value) {
-	CHECK_UNIFORM_EXISTS;
-	glUniform1i(getUniformLocation(name), value);
-	return true;
+	RESOLVE_UNIFORM_HANDLE;
+	return SetUniform(handle, value);
 }
 
 bool Shader::SetUniform(const std::string& name, int value) {
-	CHECK_UNIFORM_EXISTS;
-	glUniform1i(getUniformLocation(name), value);
-	return true;
+	RESOLVE_UNIFORM_HANDLE;
+	return SetUniform(handle, value);
 }
 
 bool Shader::SetUniform(const std::string& name, float value) {
-	CHECK_UNIFORM_EXISTS;
-	glUniform1f(getUniformLocation(name), value);
-	return true;
+	RESOLVE_UNIFORM_HANDLE;
+	return SetUniform(handle, value);
 }
 
 bool Shader::SetUniform(const std::string& name, glm::vec2 value) {
-	CHECK_UNIFORM_EXISTS;
-	glUniform2fv(getUniformLocation(name), 1, glm::value_ptr(value));
-	return true;
+	RESOLVE_UNIFORM_HANDLE;
+	return SetUniform(handle, value);
 }
 
 bool Shader::SetUniform(const std::string& name, glm::vec3 value) {
-	CHECK_UNIFORM_EXISTS;
-	glUniform3fv(getUniformLocation(name), 1, glm::value_ptr(value));
-	return true;
+	RESOLVE_UNIFORM_HANDLE;
+	return SetUniform(handle, value);
 }
 
 bool Shader::SetUniform(const std::string& name, glm::vec4 value) {
-	CHECK_UNIFORM_EXISTS;
-	glUniform4fv(getUniformLocation(name), 1, glm::value_ptr(value));
-	return true;
+	RESOLVE_UNIFORM_HANDLE;
+	return SetUniform(handle, value);
 }
 
 bool Shader::SetUniform(const std::string& name, glm::mat2 value) {
-	CHECK_UNIFORM_EXISTS;
-	glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
-	return true;
+	RESOLVE_UNIFORM_HANDLE;
+	return SetUniform(handle, value);
 }
 
 bool Shader::SetUniform(const std::string& name, glm::mat3 value) {
-	CHECK_UNIFORM_EXISTS;
-	glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
-	return true;
+	RESOLVE_UNIFORM_HANDLE;
+	return SetUniform(handle, value);
 }
 
 bool Shader::SetUniform(const std::string& name, glm::mat4 value) {
-	CHECK_UNIFORM_EXISTS;
-	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+	RESOLVE_UNIFORM_HANDLE;
+	return SetUniform(handle, value);
+}
+
+#define CHECK_UNIFORM_HANDLE { if (!handle.IsValid()) return false; }
+
+bool Shader::SetUniform(UniformHandle handle, bool value) {
+	CHECK_UNIFORM_HANDLE;
+	glUniform1i(_uniforms[handle.index].location, value);
+	return true;
+}
+
+bool Shader::SetUniform(UniformHandle handle, int value) {
+	CHECK_UNIFORM_HANDLE;
+	glUniform1i(_uniforms[handle.index].location, value);
+	return true;
+}
+
+bool Shader::SetUniform(UniformHandle handle, float value) {
+	CHECK_UNIFORM_HANDLE;
+	glUniform1f(_uniforms[handle.index].location, value);
+	return true;
+}
+
+bool Shader::SetUniform(UniformHandle handle, const glm::vec2& value) {
+	CHECK_UNIFORM_HANDLE;
+	glUniform2fv(_uniforms[handle.index].location, 1, glm::value_ptr(value));
+	return true;
+}
+
+bool Shader::SetUniform(UniformHandle handle, const glm::vec3& value) {
+	CHECK_UNIFORM_HANDLE;
+	glUniform3fv(_uniforms[handle.index].location, 1, glm::value_ptr(value));
+	return true;
+}
+
+bool Shader::SetUniform(UniformHandle handle, const glm::vec4& value) {
+	CHECK_UNIFORM_HANDLE;
+	glUniform4fv(_uniforms[handle.index].location, 1, glm::value_ptr(value));
+	return true;
+}
+
+bool Shader::SetUniform(UniformHandle handle, const glm::mat2& value) {
+	CHECK_UNIFORM_HANDLE;
+	glUniformMatrix2fv(_uniforms[handle.index].location, 1, GL_FALSE, glm::value_ptr(value));
+	return true;
+}
+
+bool Shader::SetUniform(UniformHandle handle, const glm::mat3& value) {
+	CHECK_UNIFORM_HANDLE;
+	glUniformMatrix3fv(_uniforms[handle.index].location, 1, GL_FALSE, glm::value_ptr(value));
+	return true;
+}
+
+bool Shader::SetUniform(UniformHandle handle, const glm::mat4& value) {
+	CHECK_UNIFORM_HANDLE;
+	glUniformMatrix4fv(_uniforms[handle.index].location, 1, GL_FALSE, glm::value_ptr(value));
 	return true;
 }
 
 bool Shader::BindUniformBlock(const std::string& blockName, uint32_t bindingPoint) {
-	glUseProgram(_id);
+	GLStateCache::UseProgram(_id);
 	uint32_t blockIndex = glGetUniformBlockIndex(_id, blockName.c_str());
 	if (blockIndex == GL_INVALID_INDEX) {
 		ENGINE_ERROR("[Shader::BindUniformBlock] Uniform block '{}' not found in shader program!", blockName);
@@ -205,6 +287,14 @@ bool Shader::BindUniformBlock(const std::string& blockName, uint32_t bindingPoin
 	return true;
 }
 
+const UniformBlockInfo* Shader::GetUniformBlockInfo(const std::string& blockName) const {
+	for (const auto& block : _uniformBlockInfos) {
+		if (block.name == blockName)
+			return &block;
+	}
+	return nullptr;
+}
+
 /* ====================== */
 /*      Shader Utils      */
 /* ====================== */
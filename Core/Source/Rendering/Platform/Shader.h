@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
 #include <map>
+#include <vector>
+#include <unordered_map>
 #include "Util/FileIO.h"
 #include "glm/glm.hpp"
 
@@ -16,8 +18,28 @@ namespace Engine {
 
 	struct UniformInfo {
 		std::string name;
-		uint32_t location = 0;
+		int32_t location = -1;
 		UniformType type = UniformType::Bool;
+
+		// Members of a uniform block have no location, they live at an offset in the block instead
+		int32_t blockIndex = -1;
+		int32_t blockOffset = -1;
+		int32_t matrixStride = 0;
+	};
+
+	struct UniformBlockInfo {
+		std::string name;
+		uint32_t index = 0;
+		uint32_t size = 0;
+	};
+
+	// Slot index into a shader's flat uniform table, resolved once by name after linking.
+	struct UniformHandle {
+		int32_t index = -1;
+
+		inline bool IsValid() const { return index >= 0; }
+		bool operator==(const UniformHandle& other) const { return index == other.index; }
+		bool operator!=(const UniformHandle& other) const { return index != other.index; }
 	};
 
 	class Shader {
@@ -42,7 +64,23 @@ namespace Engine {
 		bool SetUniform(const std::string& name, glm::mat3 value);
 		bool SetUniform(const std::string& name, glm::mat4 value);
 
+		// Handle based setters do no lookup and do not bind the program, the shader must already be bound.
+		bool SetUniform(UniformHandle handle, bool value);
+		bool SetUniform(UniformHandle handle, int value);
+		bool SetUniform(UniformHandle handle, float value);
+		bool SetUniform(UniformHandle handle, const glm::vec2& value);
+		bool SetUniform(UniformHandle handle, const glm::vec3& value);
+		bool SetUniform(UniformHandle handle, const glm::vec4& value);
+		bool SetUniform(UniformHandle handle, const glm::mat2& value);
+		bool SetUniform(UniformHandle handle, const glm::mat3& value);
+		bool SetUniform(UniformHandle handle, const glm::mat4& value);
+
+		UniformHandle GetUniformHandle(const std::string& name) const;
+		inline const UniformInfo& GetUniformInfo(UniformHandle handle) const { return _uniforms[handle.index]; }
+
 		bool BindUniformBlock(const std::string& blockName, uint32_t bindingPoint);
+		// Returns nullptr if the block is not active in the program
+		const UniformBlockInfo* GetUniformBlockInfo(const std::string& blockName) const;
 
 		inline uint32_t GetHandle() const { return _id; }
 
@@ -50,13 +88,13 @@ namespace Engine {
 		inline const std::string& GetShaderSource(ShaderStage type) const { return _shaderSources.at(type); }
 		std::vector<ShaderStage> GetAttachedTypes() const;
 
-		inline const std::map<std::string, UniformInfo>& GetUniformInfos() const { return _uniformsMap; }
+		inline const std::vector<UniformInfo>& GetUniformInfos() const { return _uniforms; }
 		inline const std::map<std::string, uint32_t>& GetUniformBlocks() const { return _uniformBlockMap; }
+		inline const std::vector<UniformBlockInfo>& GetUniformBlockInfos() const { return _uniformBlockInfos; }
 	private:
 		uint32_t compileShader(uint32_t type, const char* source);
 		void preloadUniforms();
-		bool uniformExists(const std::string& name);
-		int getUniformLocation(const std::string& name);
+		UniformHandle findUniform(const std::string& name);
 	public:
 		struct Utils {
 			/* Depreciated */ static std::shared_ptr<Shader> FromFile(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
@@ -66,7 +104,9 @@ namespace Engine {
 	private:
 		uint32_t _id;
 		std::map<ShaderStage, std::string> _shaderSources;
-		std::map<std::string, UniformInfo> _uniformsMap;
+		std::vector<UniformInfo> _uniforms;
+		std::unordered_map<std::string, int32_t> _uniformIndices;
 		std::map<std::string, uint32_t> _uniformBlockMap;
+		std::vector<UniformBlockInfo> _uniformBlockInfos;
 	};
 }
\ No newline at end of file
@@ -2,41 +2,316 @@
 #include <glad/glad.h>
 #include <stb_image.h>
 #include "Logging/Logging.h"
+#include "Util/Image/MipGenerator.h"
+#include "Util/Image/TextureCache.h"
+
+#include <algorithm>
 
 using namespace Engine;
 
 Texture2D::Texture2D(const TextureSpec& spec)
 	: BaseTexture(TextureType::Tex2D, spec) {
-	BindInternal();
-
-	//SetDataInternal(GL_TEXTURE_2D, nullptr);
-	glTexImage2D(GL_TEXTURE_2D, 0, _internalFormat, _width, _height, 0, _dataFormat, _dataType, nullptr);
+	AllocateStorage();
+	SetSampler(Sampler::Utils::Default());
+}
 
-	glTexParameteri(_internalType, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(_internalType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(_internalType, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(_internalType, GL_TEXTURE_WRAP_T, GL_REPEAT);
+void Texture2D::SetData(const void* data, uint32_t level) {
+	BindInternal();
+	SetDataInternal(GL_TEXTURE_2D, data, level);
+	Unbind();
 }
 
-void Texture2D::SetData(void* data) {
+void Texture2D::SetRows(uint32_t level, uint32_t y, uint32_t height, const void* data) {
 	BindInternal();
-	SetDataInternal(GL_TEXTURE_2D, data);
+	SetRowsInternal(GL_TEXTURE_2D, level, y, height, data);
 	Unbind();
 }
 
-std::shared_ptr<Texture2D> Texture2D::Utils::FromFile(const std::string& path, bool flipV) {
-	stbi_set_flip_vertically_on_load(flipV);
-	auto fileData = Texture::Utils::LoadFromFile(path);
+std::vector<uint8_t> Texture2D::GetData(uint32_t level) const {
+	return GetDataInternal(GL_TEXTURE_2D, level);
+}
+
+void Texture2D::CopyLevelsFrom(const Texture2D& source, uint32_t sourceLevel, uint32_t level, uint32_t count) {
+	if (source._format != _format || source._dataType != _dataType || sourceLevel + count > source._mipLevels || level + count > _mipLevels) {
+		ENGINE_ERROR("[Texture2D::CopyLevelsFrom] Levels {} to {} do not match levels {} to {}", sourceLevel, sourceLevel + count, level, level + count);
+		return;
+	}
+
+	std::vector<uint64_t> offsets(count);
+	uint64_t size = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		offsets[i] = size;
+		size += (source.GetLevelDataSize(sourceLevel + i) + 15) / 16 * 16;
+	}
+
+	// Read into and uploaded from a buffer, so the data never leaves the GPU and nothing waits for it
+	uint32_t buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_COPY);
+	for (uint32_t i = 0; i < count; i++)
+		source.ReadLevelInternal(GL_TEXTURE_2D, sourceLevel + i, (void*)(uintptr_t)offsets[i]);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	for (uint32_t i = 0; i < count; i++)
+		SetRows(level + i, 0, std::max(_height >> (level + i), 1u), (const void*)(uintptr_t)offsets[i]);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glDeleteBuffers(1, &buffer);
+}
+
+void Texture2D::DropTopLevels(uint32_t count) {
+	count = std::min(count, _mipLevels - 1);
+	if (count == 0)
+		return;
 
+	TextureSpec spec;
+	spec.width = std::max(_width >> count, 1u);
+	spec.height = std::max(_height >> count, 1u);
+	spec.format = _format;
+	spec.mipLevels = _mipLevels - count;
+	spec.halfFloatData = _halfFloatData;
+
+	Texture2D reduced(spec);
+	reduced.CopyLevelsFrom(*this, count, 0, _mipLevels - count);
+	reduced.SetBaseLevel(_baseLevel > count ? _baseLevel - count : 0);
+	reduced.SetSampler(_sampler);
+	Swap(reduced);
+}
+
+void Texture2D::Swap(Texture2D& other) {
+	SwapInternal(other);
+}
+
+DecodedTexture::~DecodedTexture() {
+	if (pixels.data)
+		stbi_image_free(pixels.data);
+}
+
+DecodedTexture::DecodedTexture(DecodedTexture&& other) noexcept {
+	*this = std::move(other);
+}
+
+DecodedTexture& DecodedTexture::operator=(DecodedTexture&& other) noexcept {
+	if (this == &other)
+		return *this;
+
+	if (pixels.data)
+		stbi_image_free(pixels.data);
+
+	path = std::move(other.path);
+	file = std::move(other.file);
+	compressed = std::move(other.compressed);
+	pixels = other.pixels;
+	mipLevels = std::move(other.mipLevels);
+	mips = other.mips;
+	other.pixels.data = nullptr;
+	return *this;
+}
+
+uint32_t DecodedTexture::GetLevelCount() const {
+	if (file)
+		return file->GetLevelCount();
+	if (!compressed.levels.empty())
+		return (uint32_t)compressed.levels.size();
+	return pixels.data ? 1 + (uint32_t)mipLevels.size() : 0;
+}
+
+const void* DecodedTexture::GetLevelData(uint32_t level) const {
+	if (level >= GetLevelCount())
+		return nullptr;
+	if (file)
+		return file->GetData(level);
+	if (!compressed.levels.empty())
+		return compressed.levels[level].data();
+	return level == 0 ? pixels.data : mipLevels[level - 1].data.data();
+}
+
+bool DecodedTexture::NeedsMipmapGeneration() const {
+	// Formats the CPU filters do not handle still get a chain
+	return !file && compressed.levels.empty() && mipLevels.empty() && mips != MipGeneration::None;
+}
+
+static std::vector<MipLevel> generateCPUMips(const Texture::Utils::FileTextureData& fileData, MipGeneration mips) {
+	if (mips != MipGeneration::Box && mips != MipGeneration::Kaiser)
+		return {};
+
+	MipSettings settings;
+	settings.filter = mips == MipGeneration::Box ? MipFilter::Box : MipFilter::Kaiser;
+	return MipGenerator::Generate(fileData.data, fileData.width, fileData.height, fileData.format, settings);
+}
+
+DecodedTexture Texture2D::Utils::Decode(const TextureSource& source) {
+	DecodedTexture decoded;
+	decoded.path = source.path;
+	decoded.mips = source.mips;
+
+	if (TextureFile::IsContainer(source.path)) {
+		decoded.file = TextureFile::Open(source.path);
+		return decoded;
+	}
+
+	if (source.compression != TextureCompression::None) {
+		std::string key = TextureCache::MakeKey(source.path, std::to_string((int)source.compression) + (source.flipV ? "|flip" : ""));
+		auto cached = TextureCache::Load(key);
+		if (cached && !cached->IsCubemap() && Engine::Utils::ImageFormatIsSupported(cached->GetFormat())) {
+			decoded.file = cached;
+			return decoded;
+		}
+
+		auto fileData = Texture::Utils::LoadFromFile(source.path, source.flipV);
+		ImageFormat format = TextureCompressor::ChooseFormat(source.compression, fileData.data, fileData.width, fileData.height, fileData.format);
+		if (format != ImageFormat::None && TextureCompressor::Compress(fileData.data, fileData.width, fileData.height, fileData.format, format, true, decoded.compressed)) {
+			TextureCache::Store(key, decoded.compressed);
+			stbi_image_free(fileData.data);
+			return decoded;
+		}
+
+		ENGINE_WARN("[Texture2D::Decode] '{}' cannot be compressed, loading it uncompressed", source.path);
+		decoded.pixels = fileData;
+	}
+	else {
+		decoded.pixels = Texture::Utils::LoadFromFile(source.path, source.flipV);
+	}
+
+	if (decoded.pixels.data)
+		decoded.mipLevels = generateCPUMips(decoded.pixels, decoded.mips);
+	else
+		ENGINE_ERROR("[Texture2D::Decode] Failed to load '{}'", source.path);
+	return decoded;
+}
+
+std::shared_ptr<Texture2D> Texture2D::Utils::Create(DecodedTexture& decoded) {
+	auto texture = Allocate(decoded);
+	if (!texture)
+		return nullptr;
+
+	for (uint32_t level = 0; level < decoded.GetLevelCount(); level++)
+		texture->SetData(decoded.GetLevelData(level), level);
+	if (decoded.NeedsMipmapGeneration())
+		texture->GenerateMipmaps();
+	return texture;
+}
+
+std::shared_ptr<Texture2D> Texture2D::Utils::Allocate(const DecodedTexture& decoded) {
+	TextureSpec spec;
+	if (decoded.file) {
+		if (decoded.file->IsCubemap()) {
+			ENGINE_ERROR("[Texture2D::Allocate] '{}' holds a cubemap, not a 2D texture", decoded.path);
+			return nullptr;
+		}
+		if (!Engine::Utils::ImageFormatIsSupported(decoded.file->GetFormat())) {
+			ENGINE_ERROR("[Texture2D::Allocate] Format {} of '{}' is not supported by the driver", (int)decoded.file->GetFormat(), decoded.path);
+			return nullptr;
+		}
+
+		spec.width = decoded.file->GetWidth();
+		spec.height = decoded.file->GetHeight();
+		spec.format = decoded.file->GetFormat();
+		spec.mipLevels = decoded.file->GetLevelCount();
+		spec.halfFloatData = decoded.file->IsHalfFloat();
+	}
+	else if (!decoded.compressed.levels.empty()) {
+		spec.width = decoded.compressed.width;
+		spec.height = decoded.compressed.height;
+		spec.format = decoded.compressed.format;
+		spec.mipLevels = (uint32_t)decoded.compressed.levels.size();
+	}
+	else if (decoded.pixels.data) {
+		spec.width = decoded.pixels.width;
+		spec.height = decoded.pixels.height;
+		spec.format = decoded.pixels.format;
+		spec.mipLevels = decoded.mips == MipGeneration::None ? 1 : 0;
+	}
+	else {
+		return nullptr;
+	}
+
+	return std::make_shared<Texture2D>(spec);
+}
+
+std::shared_ptr<Texture2D> Texture2D::Utils::FromFile(const std::string& path, bool flipV, MipGeneration mips) {
+	auto decoded = Decode({ path, flipV, mips });
+	return Create(decoded);
+}
+
+std::shared_ptr<Texture2D> Texture2D::Utils::FromFileData(const Texture::Utils::FileTextureData& fileData, MipGeneration mips) {
 	TextureSpec spec;
 	spec.width = fileData.width;
 	spec.height = fileData.height;
 	spec.format = fileData.format;
+	spec.mipLevels = mips == MipGeneration::None ? 1 : 0;
 
-	//auto texture = std::make_shared<Texture2D>(spec);
 	auto texture = std::make_shared<Texture2D>(spec);
 	texture->SetData(fileData.data);
 
-	free(fileData.data);
+	auto levels = generateCPUMips(fileData, mips);
+	for (uint32_t i = 0; i < levels.size(); i++)
+		texture->SetData(levels[i].data.data(), i + 1);
+
+	// Formats the CPU filters do not handle still get a chain
+	if (mips != MipGeneration::None && levels.empty())
+		texture->GenerateMipmaps();
+	return texture;
+}
+
+std::shared_ptr<Texture2D> Texture2D::Utils::FromFileCompressed(const std::string& path, TextureCompression compression, bool flipV) {
+	auto decoded = Decode({ path, flipV, MipGeneration::GPU, compression });
+	return Create(decoded);
+}
+
+std::shared_ptr<Texture2D> Texture2D::Utils::FromCompressedImage(const CompressedImage& image) {
+	TextureSpec spec;
+	spec.width = image.width;
+	spec.height = image.height;
+	spec.format = image.format;
+	spec.mipLevels = (uint32_t)image.levels.size();
+
+	auto texture = std::make_shared<Texture2D>(spec);
+	for (uint32_t i = 0; i < image.levels.size(); i++)
+		texture->SetData(image.levels[i].data(), i);
+	return texture;
+}
+
+std::shared_ptr<Texture2D> Texture2D::Utils::FromTextureFile(const TextureFile& file) {
+	if (file.IsCubemap()) {
+		ENGINE_ERROR("[Texture2D::FromTextureFile] File holds a cubemap, not a 2D texture");
+		return nullptr;
+	}
+	if (!Engine::Utils::ImageFormatIsSupported(file.GetFormat())) {
+		ENGINE_ERROR("[Texture2D::FromTextureFile] Format {} is not supported by the driver", (int)file.GetFormat());
+		return nullptr;
+	}
+
+	TextureSpec spec;
+	spec.width = file.GetWidth();
+	spec.height = file.GetHeight();
+	spec.format = file.GetFormat();
+	spec.mipLevels = file.GetLevelCount();
+	spec.halfFloatData = file.IsHalfFloat();
+
+	// Straight from the mapping to the driver
+	auto texture = std::make_shared<Texture2D>(spec);
+	for (uint32_t level = 0; level < file.GetLevelCount(); level++)
+		texture->SetData(file.GetData(level), level);
+	return texture;
+}
+
+std::shared_ptr<Texture2D> Texture2D::Utils::FromTextureFileData(const TextureFileData& data) {
+	if (data.faceCount != 1 || data.images.size() != data.levelCount) {
+		ENGINE_ERROR("[Texture2D::FromTextureFileData] Data does not hold exactly {} levels of a 2D texture", data.levelCount);
+		return nullptr;
+	}
+
+	TextureSpec spec;
+	spec.width = data.width;
+	spec.height = data.height;
+	spec.format = data.format;
+	spec.mipLevels = data.levelCount;
+	spec.halfFloatData = data.halfFloat;
+
+	auto texture = std::make_shared<Texture2D>(spec);
+	for (uint32_t level = 0; level < data.levelCount; level++)
+		texture->SetData(data.images[level].data(), level);
 	return texture;
 }
\ No newline at end of file
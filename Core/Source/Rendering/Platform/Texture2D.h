@@ -4,16 +4,89 @@
 #include <memory>
 #include <Logging/Logging.h>
 
+#include "Util/Image/MipGenerator.h"
+#include "Util/Image/TextureCompressor.h"
+#include "Util/Image/TextureFile.h"
+
 namespace Engine {
+	enum class MipGeneration {
+		None,
+		GPU,    // glGenerateMipmap after the upload
+		Box,    // Downsampled on the CPU, for baked assets
+		Kaiser
+	};
+
+	// What to load and how, see Texture2D::Utils::Decode
+	struct TextureSource {
+		std::string path;
+		bool flipV = true;
+		MipGeneration mips = MipGeneration::GPU;
+		TextureCompression compression = TextureCompression::None;
+	};
+
+	// Everything Decode did on the CPU, waiting to be uploaded by Create. Exactly one of file, compressed
+	// or pixels is set, nothing is if decoding failed.
+	struct DecodedTexture {
+		std::string path;
+		std::shared_ptr<TextureFile> file;      // Containers and cache hits, uploaded straight from the mapping
+		CompressedImage compressed;             // Freshly encoded, already stored in the texture cache
+		Texture::Utils::FileTextureData pixels; // Decoded by stb_image
+		std::vector<MipLevel> mipLevels;        // CPU filtered levels below pixels
+		MipGeneration mips = MipGeneration::GPU;
+
+		DecodedTexture() = default;
+		~DecodedTexture();
+		DecodedTexture(DecodedTexture&& other) noexcept;
+		DecodedTexture& operator=(DecodedTexture&& other) noexcept;
+		DecodedTexture(const DecodedTexture&) = delete;
+		DecodedTexture& operator=(const DecodedTexture&) = delete;
+
+		inline bool IsValid() const { return file || !compressed.levels.empty() || pixels.data; }
+		// Levels held on the CPU, finest first. Levels generated on the GPU are not included.
+		uint32_t GetLevelCount() const;
+		const void* GetLevelData(uint32_t level) const;
+		// True if the levels below the ones held still have to be generated after the upload
+		bool NeedsMipmapGeneration() const;
+	};
+
 	class Texture2D : public BaseTexture {
 	public:
 		Texture2D(const TextureSpec& spec);
 		~Texture2D() = default;
 
-		void SetData(void* data);
+		void SetData(const void* data, uint32_t level = 0);
+		// Part of a level, see BaseTexture::SetRowsInternal
+		void SetRows(uint32_t level, uint32_t y, uint32_t height, const void* data);
+		std::vector<uint8_t> GetData(uint32_t level = 0) const;
+
+		// Copies count levels of source starting at sourceLevel into this texture starting at level, on the GPU.
+		// The format and the sizes of the copied levels must match.
+		void CopyLevelsFrom(const Texture2D& source, uint32_t sourceLevel, uint32_t level, uint32_t count);
+		// Reallocates the texture without its count finest levels, the rest are kept as they are
+		void DropTopLevels(uint32_t count);
+
+		// Takes over the other texture's GL texture and gives it this one, so a placeholder that is already
+		// referenced by materials can become the loaded texture in place
+		void Swap(Texture2D& other);
 
 		struct Utils {
-			static std::shared_ptr<Texture2D> FromFile(const std::string& path, bool flipV = true);
+			// The CPU half of loading, touches neither GL nor any global state so it can run on any thread
+			static DecodedTexture Decode(const TextureSource& source);
+			// The GL half, must run on the GL thread. nullptr if nothing was decoded.
+			static std::shared_ptr<Texture2D> Create(DecodedTexture& decoded);
+			// Storage for every level of the decoded texture without uploading any of it
+			static std::shared_ptr<Texture2D> Allocate(const DecodedTexture& decoded);
+
+			// KTX2 and DDS files are uploaded as stored, flipV and mips only apply to images decoded by stb_image
+			static std::shared_ptr<Texture2D> FromFile(const std::string& path, bool flipV = true, MipGeneration mips = MipGeneration::GPU);
+			static std::shared_ptr<Texture2D> FromTextureFile(const TextureFile& file);
+			static std::shared_ptr<Texture2D> FromTextureFileData(const TextureFileData& data);
+			static std::shared_ptr<Texture2D> FromFileData(const Texture::Utils::FileTextureData& fileData, MipGeneration mips = MipGeneration::GPU);
+			// Block compressed with a CPU built mip chain, loaded from the texture cache when the source has not changed.
+			// Falls back to an uncompressed texture if the image or the driver does not allow the format.
+			static std::shared_ptr<Texture2D> FromFileCompressed(const std::string& path, TextureCompression compression, bool flipV = true);
+			// Every level of the image is uploaded as is
+			static std::shared_ptr<Texture2D> FromCompressedImage(const CompressedImage& image);
 		};
 	};
 }
\ No newline at end of file
@@ -7,27 +7,22 @@ using namespace Engine;
 
 TextureCubemap::TextureCubemap(const TextureSpec& spec)
 	: BaseTexture(TextureType::TexCubemap, spec) {
-    BindInternal();
-
-	for (uint32_t i = 0; i < 6; i++)
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, _internalFormat, _width, _height, 0, _dataFormat, _dataType, nullptr);
-
-    glTexParameteri(_internalType, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(_internalType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(_internalType, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(_internalType, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(_internalType, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    AllocateStorage();
+    SetSampler(Sampler::Utils::Clamped());
 }
 
-void TextureCubemap::SetData(CubemapIndex index, void* data) {
+void TextureCubemap::SetData(CubemapIndex index, const void* data, uint32_t level) {
 	BindInternal();
-	SetDataInternal(GL_TEXTURE_CUBE_MAP_POSITIVE_X + (int)index, data);
+	SetDataInternal(GL_TEXTURE_CUBE_MAP_POSITIVE_X + (int)index, data, level);
+}
+
+std::vector<uint8_t> TextureCubemap::GetData(CubemapIndex index, uint32_t level) const {
+	return GetDataInternal(GL_TEXTURE_CUBE_MAP_POSITIVE_X + (int)index, level);
 }
 
 std::shared_ptr<TextureCubemap> TextureCubemap::Utils::FromFile(const CubemapPaths& paths) {
     TextureSpec spec;
     std::vector<Texture::Utils::FileTextureData> cubemapData;
-    stbi_set_flip_vertically_on_load(false);
 
     // Load all images and perform consistency checks
     for (const auto& path : { paths.positiveX, paths.negativeX, paths.positiveY, paths.negativeY, paths.positiveZ, paths.negativeZ }) {
@@ -74,6 +69,7 @@ std::shared_ptr<TextureCubemap> TextureCubemap::Utils::FromFile(const CubemapPat
 #include "Rendering/Platform/Texture2D.h"
 #include "Rendering/Platform/Framebuffer.h"
 #include "Rendering/RenderCommands.h"
+#include "Util/Image/TextureCache.h"
 
 #pragma region Shaders
 
@@ -208,6 +204,8 @@ std::shared_ptr<TextureCubemap> TextureCubemap::Utils::FromTexture2D(std::shared
 			captureSize,
 			texture->GetFormat()
 		};
+		// Nothing is uploaded, but reading it back for the texture cache then gives the half floats it stores
+		textureSpec.halfFloatData = true;
 		cubemap = std::make_shared<Engine::TextureCubemap>(textureSpec);
 
 		auto framebufferSpec = Engine::Framebuffer::FramebufferSpec{
@@ -237,3 +235,84 @@ std::shared_ptr<TextureCubemap> TextureCubemap::Utils::FromTexture2D(std::shared
 
 	return cubemap;
 }
+
+std::shared_ptr<TextureCubemap> TextureCubemap::Utils::FromTextureFile(const TextureFile& file) {
+	if (!file.IsCubemap()) {
+		ENGINE_ERROR("[Cubemap::FromTextureFile] File holds a 2D texture, not a cubemap");
+		return nullptr;
+	}
+	if (!Engine::Utils::ImageFormatIsSupported(file.GetFormat())) {
+		ENGINE_ERROR("[Cubemap::FromTextureFile] Format {} is not supported by the driver", (int)file.GetFormat());
+		return nullptr;
+	}
+
+	TextureSpec spec;
+	spec.width = file.GetWidth();
+	spec.height = file.GetHeight();
+	spec.format = file.GetFormat();
+	spec.mipLevels = file.GetLevelCount();
+	spec.halfFloatData = file.IsHalfFloat();
+
+	auto cubemap = std::make_shared<TextureCubemap>(spec);
+	for (uint32_t level = 0; level < file.GetLevelCount(); level++)
+		for (uint32_t face = 0; face < 6; face++)
+			cubemap->SetData((CubemapIndex)face, file.GetData(level, face), level);
+	return cubemap;
+}
+
+std::shared_ptr<TextureCubemap> TextureCubemap::Utils::FromTextureFileData(const TextureFileData& data) {
+	if (data.faceCount != 6 || data.images.size() != (size_t)data.levelCount * 6) {
+		ENGINE_ERROR("[Cubemap::FromTextureFileData] Data does not hold every face of {} levels", data.levelCount);
+		return nullptr;
+	}
+
+	TextureSpec spec;
+	spec.width = data.width;
+	spec.height = data.height;
+	spec.format = data.format;
+	spec.mipLevels = data.levelCount;
+	spec.halfFloatData = data.halfFloat;
+
+	auto cubemap = std::make_shared<TextureCubemap>(spec);
+	for (uint32_t level = 0; level < data.levelCount; level++)
+		for (uint32_t face = 0; face < 6; face++)
+			cubemap->SetData((CubemapIndex)face, data.images[level * 6 + face].data(), level);
+	return cubemap;
+}
+
+std::shared_ptr<TextureCubemap> TextureCubemap::Utils::FromEquirectangularFile(const std::string& path) {
+	if (TextureFile::IsContainer(path)) {
+		auto file = TextureFile::Open(path);
+		return file ? FromTextureFile(*file) : nullptr;
+	}
+
+	std::string key = TextureCache::MakeKey(path, "equirectangular-cubemap");
+	auto cached = TextureCache::Load(key);
+	if (cached) {
+		auto cubemap = FromTextureFile(*cached);
+		if (cubemap)
+			return cubemap;
+	}
+
+	// Only read once by the conversion, no point in a mip chain
+	auto texture = Texture2D::Utils::FromFile(path, true, MipGeneration::None);
+	auto cubemap = FromTexture2D(texture, Texture2DCubemapFormat::Equirectangle);
+	if (cubemap)
+		TextureCache::Store(key, ToTextureFileData(*cubemap));
+	return cubemap;
+}
+
+TextureFileData TextureCubemap::Utils::ToTextureFileData(const TextureCubemap& cubemap) {
+	TextureFileData data;
+	data.format = cubemap.GetFormat();
+	data.halfFloat = cubemap.IsHalfFloatData();
+	data.width = cubemap.GetWidth();
+	data.height = cubemap.GetHeight();
+	data.faceCount = 6;
+	data.levelCount = cubemap.GetMipLevels();
+
+	for (uint32_t level = 0; level < data.levelCount; level++)
+		for (uint32_t face = 0; face < 6; face++)
+			data.images.push_back(cubemap.GetData((CubemapIndex)face, level));
+	return data;
+}
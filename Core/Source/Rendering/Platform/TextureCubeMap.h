@@ -5,6 +5,8 @@
 #include <memory>
 #include <string>
 
+#include "Util/Image/TextureFile.h"
+
 namespace Engine {
 	class Texture2D;
 
@@ -21,7 +23,8 @@ namespace Engine {
 		TextureCubemap(const TextureSpec& spec);
 		~TextureCubemap() = default;
 
-		void SetData(CubemapIndex index, void* data);
+		void SetData(CubemapIndex index, const void* data, uint32_t level = 0);
+		std::vector<uint8_t> GetData(CubemapIndex index, uint32_t level = 0) const;
 
 		struct Utils {
 			struct CubemapPaths {
@@ -40,6 +43,14 @@ namespace Engine {
 			};
 
 			static std::shared_ptr<TextureCubemap> FromTexture2D(std::shared_ptr<Texture2D> texture, Texture2DCubemapFormat format);
+
+			// Every level of every face is uploaded as stored
+			static std::shared_ptr<TextureCubemap> FromTextureFile(const TextureFile& file);
+			static std::shared_ptr<TextureCubemap> FromTextureFileData(const TextureFileData& data);
+			// Converts an equirectangular image, keeping the result in the texture cache so later loads skip
+			// both the decode and the conversion. KTX2 and DDS cubemaps are loaded directly.
+			static std::shared_ptr<TextureCubemap> FromEquirectangularFile(const std::string& path);
+			static TextureFileData ToTextureFileData(const TextureCubemap& cubemap);
 		};
 	};
 }
@@ -5,6 +5,8 @@
 #include "Rendering/Platform/Mesh.h"
 #include "Rendering/Platform/Shader.h"
 #include "Rendering/Platform/Material.h"
+#include "Rendering/Platform/Buffer/IndirectBufferObject.h"
+#include "GLExtensions.h"
 
 using namespace Engine;
 
@@ -37,36 +39,78 @@ void RenderCommands::RenderMesh(const Mesh& mesh, const IRenderableMaterial& mat
 	material.Bind();
 
 	for (uint32_t i = 0; i < mesh.GetSubmeshCount(); i++) {
-		auto& vertexArray = mesh.GetSubmesh(i);
-
-		vertexArray.Bind();
-		if (vertexArray.HasIndices())
-			glDrawElements((uint32_t)vertexArray.GetDrawMode(), vertexArray.GetCount(), (GLenum)vertexArray.GetIndexBuffer().GetType(), 0);
-		else
-			glDrawArrays((uint32_t)vertexArray.GetDrawMode(), 0, vertexArray.GetCount());
+		DrawVertexArray(mesh.GetSubmesh(i));
 	}
-
-	material.Unbind();
 }
 
 void RenderCommands::RenderMesh(const VertexArrayObject& vertexArray, const Shader& shader) {
 	shader.Bind();
+	DrawVertexArray(vertexArray);
+}
+
+void RenderCommands::DrawVertexArray(const VertexArrayObject& vertexArray) {
 	vertexArray.Bind();
 
 	if (vertexArray.HasIndices())
-		glDrawElements((uint32_t)vertexArray.GetDrawMode(), vertexArray.GetCount(), (GLenum)vertexArray.GetIndexBuffer().GetType(), 0);
+		glDrawElements((uint32_t)vertexArray.GetDrawMode(), vertexArray.GetCount(), (GLenum)vertexArray.GetIndexBuffer().GetType(), Utils::GetIndexOffset(vertexArray));
 	else
 		glDrawArrays((uint32_t)vertexArray.GetDrawMode(), 0, vertexArray.GetCount());
+}
+
+void RenderCommands::DrawVertexArrayInstanced(const VertexArrayObject& vertexArray, uint32_t instanceCount) {
+	vertexArray.BindInstanced();
+
+	if (vertexArray.HasIndices())
+		glDrawElementsInstanced((uint32_t)vertexArray.GetDrawMode(), vertexArray.GetCount(), (GLenum)vertexArray.GetIndexBuffer().GetType(), Utils::GetIndexOffset(vertexArray), instanceCount);
+	else
+		glDrawArraysInstanced((uint32_t)vertexArray.GetDrawMode(), 0, vertexArray.GetCount(), instanceCount);
+}
+
+uint32_t RenderCommands::MultiDrawIndirect(VertexArrayObject& vertexArray, const DrawElementsIndirectCommand* commands, uint32_t firstCommand, uint32_t commandCount, const IndirectBufferObject* indirectBuffer) {
+	if (commandCount == 0)
+		return 0;
+
+	GLenum mode = (GLenum)vertexArray.GetDrawMode();
+	GLenum type = (GLenum)vertexArray.GetIndexBuffer().GetType();
+	uint64_t indexSize = GetLTypeSize(vertexArray.GetIndexBuffer().GetType());
+
+	if (indirectBuffer && GLExtensions::HasMultiDrawIndirect()) {
+		// Base instance is applied by the draw itself
+		vertexArray.SetInstanceOffset(0);
+		vertexArray.BindInstanced();
+		indirectBuffer->Bind();
+		GLExtensions::MultiDrawElementsIndirect(mode, type, (const void*)(intptr_t)(firstCommand * sizeof(DrawElementsIndirectCommand)), (int)commandCount, 0);
+		indirectBuffer->Unbind();
+		return 1;
+	}
+
+	// One draw per command, straight from the CPU copy
+	commands += firstCommand;
+	if (GLExtensions::HasBaseInstance())
+		vertexArray.SetInstanceOffset(0);
+
+	vertexArray.BindInstanced();
+	for (uint32_t i = 0; i < commandCount; i++) {
+		const auto& command = commands[i];
+		const void* indices = (const void*)(intptr_t)(command.firstIndex * indexSize);
+		if (GLExtensions::HasBaseInstance()) {
+			GLExtensions::DrawElementsInstancedBaseVertexBaseInstance(mode, command.count, type, indices, command.instanceCount, command.baseVertex, command.baseInstance);
+		}
+		else {
+			vertexArray.SetInstanceOffset(command.baseInstance);
+			glDrawElementsInstancedBaseVertex(mode, command.count, type, indices, command.instanceCount, command.baseVertex);
+		}
+	}
+	return commandCount;
+}
 
-	vertexArray.Unbind();
-	shader.Unbind();
+const void* RenderCommands::Utils::GetIndexOffset(const VertexArrayObject& vertexArray) {
+	return (const void*)(intptr_t)(vertexArray.GetFirstIndex() * GetLTypeSize(vertexArray.GetIndexBuffer().GetType()));
 }
 
 // Likely usage for geometry shaders
-void RenderCommands::RenderPoints(const VertexArrayObject& vertexArray, uint32_t count, const Shader& shader) {
+void RenderCommands::RenderPoints(const VertexArrayObject& vertexArray, uint32_t count, const Shader& shader, uint32_t first) {
 	shader.Bind();
 	vertexArray.Bind();
-	glDrawArrays(GL_POINTS, 0, count);
-	vertexArray.Unbind();
-	shader.Unbind();
+	glDrawArrays(GL_POINTS, first, count);
 }
@@ -15,6 +15,16 @@ namespace Engine {
 	class Shader;
 	class IRenderableMaterial;
 	class VertexArrayObject;
+	class IndirectBufferObject;
+
+	// Same layout as the GL DrawElementsIndirectCommand
+	struct DrawElementsIndirectCommand {
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t baseVertex;
+		uint32_t baseInstance;
+	};
 
 	class RenderCommands {
 	public:
@@ -26,6 +36,19 @@ namespace Engine {
 
 		static void RenderMesh(const Mesh& mesh, const IRenderableMaterial& material);
 		static void RenderMesh(const VertexArrayObject& mesh, const Shader& shader);
-		static void RenderPoints(const VertexArrayObject& vertexArray, uint32_t count, const Shader& shader);
+		// Draws with whatever shader is currently bound
+		static void DrawVertexArray(const VertexArrayObject& vertexArray);
+		static void DrawVertexArrayInstanced(const VertexArrayObject& vertexArray, uint32_t instanceCount);
+		// Draws commands [firstCommand, firstCommand + commandCount) from the (pooled) vertex array in one call when
+		// glMultiDrawElementsIndirect is available, reading them from indirectBuffer which must hold the same commands.
+		// Otherwise, or without a buffer, loops over them. Returns the number of draw calls issued.
+		static uint32_t MultiDrawIndirect(VertexArrayObject& vertexArray, const DrawElementsIndirectCommand* commands, uint32_t firstCommand, uint32_t commandCount,
+			const IndirectBufferObject* indirectBuffer);
+		static void RenderPoints(const VertexArrayObject& vertexArray, uint32_t count, const Shader& shader, uint32_t first = 0);
+	private:
+		struct Utils {
+			// Byte offset of the vertex array's first index, non zero for meshes in shared buffers
+			static const void* GetIndexOffset(const VertexArrayObject& vertexArray);
+		};
 	};
 }
\ No newline at end of file
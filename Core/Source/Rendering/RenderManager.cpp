@@ -14,6 +14,12 @@
 #include <backends/imgui_impl_glfw.h>
 
 #include "Core/Application/Window.h"
+#include "GLStateCache.h"
+#include "GLExtensions.h"
+#include "RenderThreadQueue.h"
+#include "TextureLoader.h"
+#include "TextureUploadQueue.h"
+#include "TextureResidency.h"
 
 using namespace Engine;
 
@@ -25,6 +31,8 @@ bool RenderManager::Initialize(Window& window) {
 		ENGINE_ERROR("[RenderManager::Initialize] Failed to initialize GLAD");
 		return false;
 	}
+	GLExtensions::Load();
+	TextureLoader::Initialize();
 
 	setContext();
 
@@ -54,11 +62,18 @@ bool RenderManager::Initialize(Window& window) {
 }
 
 void RenderManager::Shutdown() {
+	TextureLoader::Shutdown();
+	TextureResidency::Shutdown();
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 }
 
 void RenderManager::BeginFrame() {
+	GLStateCache::NewFrame();
+	// Uploads of textures decoded since the last frame
+	RenderThreadQueue::Execute();
+	TextureUploadQueue::Process();
+	TextureResidency::Update();
 	RenderCommands::SetWireframe(_wireframeMode);
 
 	// Start ImGui Frame
@@ -86,33 +101,15 @@ void RenderManager::EndFrame() {
 			ImGui::RenderPlatformWindowsDefault();
 			glfwMakeContextCurrent(backup_current_context);
 		}
+
+		// ImGui talks to GL directly, so nothing the cache remembers can be trusted anymore
+		GLStateCache::Invalidate();
 	}
 }
 
 void RenderManager::setContext() {
-	if (_graphicsContext.EnableDepthTest)
-		glEnable(GL_DEPTH_TEST);
-	else
-		glDisable(GL_DEPTH_TEST);
+	GLStateCache::Invalidate();
+	GLStateCache::ApplyContext(_graphicsContext);
 
 	glDepthFunc(GL_LEQUAL);
-
-	if (_graphicsContext.EnableBlend)
-		glEnable(GL_BLEND);
-	else
-		glDisable(GL_BLEND);
-
-	glBlendFunc((GLenum)_graphicsContext.SrcBlendFactor, (GLenum)_graphicsContext.DstBlendFactor);
-
-	if (_graphicsContext.EnableCullFace)
-		glEnable(GL_CULL_FACE);
-	else
-		glDisable(GL_CULL_FACE);
-
-	if (_graphicsContext.CullFront && _graphicsContext.CullBack)
-		glCullFace(GL_FRONT_AND_BACK);
-	else if (_graphicsContext.CullFront)
-		glCullFace(GL_FRONT);
-	else if (_graphicsContext.CullBack)
-		glCullFace(GL_BACK);
 }
\ No newline at end of file
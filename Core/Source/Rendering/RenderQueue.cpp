@@ -0,0 +1,254 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "RenderCommands.h"
+#include "Rendering/Platform/Mesh.h"
+#include "Rendering/Platform/Shader.h"
+#include "Rendering/Platform/Material.h"
+#include "Rendering/Platform/Buffer/VertexArrayObject.h"
+#include "GLExtensions.h"
+#include "GeometryPool.h"
+
+using namespace Engine;
+
+void RenderQueue::Clear() {
+	_packets.clear();
+	_shaderIds.clear();
+	_materialIds.clear();
+	_meshIds.clear();
+	_stats = {};
+}
+
+void RenderQueue::Submit(Material& material, Mesh& mesh, const glm::mat4& transform, float depth, uint32_t entityId, uint8_t pipelineState) {
+	for (uint32_t i = 0; i < mesh.GetSubmeshCount(); i++)
+		Submit(material, mesh.GetSubmesh(i), transform, depth, entityId, pipelineState);
+}
+
+void RenderQueue::Submit(Material& material, VertexArrayObject& vertexArray, const glm::mat4& transform, float depth, uint32_t entityId, uint8_t pipelineState) {
+	Shader* shader = &material.GetShader();
+
+	DrawPacket packet;
+	packet.key = Utils::BuildKey(pipelineState,
+		getId(_shaderIds, shader, 0xFFF),
+		getId(_materialIds, &material, 0xFFFF),
+		getId(_meshIds, &vertexArray, 0xFFFF),
+		depth);
+	packet.material = &material;
+	packet.shader = shader;
+	packet.vertexArray = &vertexArray;
+	packet.transform = transform;
+	packet.depth = depth;
+	packet.entityId = entityId;
+	_packets.push_back(packet);
+}
+
+void RenderQueue::Sort() {
+	std::sort(_packets.begin(), _packets.end(), [](const DrawPacket& a, const DrawPacket& b) {
+		return a.key < b.key;
+	});
+}
+
+void RenderQueue::Execute() {
+	buildBatches();
+
+	Shader* currentShader = nullptr;
+	Material* currentMaterial = nullptr;
+	UniformHandle instancingHandle;
+	UniformHandle octahedralHandle;
+	int32_t instancingState = -1;
+	int32_t octahedralState = -1;
+
+	for (const auto& batch : _batches) {
+		const auto& first = _packets[batch.firstPacket];
+
+		if (first.shader != currentShader) {
+			currentShader = first.shader;
+			instancingHandle = currentShader->GetUniformHandle(INSTANCING_UNIFORM_NAME);
+			octahedralHandle = currentShader->GetUniformHandle(OCTAHEDRAL_NORMALS_UNIFORM_NAME);
+			_stats.shaderBinds++;
+		}
+
+		if (first.material != currentMaterial) {
+			currentMaterial = first.material;
+			currentMaterial->Bind();
+			// The material may have reset the switches to its own stored values
+			instancingState = -1;
+			octahedralState = -1;
+			_stats.materialBinds++;
+		}
+
+		bool instanced = batch.type != BatchType::Single;
+		if (instancingHandle.IsValid() && instancingState != (int32_t)instanced) {
+			currentShader->SetUniform(instancingHandle, instanced);
+			instancingState = (int32_t)instanced;
+		}
+
+		bool octahedral = batch.vertexArray->GetVertexDecoding().octahedralNormals;
+		if (octahedralHandle.IsValid() && octahedralState != (int32_t)octahedral) {
+			currentShader->SetUniform(octahedralHandle, octahedral);
+			octahedralState = (int32_t)octahedral;
+		}
+
+		switch (batch.type) {
+		case BatchType::Single:
+			for (uint32_t i = 0; i < batch.count; i++) {
+				_objectData.Bind(batch.firstData + i);
+				RenderCommands::DrawVertexArray(*_packets[batch.firstPacket + i].vertexArray);
+				_stats.drawCalls++;
+			}
+			break;
+		case BatchType::Instanced:
+			batch.vertexArray->SetInstanceOffset(batch.firstData);
+			RenderCommands::DrawVertexArrayInstanced(*batch.vertexArray, batch.count);
+			_stats.instancedBatches++;
+			_stats.drawCalls++;
+			break;
+		case BatchType::MultiDraw:
+			_stats.drawCalls += RenderCommands::MultiDrawIndirect(*batch.vertexArray, _commands.data(), batch.firstCommand, batch.commandCount, _indirectBuffer.get());
+			_stats.multiDrawBatches++;
+			break;
+		}
+	}
+
+	_stats.packets = (uint32_t)_packets.size();
+}
+
+void RenderQueue::buildBatches() {
+	_batches.clear();
+	_commands.clear();
+	_objectData.Clear();
+	_instanceData.clear();
+
+	// Packets are sorted, so equal material and mesh pairs are already next to each other
+	for (uint32_t i = 0; i < (uint32_t)_packets.size();) {
+		const auto& first = _packets[i];
+		bool canInstance = _instancingEnabled && first.shader->GetUniformHandle(INSTANCING_UNIFORM_NAME).IsValid();
+
+		if (canInstance && _geometryPool) {
+			uint32_t consumed = buildMultiDrawBatch(i);
+			if (consumed > 0) {
+				i += consumed;
+				continue;
+			}
+		}
+
+		uint32_t count = 1;
+		while (i + count < _packets.size()
+			&& _packets[i + count].material == first.material
+			&& _packets[i + count].vertexArray == first.vertexArray)
+			count++;
+
+		Batch batch{ BatchType::Single, i, count, first.vertexArray, 0, 0, 0 };
+		if (canInstance && count >= MIN_INSTANCE_BATCH) {
+			batch.type = BatchType::Instanced;
+			batch.firstData = (uint32_t)_instanceData.size();
+			for (uint32_t j = i; j < i + count; j++) {
+				InstanceData data;
+				Utils::GetMatrices(_packets[j], data.model, data.normalMatrix);
+				_instanceData.push_back(data);
+			}
+		}
+		else {
+			batch.firstData = _objectData.GetCount();
+			for (uint32_t j = i; j < i + count; j++) {
+				glm::mat4 model;
+				glm::mat3 normalMatrix;
+				Utils::GetMatrices(_packets[j], model, normalMatrix);
+				_objectData.Push(model, normalMatrix, _packets[j].entityId);
+			}
+		}
+
+		_batches.push_back(batch);
+		i += count;
+	}
+
+	// Both streams go up in one contiguous write each
+	_objectData.Upload();
+
+	// So are the commands of every multi draw, each batch reads its own slice
+	if (!_commands.empty() && GLExtensions::HasMultiDrawIndirect()) {
+		if (!_indirectBuffer)
+			_indirectBuffer = std::make_unique<IndirectBufferObject>(BufferUsage::Stream);
+		_indirectBuffer->SetData(_commands.data(), _commands.size() * sizeof(DrawElementsIndirectCommand));
+	}
+
+	if (_instanceData.empty())
+		return;
+
+	if (!_instanceBuffer)
+		_instanceBuffer = std::make_shared<VertexBufferObject>(BufferUsage::Stream);
+
+	_instanceBuffer->SetData(_instanceData.data(), (uint32_t)_instanceData.size(), {
+		{ "iModel", LType::Float, 16, 1 },
+		{ "iNormalMatrix", LType::Float, 9, 1 }
+	});
+
+	for (const auto& batch : _batches) {
+		if (batch.type != BatchType::Single && batch.vertexArray->GetInstanceBuffer() != _instanceBuffer)
+			batch.vertexArray->SetInstanceBuffer(_instanceBuffer, INSTANCE_ATTRIBUTE_LOCATION);
+	}
+}
+
+uint32_t RenderQueue::buildMultiDrawBatch(uint32_t firstPacket) {
+	const auto& first = _packets[firstPacket];
+	const GeometryAllocation& firstAllocation = _geometryPool->Acquire(*first.vertexArray);
+	if (!firstAllocation.IsValid())
+		return 0;
+
+	Batch batch{ BatchType::MultiDraw, firstPacket, 0, firstAllocation.vertexArray, (uint32_t)_instanceData.size(), (uint32_t)_commands.size(), 0 };
+
+	// Take every following packet of the material that lives in the same page, one command per mesh
+	uint32_t i = firstPacket;
+	while (i < _packets.size() && _packets[i].material == first.material) {
+		VertexArrayObject* mesh = _packets[i].vertexArray;
+		const GeometryAllocation& allocation = _geometryPool->Acquire(*mesh);
+		if (!allocation.IsValid() || allocation.vertexArray != batch.vertexArray)
+			break;
+
+		uint32_t baseInstance = (uint32_t)_instanceData.size();
+		for (; i < _packets.size() && _packets[i].material == first.material && _packets[i].vertexArray == mesh; i++) {
+			InstanceData data;
+			Utils::GetMatrices(_packets[i], data.model, data.normalMatrix);
+			_instanceData.push_back(data);
+		}
+
+		_commands.push_back({ allocation.indexCount, (uint32_t)_instanceData.size() - baseInstance, allocation.firstIndex, allocation.baseVertex, baseInstance });
+		batch.commandCount++;
+	}
+
+	batch.count = i - firstPacket;
+	_batches.push_back(batch);
+	return batch.count;
+}
+
+uint32_t RenderQueue::getId(std::unordered_map<const void*, uint32_t>& ids, const void* object, uint32_t maxId) {
+	auto it = ids.find(object);
+	if (it != ids.end())
+		return it->second;
+
+	// Past the limit objects share the last id, they still draw correctly but may no longer group
+	uint32_t id = std::min((uint32_t)ids.size(), maxId);
+	ids[object] = id;
+	return id;
+}
+
+uint64_t RenderQueue::Utils::BuildKey(uint8_t pipelineState, uint32_t shaderId, uint32_t materialId, uint32_t meshId, float depth) {
+	// Positive floats order the same as their bit patterns, so the top bits are a coarse depth
+	uint32_t depthBits = 0;
+	if (depth > 0.0f)
+		memcpy(&depthBits, &depth, sizeof(float));
+
+	return ((uint64_t)(pipelineState & 0xF) << 60)
+		| ((uint64_t)(shaderId & 0xFFF) << 48)
+		| ((uint64_t)(materialId & 0xFFFF) << 32)
+		| ((uint64_t)(meshId & 0xFFFF) << 16)
+		| (uint64_t)(depthBits >> 16);
+}
+
+void RenderQueue::Utils::GetMatrices(const DrawPacket& packet, glm::mat4& model, glm::mat3& normalMatrix) {
+	normalMatrix = glm::transpose(glm::inverse(glm::mat3(packet.transform)));
+	const VertexDecoding& decoding = packet.vertexArray->GetVertexDecoding();
+	model = decoding.HasPositionTransform() ? packet.transform * decoding.GetPositionTransform() : packet.transform;
+}
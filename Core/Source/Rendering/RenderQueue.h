@@ -0,0 +1,124 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "ObjectDataBuffer.h"
+#include "RenderCommands.h"
+#include "Rendering/Platform/Buffer/IndirectBufferObject.h"
+
+namespace Engine {
+	class Mesh;
+	class Shader;
+	class Material;
+	class VertexArrayObject;
+	class VertexBufferObject;
+	class GeometryPool;
+
+	// One draw, everything needed to submit it without touching the scene again
+	struct DrawPacket {
+		uint64_t key;
+		Material* material;
+		Shader* shader;
+		VertexArrayObject* vertexArray;
+		glm::mat4 transform;
+		float depth;
+		uint32_t entityId;
+	};
+
+	struct RenderQueueStats {
+		uint32_t packets = 0;
+		uint32_t shaderBinds = 0;
+		uint32_t materialBinds = 0;
+		uint32_t drawCalls = 0;
+		uint32_t instancedBatches = 0;
+		uint32_t multiDrawBatches = 0;
+	};
+
+	// Collects draw packets, sorts them by key and submits them, so that shader and material
+	// binds only happen once per group instead of once per draw. Transforms never touch the
+	// material, they are written to the ObjectData block once per frame.
+	// Key layout (msb to lsb): pipeline state 4 | shader 12 | material 16 | mesh 16 | depth 16
+	//
+	// Runs of packets sharing a material and mesh are drawn as one instanced call when the shader
+	// declares a `useInstancing` bool, with the per instance model (mat4) and normal (mat3) matrices
+	// read from attributes starting at INSTANCE_ATTRIBUTE_LOCATION.
+	//
+	// Meshes imported with encoded attributes get their position decoding folded into the model matrix,
+	// and shaders declaring an `octahedralNormals` bool have it set for meshes whose normals need decoding.
+	//
+	// With a geometry pool set, the same shaders instead get every run of a material whose meshes share a
+	// pool page submitted as a single multi draw, one command per mesh.
+	class RenderQueue {
+	public:
+		static const uint32_t INSTANCE_ATTRIBUTE_LOCATION = 8;
+		static const uint32_t MIN_INSTANCE_BATCH = 2;
+		static constexpr const char* INSTANCING_UNIFORM_NAME = "useInstancing";
+		static constexpr const char* OCTAHEDRAL_NORMALS_UNIFORM_NAME = "octahedralNormals";
+
+		RenderQueue(uint32_t objectDataBindingPoint = ObjectDataBuffer::DEFAULT_BINDING_POINT)
+			: _objectData(objectDataBindingPoint) {}
+
+		void Clear();
+
+		// Adds one packet per submesh, depth is the view distance used for front to back ordering
+		void Submit(Material& material, Mesh& mesh, const glm::mat4& transform, float depth, uint32_t entityId = 0, uint8_t pipelineState = 0);
+		void Submit(Material& material, VertexArrayObject& vertexArray, const glm::mat4& transform, float depth, uint32_t entityId = 0, uint8_t pipelineState = 0);
+
+		void Sort();
+		void Execute();
+
+		inline const std::vector<DrawPacket>& GetPackets() const { return _packets; }
+		inline const RenderQueueStats& GetStats() const { return _stats; }
+
+		inline void SetInstancingEnabled(bool enabled) { _instancingEnabled = enabled; }
+		inline bool IsInstancingEnabled() const { return _instancingEnabled; }
+
+		// nullptr disables the multi draw path
+		inline void SetGeometryPool(GeometryPool* geometryPool) { _geometryPool = geometryPool; }
+		inline GeometryPool* GetGeometryPool() const { return _geometryPool; }
+	private:
+		void buildBatches();
+		// Returns the number of packets consumed, 0 if the run could not be pooled
+		uint32_t buildMultiDrawBatch(uint32_t firstPacket);
+		uint32_t getId(std::unordered_map<const void*, uint32_t>& ids, const void* object, uint32_t maxId);
+
+		struct Utils {
+			static uint64_t BuildKey(uint8_t pipelineState, uint32_t shaderId, uint32_t materialId, uint32_t meshId, float depth);
+			// The normal matrix only comes from the packet transform, the mesh's position decoding is applied to the model alone
+			static void GetMatrices(const DrawPacket& packet, glm::mat4& model, glm::mat3& normalMatrix);
+		};
+	private:
+		struct InstanceData { glm::mat4 model; glm::mat3 normalMatrix; };
+		enum class BatchType : uint8_t { Single, Instanced, MultiDraw };
+		// A run of packets with the same material, and the same mesh unless it is a multi draw
+		struct Batch {
+			BatchType type;
+			uint32_t firstPacket;
+			uint32_t count;
+			VertexArrayObject* vertexArray;
+			uint32_t firstData; // first object data or instance data entry
+			uint32_t firstCommand;
+			uint32_t commandCount;
+		};
+
+		std::vector<DrawPacket> _packets;
+		std::vector<Batch> _batches;
+		ObjectDataBuffer _objectData;
+		std::vector<InstanceData> _instanceData;
+		std::shared_ptr<VertexBufferObject> _instanceBuffer;
+		std::vector<DrawElementsIndirectCommand> _commands;
+		std::unique_ptr<IndirectBufferObject> _indirectBuffer;
+		bool _instancingEnabled = true;
+		GeometryPool* _geometryPool = nullptr;
+		RenderQueueStats _stats;
+
+		// Small per frame ids for the key, assigned in submission order
+		std::unordered_map<const void*, uint32_t> _shaderIds;
+		std::unordered_map<const void*, uint32_t> _materialIds;
+		std::unordered_map<const void*, uint32_t> _meshIds;
+	};
+}
@@ -0,0 +1,34 @@
+#include "RenderThreadQueue.h"
+
+#include <mutex>
+#include <vector>
+
+using namespace Engine;
+
+namespace {
+	std::mutex queueMutex;
+	std::vector<std::function<void()>> queue;
+}
+
+void RenderThreadQueue::Enqueue(std::function<void()> job) {
+	std::lock_guard<std::mutex> lock(queueMutex);
+	queue.push_back(std::move(job));
+}
+
+uint32_t RenderThreadQueue::Execute() {
+	// Taken out under the lock and run without it, so jobs can enqueue more work for the next frame
+	std::vector<std::function<void()>> jobs;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		jobs.swap(queue);
+	}
+
+	for (auto& job : jobs)
+		job();
+	return (uint32_t)jobs.size();
+}
+
+void RenderThreadQueue::Clear() {
+	std::lock_guard<std::mutex> lock(queueMutex);
+	queue.clear();
+}
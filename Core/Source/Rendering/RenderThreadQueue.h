@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+namespace Engine {
+	// Work handed to the GL thread by other threads (eg. uploads of textures decoded by a worker),
+	// run at the start of every frame
+	class RenderThreadQueue {
+	public:
+		// Safe to call from any thread
+		static void Enqueue(std::function<void()> job);
+		// Runs everything enqueued so far, must be called on the GL thread. Returns the number of jobs run.
+		static uint32_t Execute();
+		// Drops the jobs that have not run yet
+		static void Clear();
+	};
+}
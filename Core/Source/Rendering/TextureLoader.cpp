@@ -0,0 +1,217 @@
+#include "TextureLoader.h"
+
+#include <atomic>
+
+#include "Logging/Logging.h"
+#include "Rendering/RenderThreadQueue.h"
+#include "Rendering/TextureUploadQueue.h"
+#include "Rendering/TextureResidency.h"
+#include "Util/ThreadPool.h"
+
+using namespace Engine;
+
+namespace {
+	std::unique_ptr<ThreadPool> pool;
+	std::atomic<bool> cancelled = false;
+	TextureLoaderStats stats; // Only touched on the GL thread
+
+	// Levels up to this size in total are uploaded as soon as the texture is decoded
+	const uint64_t IMMEDIATE_UPLOAD_BYTES = 64 * 1024;
+
+	void finish(const std::shared_ptr<Texture2D>& texture, const TextureSource& source, const std::function<void(std::shared_ptr<Texture2D>)>& onLoaded) {
+		stats.completed++;
+		if (texture)
+			TextureResidency::Register(texture, source);
+		if (onLoaded)
+			onLoaded(texture);
+	}
+
+	void upload(std::shared_ptr<DecodedTexture> decoded, const TextureSource& source, std::weak_ptr<Texture2D> target, std::function<void(std::shared_ptr<Texture2D>)> onLoaded) {
+		auto placeholder = target.lock();
+		if (!placeholder) {
+			stats.discarded++;
+			return;
+		}
+
+		auto texture = Texture2D::Utils::Allocate(*decoded);
+		if (!texture) {
+			ENGINE_ERROR("[TextureLoader::upload] Failed to load '{}'", decoded->path);
+			stats.failed++;
+			if (onLoaded)
+				onLoaded(nullptr);
+			return;
+		}
+
+		// Only the GPU can fill the chain and only from the complete base level, so nothing is streamed
+		if (decoded->NeedsMipmapGeneration()) {
+			texture = Texture2D::Utils::Create(*decoded);
+			placeholder->Swap(*texture);
+			finish(placeholder, source, onLoaded);
+			return;
+		}
+
+		// The coarse levels are small, uploading them straight away keeps the placeholder on screen for one frame at most
+		uint32_t levelCount = decoded->GetLevelCount();
+		uint32_t firstUploaded = levelCount;
+		uint64_t bytes = 0;
+		while (firstUploaded > 0 && bytes + texture->GetLevelDataSize(firstUploaded - 1) <= IMMEDIATE_UPLOAD_BYTES) {
+			firstUploaded--;
+			bytes += texture->GetLevelDataSize(firstUploaded);
+			texture->SetData(decoded->GetLevelData(firstUploaded), firstUploaded);
+		}
+
+		if (firstUploaded == levelCount) {
+			// Not even the coarsest level is small, the placeholder stays until the whole texture is in
+			TextureUploadQueue::Enqueue(texture, decoded, levelCount, [texture, source, target, onLoaded](bool) {
+				auto placeholder = target.lock();
+				if (!placeholder) {
+					stats.discarded++;
+					return;
+				}
+				placeholder->Swap(*texture);
+				finish(placeholder, source, onLoaded);
+			});
+			return;
+		}
+
+		// The placeholder's texture goes away with the temporary, the rest streams into the placeholder
+		texture->SetBaseLevel(firstUploaded);
+		placeholder->Swap(*texture);
+		TextureUploadQueue::Enqueue(placeholder, decoded, firstUploaded, [source, target, onLoaded](bool uploaded) {
+			if (uploaded)
+				finish(target.lock(), source, onLoaded);
+			else
+				stats.discarded++;
+		});
+	}
+
+	void restore(std::shared_ptr<DecodedTexture> decoded, std::weak_ptr<Texture2D> target, uint32_t levels, std::function<void(bool)> onDone) {
+		auto texture = target.lock();
+		auto full = texture ? Texture2D::Utils::Allocate(*decoded) : nullptr;
+		if (!full) {
+			if (onDone)
+				onDone(false);
+			return;
+		}
+
+		// The whole texture is uploaded again if the GPU builds the chain or the source has changed since it was loaded
+		if (decoded->NeedsMipmapGeneration() || full->GetFormat() != texture->GetFormat() || full->GetMipLevels() != texture->GetMipLevels() + levels) {
+			full = Texture2D::Utils::Create(*decoded);
+			full->SetSampler(texture->GetSampler());
+			texture->Swap(*full);
+			if (onDone)
+				onDone(true);
+			return;
+		}
+
+		// The levels still held move down the new chain, the finest ones stream in above them
+		full->CopyLevelsFrom(*texture, 0, levels, texture->GetMipLevels());
+		full->SetBaseLevel(levels);
+		full->SetSampler(texture->GetSampler());
+		texture->Swap(*full);
+		TextureUploadQueue::Enqueue(texture, decoded, levels, onDone);
+	}
+}
+
+void TextureLoader::Initialize(uint32_t threadCount) {
+	if (pool)
+		return;
+
+	cancelled = false;
+	pool = std::make_unique<ThreadPool>(threadCount);
+	ENGINE_INFO("[TextureLoader::Initialize] Decoding textures on {} threads", pool->GetThreadCount());
+}
+
+void TextureLoader::Shutdown() {
+	cancelled = true;
+	pool = nullptr;
+	RenderThreadQueue::Clear();
+	TextureUploadQueue::Shutdown();
+}
+
+bool TextureLoader::IsInitialized() {
+	return pool != nullptr;
+}
+
+std::shared_ptr<Texture2D> TextureLoader::LoadAsync(const TextureSource& source, std::function<void(std::shared_ptr<Texture2D>)> onLoaded) {
+	stats.requested++;
+
+	if (!pool) {
+		auto decoded = Texture2D::Utils::Decode(source);
+		auto texture = Texture2D::Utils::Create(decoded);
+		if (!texture) {
+			stats.failed++;
+			if (onLoaded)
+				onLoaded(nullptr);
+			return Utils::CreatePlaceholder();
+		}
+
+		finish(texture, source, onLoaded);
+		return texture;
+	}
+
+	auto placeholder = Utils::CreatePlaceholder();
+	std::weak_ptr<Texture2D> target = placeholder;
+
+	pool->Submit([source, target, onLoaded]() {
+		if (cancelled)
+			return;
+
+		// Streamed levels have to exist on the CPU, so chains that would be generated on the GPU are filtered here
+		TextureSource streamed = source;
+		if (streamed.mips == MipGeneration::GPU)
+			streamed.mips = MipGeneration::Box;
+
+		// Shared so the job can be copied into the queue, the pixels are freed once the last level is uploaded
+		auto decoded = std::make_shared<DecodedTexture>(Texture2D::Utils::Decode(streamed));
+		RenderThreadQueue::Enqueue([decoded, streamed, target, onLoaded]() {
+			upload(decoded, streamed, target, onLoaded);
+		});
+	});
+
+	return placeholder;
+}
+
+void TextureLoader::Restream(const std::shared_ptr<Texture2D>& texture, const TextureSource& source, uint32_t levels, std::function<void(bool)> onDone) {
+	std::weak_ptr<Texture2D> target = texture;
+	auto decode = [source, target, levels, onDone]() {
+		if (cancelled)
+			return;
+
+		auto decoded = std::make_shared<DecodedTexture>(Texture2D::Utils::Decode(source));
+		RenderThreadQueue::Enqueue([decoded, target, levels, onDone]() {
+			restore(decoded, target, levels, onDone);
+		});
+	};
+
+	if (pool)
+		pool->Submit(decode);
+	else
+		decode();
+}
+
+void TextureLoader::WaitIdle() {
+	if (pool)
+		pool->WaitIdle();
+	RenderThreadQueue::Execute();
+
+	// Staging regions are fenced, so this waits on the GPU rather than overrunning it
+	while (!TextureUploadQueue::IsIdle())
+		TextureUploadQueue::Process();
+}
+
+const TextureLoaderStats& TextureLoader::GetStats() {
+	return stats;
+}
+
+std::shared_ptr<Texture2D> TextureLoader::Utils::CreatePlaceholder() {
+	TextureSpec spec;
+	spec.width = 1;
+	spec.height = 1;
+	spec.format = ImageFormat::RGBA8;
+
+	static const uint8_t grey[4] = { 128, 128, 128, 255 };
+	auto texture = std::make_shared<Texture2D>(spec);
+	texture->SetData(grey);
+	return texture;
+}
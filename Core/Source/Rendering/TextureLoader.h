@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "Rendering/Platform/Texture2D.h"
+
+namespace Engine {
+	struct TextureLoaderStats {
+		uint32_t requested = 0;
+		uint32_t completed = 0;
+		uint32_t failed = 0;
+		uint32_t discarded = 0; // Finished after every reference to the placeholder was dropped
+
+		inline uint32_t GetPending() const { return requested - completed - failed - discarded; }
+	};
+
+	// Decodes textures on a pool of worker threads and uploads them on the GL thread through the
+	// RenderThreadQueue. Callers get a placeholder straight away which takes over the loaded texture
+	// in place once its coarse levels are uploaded, so anything already holding it (eg. materials) picks
+	// it up. The finer levels follow through the TextureUploadQueue within its per frame budget.
+	class TextureLoader {
+	public:
+		// 0 threads uses every hardware thread except the GL thread
+		static void Initialize(uint32_t threadCount = 0);
+		// Waits for the decodes already running, the rest are dropped
+		static void Shutdown();
+		static bool IsInitialized();
+
+		// Without a running loader the texture is loaded before returning. onLoaded runs on the GL thread
+		// with the now loaded texture, or nullptr if it failed to load and stays a placeholder.
+		static std::shared_ptr<Texture2D> LoadAsync(const TextureSource& source, std::function<void(std::shared_ptr<Texture2D>)> onLoaded = nullptr);
+		// Decodes the source again and streams its finest levels back into a texture that holds the rest of the
+		// chain (see Texture2D::DropTopLevels). onDone runs on the GL thread, with false if the texture was released.
+		static void Restream(const std::shared_ptr<Texture2D>& texture, const TextureSource& source, uint32_t levels, std::function<void(bool)> onDone = nullptr);
+		// Blocks until every requested texture has been decoded and uploaded, must be called on the GL thread
+		static void WaitIdle();
+
+		static const TextureLoaderStats& GetStats();
+
+		struct Utils {
+			// 1x1 mid grey
+			static std::shared_ptr<Texture2D> CreatePlaceholder();
+		};
+	};
+}
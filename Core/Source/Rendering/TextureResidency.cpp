@@ -0,0 +1,173 @@
+#include "TextureResidency.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Logging/Logging.h"
+#include "Rendering/GLStateCache.h"
+#include "Rendering/TextureLoader.h"
+
+using namespace Engine;
+
+namespace {
+	struct ManagedTexture {
+		std::weak_ptr<Texture2D> texture;
+		TextureSource source;
+		uint64_t fullSize = 0;       // Storage with every level resident
+		uint32_t droppedLevels = 0;
+		uint32_t failedRestores = 0;
+		bool restoring = false;
+	};
+
+	// A source that keeps failing to decode is left reduced rather than read again every frame
+	const uint32_t MAX_RESTORE_ATTEMPTS = 3;
+
+	// Shared with the restore callbacks, which can outlive an entry being erased
+	std::vector<std::shared_ptr<ManagedTexture>> managed;
+	float budget = TextureResidency::DEFAULT_BUDGET_MB;
+	TextureResidencyStats stats;
+
+	uint32_t droppableLevels(const Texture2D& texture) {
+		uint32_t size = std::max(texture.GetWidth(), texture.GetHeight());
+		uint32_t levels = 0;
+		while ((size >> (levels + 1)) >= TextureResidency::MIN_RESIDENT_SIZE)
+			levels++;
+		return std::min(levels, texture.GetMipLevels() - 1);
+	}
+
+	// Storage saved by dropping the finest levels
+	uint64_t droppedSize(const Texture2D& texture, uint32_t levels) {
+		uint64_t size = 0;
+		for (uint32_t level = 0; level < levels; level++)
+			size += Utils::ImageFormatStorageSize(texture.GetFormat(), std::max(texture.GetWidth() >> level, 1u), std::max(texture.GetHeight() >> level, 1u));
+		return size;
+	}
+}
+
+void TextureResidency::Register(const std::shared_ptr<Texture2D>& texture, const TextureSource& source) {
+	for (const auto& entry : managed) {
+		if (entry->texture.lock() == texture)
+			return;
+	}
+
+	auto entry = std::make_shared<ManagedTexture>();
+	entry->texture = texture;
+	entry->source = source;
+	entry->fullSize = texture->GetStorageSize();
+	managed.push_back(entry);
+}
+
+void TextureResidency::Update() {
+	managed.erase(std::remove_if(managed.begin(), managed.end(), [](const std::shared_ptr<ManagedTexture>& entry) {
+		return entry->texture.expired();
+	}), managed.end());
+
+	uint64_t budgetBytes = (uint64_t)(budget * 1024.0f * 1024.0f);
+	uint64_t frame = GLStateCache::GetFrameIndex();
+	uint64_t used = BaseTexture::GetStats().storageBytes;
+
+	// Restores in flight already have their room reserved
+	for (const auto& entry : managed) {
+		if (entry->restoring) {
+			auto texture = entry->texture.lock();
+			used += entry->fullSize - std::min(entry->fullSize, texture->GetStorageSize());
+		}
+	}
+
+	// Least recently bound first
+	std::vector<std::pair<std::shared_ptr<ManagedTexture>, std::shared_ptr<Texture2D>>> candidates;
+	for (const auto& entry : managed) {
+		auto texture = entry->texture.lock();
+		// Levels that are still streaming in cannot be dropped
+		if (!entry->restoring && texture->GetBaseLevel() == 0)
+			candidates.emplace_back(entry, texture);
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+		return a.second->GetLastBoundFrame() < b.second->GetLastBoundFrame();
+	});
+
+	if (used > budgetBytes) {
+		for (auto& [entry, texture] : candidates) {
+			if (used <= budgetBytes)
+				break;
+
+			// Just enough levels to get under the budget, as far as this texture allows
+			uint32_t available = droppableLevels(*texture);
+			uint32_t levels = 0;
+			while (levels < available && used - droppedSize(*texture, levels) > budgetBytes)
+				levels++;
+			if (levels == 0)
+				continue;
+
+			used -= droppedSize(*texture, levels);
+			texture->DropTopLevels(levels);
+			entry->droppedLevels += levels;
+			stats.evictions++;
+		}
+	}
+	else {
+		// Most recently bound first, only textures that are actually being drawn come back
+		for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+			auto& [entry, texture] = *it;
+			if (entry->droppedLevels == 0 || entry->failedRestores >= MAX_RESTORE_ATTEMPTS || frame - texture->GetLastBoundFrame() > IN_USE_FRAMES)
+				continue;
+
+			uint64_t restoreSize = entry->fullSize - std::min(entry->fullSize, texture->GetStorageSize());
+			if (used + restoreSize > budgetBytes)
+				continue;
+
+			used += restoreSize;
+			entry->restoring = true;
+			stats.restores++;
+
+			std::weak_ptr<ManagedTexture> weakEntry = entry;
+			TextureLoader::Restream(texture, entry->source, entry->droppedLevels, [weakEntry](bool success) {
+				auto entry = weakEntry.lock();
+				if (!entry)
+					return;
+
+				entry->restoring = false;
+				if (!success) {
+					// The texture keeps the levels it had, so they are still counted as dropped
+					entry->failedRestores++;
+					ENGINE_WARN("[TextureResidency::Update] Could not restore {} (attempt {} of {})", entry->source.path, entry->failedRestores, MAX_RESTORE_ATTEMPTS);
+					return;
+				}
+
+				entry->droppedLevels = 0;
+				entry->failedRestores = 0;
+				if (auto texture = entry->texture.lock())
+					entry->fullSize = texture->GetStorageSize();
+			});
+		}
+	}
+
+	stats.budgetBytes = budgetBytes;
+	stats.storageBytes = BaseTexture::GetStats().storageBytes;
+	stats.managed = (uint32_t)managed.size();
+	stats.managedBytes = 0;
+	stats.reduced = 0;
+	for (const auto& entry : managed) {
+		if (auto texture = entry->texture.lock())
+			stats.managedBytes += texture->GetStorageSize();
+		if (entry->droppedLevels > 0)
+			stats.reduced++;
+	}
+}
+
+void TextureResidency::Shutdown() {
+	managed.clear();
+	stats = {};
+}
+
+void TextureResidency::SetBudget(float megabytes) {
+	budget = std::max(megabytes, 1.0f);
+}
+
+float TextureResidency::GetBudget() {
+	return budget;
+}
+
+const TextureResidencyStats& TextureResidency::GetStats() {
+	return stats;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+#include "Rendering/Platform/Texture2D.h"
+
+namespace Engine {
+	struct TextureResidencyStats {
+		uint64_t budgetBytes = 0;
+		uint64_t storageBytes = 0; // Every texture, managed or not
+		uint64_t managedBytes = 0;
+		uint32_t managed = 0;
+		uint32_t reduced = 0;      // Managed textures currently missing finest levels
+		uint32_t evictions = 0;
+		uint32_t restores = 0;
+	};
+
+	// Keeps texture memory within a budget. While every texture together is over it, the least recently
+	// bound textures loaded by the TextureLoader lose their finest levels, and textures that are bound again
+	// get them streamed back from their source once there is room. Other textures (eg. render targets)
+	// count towards the budget but are never touched.
+	class TextureResidency {
+	public:
+		static constexpr float DEFAULT_BUDGET_MB = 1024.0f;
+		// Levels are never dropped below this size on the longest side
+		static constexpr uint32_t MIN_RESIDENT_SIZE = 64;
+		// Bound within this many frames counts as in use
+		static constexpr uint32_t IN_USE_FRAMES = 2;
+
+		// Called by the TextureLoader once a texture is fully uploaded, the source is loaded again to restore it
+		static void Register(const std::shared_ptr<Texture2D>& texture, const TextureSource& source);
+		// Evicts or restores textures, once per frame on the GL thread
+		static void Update();
+		static void Shutdown();
+
+		static void SetBudget(float megabytes);
+		static float GetBudget();
+
+		static const TextureResidencyStats& GetStats();
+	};
+}
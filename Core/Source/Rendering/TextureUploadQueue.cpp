@@ -0,0 +1,174 @@
+#include "TextureUploadQueue.h"
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Logging/Logging.h"
+#include "Rendering/Platform/Buffer/StreamingBuffer.h"
+
+using namespace Engine;
+
+namespace {
+	struct PendingUpload {
+		std::weak_ptr<Texture2D> texture;
+		std::shared_ptr<DecodedTexture> decoded;
+		uint32_t level = 0;        // Next level to upload, counts down to 0
+		uint32_t uploadedRows = 0; // Rows of that level already sent, in blocks for compressed formats
+		std::function<void(bool)> onComplete;
+	};
+
+	std::vector<PendingUpload> pending;
+	std::unique_ptr<StreamingBuffer> stagingBuffer;
+	float budget = TextureUploadQueue::DEFAULT_BUDGET_MB;
+	TextureUploadStats stats;
+
+	// Compressed levels are uploaded in whole rows of blocks
+	uint32_t rowHeight(const Texture2D& texture) {
+		return Utils::ImageFormatIsCompressed(texture.GetFormat()) ? 4 : 1;
+	}
+
+	uint32_t rowCount(const Texture2D& texture, uint32_t level) {
+		uint32_t height = std::max(texture.GetHeight() >> level, 1u);
+		return (height + rowHeight(texture) - 1) / rowHeight(texture);
+	}
+
+	uint64_t remainingBytes(const PendingUpload& upload, const Texture2D& texture) {
+		uint64_t bytes = texture.GetLevelDataSize(upload.level) / rowCount(texture, upload.level) * (rowCount(texture, upload.level) - upload.uploadedRows);
+		for (uint32_t level = 0; level < upload.level; level++)
+			bytes += texture.GetLevelDataSize(level);
+		return bytes;
+	}
+}
+
+void TextureUploadQueue::Enqueue(const std::shared_ptr<Texture2D>& texture, std::shared_ptr<DecodedTexture> decoded, uint32_t levelCount,
+	std::function<void(bool)> onComplete) {
+	levelCount = std::min(levelCount, decoded->GetLevelCount());
+	if (levelCount == 0) {
+		if (onComplete)
+			onComplete(true);
+		return;
+	}
+
+	PendingUpload upload;
+	upload.texture = texture;
+	upload.decoded = std::move(decoded);
+	upload.level = levelCount - 1;
+	upload.onComplete = std::move(onComplete);
+	pending.push_back(std::move(upload));
+}
+
+void TextureUploadQueue::Process() {
+	stats.bytesLastFrame = 0;
+	if (pending.empty())
+		return;
+
+	uint64_t budgetBytes = (uint64_t)(budget * 1024.0f * 1024.0f);
+	if (!stagingBuffer)
+		stagingBuffer = std::make_unique<StreamingBuffer>(budgetBytes);
+	stagingBuffer->Reserve(budgetBytes);
+	stagingBuffer->BeginFrame();
+
+	uint64_t remaining = budgetBytes;
+	while (remaining > 0 && !pending.empty()) {
+		// Coarsest outstanding level of any texture first, oldest request on ties
+		size_t next = 0;
+		uint64_t nextArea = UINT64_MAX;
+		for (size_t i = 0; i < pending.size(); i++) {
+			auto texture = pending[i].texture.lock();
+			uint64_t area = texture ? (uint64_t)std::max(texture->GetWidth() >> pending[i].level, 1u) * std::max(texture->GetHeight() >> pending[i].level, 1u) : 0;
+			if (area < nextArea) {
+				next = i;
+				nextArea = area;
+			}
+		}
+
+		PendingUpload& upload = pending[next];
+		auto texture = upload.texture.lock();
+		if (!texture) {
+			auto onComplete = std::move(upload.onComplete);
+			pending.erase(pending.begin() + next);
+			if (onComplete)
+				onComplete(false);
+			continue;
+		}
+
+		uint32_t rows = rowCount(*texture, upload.level);
+		uint64_t rowBytes = texture->GetLevelDataSize(upload.level) / rows;
+		uint32_t rowsToUpload = (uint32_t)std::min<uint64_t>(remaining / rowBytes, rows - upload.uploadedRows);
+		if (rowsToUpload == 0) {
+			// Always make progress, even if a single row is over the budget
+			if (remaining < budgetBytes)
+				break;
+			rowsToUpload = 1;
+		}
+
+		uint64_t size = rowsToUpload * rowBytes;
+		if (size > stagingBuffer->GetRegionSize())
+			stagingBuffer->Reserve(size);
+
+		uint64_t offset;
+		const uint8_t* source = (const uint8_t*)upload.decoded->GetLevelData(upload.level) + upload.uploadedRows * rowBytes;
+		if (stagingBuffer->Write(source, size, 16, offset)) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer->GetHandle());
+			texture->SetRows(upload.level, upload.uploadedRows * rowHeight(*texture), rowsToUpload * rowHeight(*texture), (const void*)(uintptr_t)offset);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		else {
+			ENGINE_WARN("[TextureUploadQueue::Process] Staging buffer is full, uploading {} bytes directly", size);
+			texture->SetRows(upload.level, upload.uploadedRows * rowHeight(*texture), rowsToUpload * rowHeight(*texture), source);
+		}
+
+		upload.uploadedRows += rowsToUpload;
+		remaining -= std::min(remaining, size);
+		stats.bytesLastFrame += size;
+		stats.bytesTotal += size;
+
+		if (upload.uploadedRows < rows)
+			continue;
+
+		// The level is complete, so it can be sampled
+		texture->SetBaseLevel(upload.level);
+		upload.uploadedRows = 0;
+		if (upload.level > 0) {
+			upload.level--;
+			continue;
+		}
+
+		auto onComplete = std::move(upload.onComplete);
+		pending.erase(pending.begin() + next);
+		if (onComplete)
+			onComplete(true);
+	}
+
+	stagingBuffer->EndFrame();
+
+	stats.bytesPending = 0;
+	for (const auto& upload : pending) {
+		if (auto texture = upload.texture.lock())
+			stats.bytesPending += remainingBytes(upload, *texture);
+	}
+	stats.texturesPending = (uint32_t)pending.size();
+}
+
+void TextureUploadQueue::Shutdown() {
+	pending.clear();
+	stagingBuffer = nullptr;
+	stats = {};
+}
+
+bool TextureUploadQueue::IsIdle() {
+	return pending.empty();
+}
+
+void TextureUploadQueue::SetBudget(float megabytesPerFrame) {
+	budget = std::max(megabytesPerFrame, 0.25f);
+}
+
+float TextureUploadQueue::GetBudget() {
+	return budget;
+}
+
+const TextureUploadStats& TextureUploadQueue::GetStats() {
+	return stats;
+}
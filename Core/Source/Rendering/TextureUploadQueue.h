@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "Rendering/Platform/Texture2D.h"
+
+namespace Engine {
+	struct TextureUploadStats {
+		uint64_t bytesLastFrame = 0;
+		uint64_t bytesPending = 0;
+		uint64_t bytesTotal = 0;
+		uint32_t texturesPending = 0;
+	};
+
+	// Streams texture levels to the GPU through pixel unpack buffers, a bounded number of bytes per frame.
+	// Levels are uploaded coarsest first across every queued texture and large levels are split into bands
+	// of rows, each texture's base level follows the finest level that is complete so it sharpens as the
+	// levels arrive instead of the frame hitching on the whole chain.
+	class TextureUploadQueue {
+	public:
+		static constexpr float DEFAULT_BUDGET_MB = 8.0f;
+
+		// Uploads levels 0 to levelCount - 1 of decoded into texture, which must already have storage for them.
+		// onComplete runs once the last level is in, with false if the texture was released before that.
+		static void Enqueue(const std::shared_ptr<Texture2D>& texture, std::shared_ptr<DecodedTexture> decoded, uint32_t levelCount,
+			std::function<void(bool)> onComplete = nullptr);
+		// Uploads up to the budget, once per frame on the GL thread
+		static void Process();
+		// Drops everything queued and releases the staging buffer
+		static void Shutdown();
+		static bool IsIdle();
+
+		static void SetBudget(float megabytesPerFrame);
+		static float GetBudget();
+
+		static const TextureUploadStats& GetStats();
+	};
+}
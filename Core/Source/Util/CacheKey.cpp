@@ -0,0 +1,31 @@
+#include "CacheKey.h"
+
+#include <cstdio>
+#include <filesystem>
+
+using namespace Engine;
+
+std::string CacheKey::Make(const std::string& sourcePath, const std::string& settings, uint32_t version) {
+	std::error_code error;
+	auto size = std::filesystem::file_size(sourcePath, error);
+	if (error)
+		return "";
+	auto modified = std::filesystem::last_write_time(sourcePath, error);
+	if (error)
+		return "";
+
+	std::string identity = std::filesystem::absolute(sourcePath, error).generic_string() + "|" + std::to_string(size) + "|" +
+		std::to_string(modified.time_since_epoch().count()) + "|" + settings + "|" + std::to_string(version);
+
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)Hash(identity));
+	return key;
+}
+
+uint64_t CacheKey::Hash(const std::string& value, uint64_t hash) {
+	for (char c : value) {
+		hash ^= (uint8_t)c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace Engine {
+	// Names the entries of the on-disk caches. A key changes whenever the source file is moved, resized or
+	// touched, or whenever the settings or version it was built with change.
+	class CacheKey {
+	public:
+		// 16 hex digits, empty if the source file does not exist
+		static std::string Make(const std::string& sourcePath, const std::string& settings, uint32_t version);
+
+		// 64 bit FNV-1a
+		static uint64_t Hash(const std::string& value, uint64_t hash = 14695981039346656037ull);
+	};
+}
@@ -0,0 +1,382 @@
+#include "IBLBaker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Logging/Logging.h"
+#include "Util/ThreadPool.h"
+
+using namespace Engine;
+
+namespace {
+	const float PI = 3.14159265359f;
+
+	// Direction through a texel of a face, s and t in [-1, 1] along the face's GL texture axes
+	glm::vec3 faceDirection(uint32_t face, float s, float t) {
+		switch (face) {
+		case 0: return { 1.0f, -t, -s };
+		case 1: return { -1.0f, -t, s };
+		case 2: return { s, 1.0f, t };
+		case 3: return { s, -1.0f, -t };
+		case 4: return { s, -t, 1.0f };
+		default: return { -s, -t, -1.0f };
+		}
+	}
+
+	// The face a direction passes through, s and t in [0, 1]
+	uint32_t directionFace(const glm::vec3& d, float& s, float& t) {
+		glm::vec3 a = glm::abs(d);
+		uint32_t face;
+		float sc, tc, ma;
+		if (a.x >= a.y && a.x >= a.z) {
+			ma = a.x;
+			face = d.x > 0.0f ? 0 : 1;
+			sc = d.x > 0.0f ? -d.z : d.z;
+			tc = -d.y;
+		}
+		else if (a.y >= a.z) {
+			ma = a.y;
+			face = d.y > 0.0f ? 2 : 3;
+			sc = d.x;
+			tc = d.y > 0.0f ? d.z : -d.z;
+		}
+		else {
+			ma = a.z;
+			face = d.z > 0.0f ? 4 : 5;
+			sc = d.z > 0.0f ? d.x : -d.x;
+			tc = -d.y;
+		}
+		s = (sc / ma + 1.0f) * 0.5f;
+		t = (tc / ma + 1.0f) * 0.5f;
+		return face;
+	}
+
+	void shBasis(const glm::vec3& d, float basis[9]) {
+		basis[0] = 0.282095f;
+		basis[1] = 0.488603f * d.y;
+		basis[2] = 0.488603f * d.z;
+		basis[3] = 0.488603f * d.x;
+		basis[4] = 1.092548f * d.x * d.y;
+		basis[5] = 1.092548f * d.y * d.z;
+		basis[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+		basis[7] = 1.092548f * d.x * d.z;
+		basis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+	}
+
+	glm::vec2 hammersley(uint32_t i, uint32_t count) {
+		uint32_t bits = i;
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return { (float)i / (float)count, bits * 2.3283064365386963e-10f };
+	}
+
+	// Half vector around +z distributed by the GGX normal distribution
+	glm::vec3 importanceSampleGGX(const glm::vec2& xi, float roughness) {
+		float a = roughness * roughness;
+		float phi = 2.0f * PI * xi.x;
+		float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (a * a - 1.0f) * xi.y));
+		float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+		return { std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta };
+	}
+
+	float distributionGGX(float NdotH, float roughness) {
+		float a2 = roughness * roughness * roughness * roughness;
+		float denominator = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+		return a2 / (PI * denominator * denominator);
+	}
+
+	float geometrySchlickGGX(float NdotV, float roughness) {
+		// Remapped for image based lighting
+		float k = roughness * roughness / 2.0f;
+		return NdotV / (NdotV * (1.0f - k) + k);
+	}
+
+	// Bilinear and trilinear lookups into the float cubemaps produced by CubemapFromEquirectangular
+	class CubemapSampler {
+	public:
+		CubemapSampler(const TextureFileData& cubemap)
+			: _size(cubemap.width), _levelCount(cubemap.levelCount), _faces(cubemap.images.size()) {
+			for (size_t i = 0; i < cubemap.images.size(); i++)
+				_faces[i] = (const glm::vec3*)cubemap.images[i].data();
+		}
+
+		glm::vec3 Sample(const glm::vec3& direction, float level) const {
+			level = std::clamp(level, 0.0f, (float)(_levelCount - 1));
+			uint32_t level0 = (uint32_t)level;
+			uint32_t level1 = std::min(level0 + 1, _levelCount - 1);
+			float blend = level - (float)level0;
+
+			float s, t;
+			uint32_t face = directionFace(direction, s, t);
+			glm::vec3 color = sampleLevel(face, level0, s, t);
+			if (blend > 0.0f && level1 != level0)
+				color = glm::mix(color, sampleLevel(face, level1, s, t), blend);
+			return color;
+		}
+	private:
+		glm::vec3 sampleLevel(uint32_t face, uint32_t level, float s, float t) const {
+			int32_t size = (int32_t)std::max(_size >> level, 1u);
+			const glm::vec3* texels = _faces[level * 6 + face];
+
+			float x = s * size - 0.5f, y = t * size - 0.5f;
+			int32_t x0 = (int32_t)std::floor(x), y0 = (int32_t)std::floor(y);
+			float fx = x - x0, fy = y - y0;
+			int32_t x1 = std::min(x0 + 1, size - 1), y1 = std::min(y0 + 1, size - 1);
+			x0 = std::max(x0, 0);
+			y0 = std::max(y0, 0);
+
+			glm::vec3 top = glm::mix(texels[y0 * size + x0], texels[y0 * size + x1], fx);
+			glm::vec3 bottom = glm::mix(texels[y1 * size + x0], texels[y1 * size + x1], fx);
+			return glm::mix(top, bottom, fy);
+		}
+	private:
+		uint32_t _size, _levelCount;
+		std::vector<const glm::vec3*> _faces;
+	};
+
+	TextureFileData makeCubemap(ImageFormat format, uint32_t size, uint32_t levels) {
+		TextureFileData data;
+		data.format = format;
+		data.width = data.height = size;
+		data.faceCount = 6;
+		data.levelCount = levels;
+		for (uint32_t level = 0; level < levels; level++) {
+			uint32_t levelSize = std::max(size >> level, 1u);
+			for (uint32_t face = 0; face < 6; face++)
+				data.images.emplace_back((size_t)levelSize * levelSize * sizeof(glm::vec3));
+		}
+		return data;
+	}
+}
+
+glm::vec3 SphericalHarmonics9::EvaluateIrradiance(const glm::vec3& normal) const {
+	// Cosine lobe convolution per band, divided by pi
+	static const float BAND_WEIGHTS[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+
+	float basis[9];
+	shBasis(normal, basis);
+	glm::vec3 irradiance(0.0f);
+	for (uint32_t i = 0; i < 9; i++)
+		irradiance += coefficients[i] * basis[i] * BAND_WEIGHTS[i];
+	return glm::max(irradiance, glm::vec3(0.0f));
+}
+
+TextureFileData IBLBaker::CubemapFromEquirectangular(const float* pixels, uint32_t width, uint32_t height, uint32_t channels, uint32_t faceSize) {
+	// Box down to about the density of the faces first, point sampling a 4K image would alias badly
+	std::vector<glm::vec3> source((size_t)width * height);
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = { pixels[i * channels], pixels[i * channels + 1], pixels[i * channels + 2] };
+
+	while (width / 2 >= faceSize * 4 && height >= 2) {
+		uint32_t halfWidth = width / 2, halfHeight = height / 2;
+		std::vector<glm::vec3> half((size_t)halfWidth * halfHeight);
+		for (uint32_t y = 0; y < halfHeight; y++)
+			for (uint32_t x = 0; x < halfWidth; x++)
+				half[y * halfWidth + x] = (source[(2 * y) * width + 2 * x] + source[(2 * y) * width + 2 * x + 1] +
+					source[(2 * y + 1) * width + 2 * x] + source[(2 * y + 1) * width + 2 * x + 1]) * 0.25f;
+		source.swap(half);
+		width = halfWidth;
+		height = halfHeight;
+	}
+
+	uint32_t levels = 1;
+	while ((faceSize >> levels) > 0)
+		levels++;
+	TextureFileData cubemap = makeCubemap(ImageFormat::RGB32F, faceSize, levels);
+
+	ThreadPool pool;
+	pool.ParallelFor(6 * faceSize, [&](uint32_t row) {
+		uint32_t face = row / faceSize, y = row % faceSize;
+		glm::vec3* texels = (glm::vec3*)cubemap.images[face].data() + (size_t)y * faceSize;
+		for (uint32_t x = 0; x < faceSize; x++) {
+			glm::vec3 d = glm::normalize(faceDirection(face, (x + 0.5f) / faceSize * 2.0f - 1.0f, (y + 0.5f) / faceSize * 2.0f - 1.0f));
+
+			// Same mapping as the GPU conversion in TextureCubemap::Utils::FromTexture2D, wrapping around horizontally
+			float u = std::atan2(d.z, d.x) / (2.0f * PI) + 0.5f;
+			float v = 0.5f - std::asin(std::clamp(d.y, -1.0f, 1.0f)) / PI;
+			float sx = u * width - 0.5f, sy = std::clamp(v * height - 0.5f, 0.0f, (float)(height - 1));
+			int32_t x0 = (int32_t)std::floor(sx), y0 = (int32_t)sy;
+			float fx = sx - x0, fy = sy - y0;
+			uint32_t x1 = (uint32_t)(x0 + 1) % width, y1 = std::min((uint32_t)y0 + 1, height - 1);
+			uint32_t wx0 = (uint32_t)(x0 + (int32_t)width) % width;
+
+			glm::vec3 top = glm::mix(source[y0 * width + wx0], source[y0 * width + x1], fx);
+			glm::vec3 bottom = glm::mix(source[y1 * width + wx0], source[y1 * width + x1], fx);
+			texels[x] = glm::mix(top, bottom, fy);
+		}
+	});
+
+	for (uint32_t level = 1; level < levels; level++) {
+		uint32_t size = std::max(faceSize >> level, 1u), parentSize = std::max(faceSize >> (level - 1), 1u);
+		for (uint32_t face = 0; face < 6; face++) {
+			const glm::vec3* parent = (const glm::vec3*)cubemap.images[(level - 1) * 6 + face].data();
+			glm::vec3* texels = (glm::vec3*)cubemap.images[level * 6 + face].data();
+			for (uint32_t y = 0; y < size; y++) {
+				for (uint32_t x = 0; x < size; x++) {
+					uint32_t px = std::min(2 * x + 1, parentSize - 1), py = std::min(2 * y + 1, parentSize - 1);
+					texels[y * size + x] = (parent[2 * y * parentSize + 2 * x] + parent[2 * y * parentSize + px] +
+						parent[py * parentSize + 2 * x] + parent[py * parentSize + px]) * 0.25f;
+				}
+			}
+		}
+	}
+
+	return cubemap;
+}
+
+SphericalHarmonics9 IBLBaker::ProjectSH(const TextureFileData& environment) {
+	uint32_t size = environment.width;
+
+	// One partial sum per face, added up afterwards so no thread shares an accumulator
+	glm::vec3 faceSums[6][9] = {};
+	float faceWeights[6] = {};
+
+	ThreadPool pool;
+	pool.ParallelFor(6, [&](uint32_t face) {
+		const glm::vec3* texels = (const glm::vec3*)environment.images[face].data();
+		float basis[9];
+		for (uint32_t y = 0; y < size; y++) {
+			float t = (y + 0.5f) / size * 2.0f - 1.0f;
+			for (uint32_t x = 0; x < size; x++) {
+				float s = (x + 0.5f) / size * 2.0f - 1.0f;
+				// Solid angle of the texel, texels towards the corners of a face cover less of the sphere
+				float lengthSquared = 1.0f + s * s + t * t;
+				float weight = 4.0f / (size * size * lengthSquared * std::sqrt(lengthSquared));
+
+				glm::vec3 d = faceDirection(face, s, t) / std::sqrt(lengthSquared);
+				shBasis(d, basis);
+				glm::vec3 radiance = texels[y * size + x] * weight;
+				for (uint32_t i = 0; i < 9; i++)
+					faceSums[face][i] += radiance * basis[i];
+				faceWeights[face] += weight;
+			}
+		}
+	});
+
+	SphericalHarmonics9 sh;
+	float totalWeight = 0.0f;
+	for (uint32_t face = 0; face < 6; face++) {
+		totalWeight += faceWeights[face];
+		for (uint32_t i = 0; i < 9; i++)
+			sh.coefficients[i] += faceSums[face][i];
+	}
+
+	// The texel solid angles are approximate, make them cover exactly the whole sphere
+	for (auto& coefficient : sh.coefficients)
+		coefficient *= 4.0f * PI / totalWeight;
+	return sh;
+}
+
+TextureFileData IBLBaker::PrefilterSpecular(const TextureFileData& environment, uint32_t size, uint32_t levels, uint32_t samples) {
+	uint32_t fullLevels = 1;
+	while ((size >> fullLevels) > 0)
+		fullLevels++;
+	levels = std::clamp(levels, 1u, fullLevels);
+
+	CubemapSampler source(environment);
+	float texelSolidAngle = 4.0f * PI / (6.0f * environment.width * environment.width);
+	TextureFileData cubemap = makeCubemap(ImageFormat::RGB16F, size, levels);
+
+	struct Sample {
+		glm::vec3 direction; // Around +z
+		float weight;
+		float level;         // Source level whose texels cover about as much as the sample, so few samples stay smooth
+	};
+
+	ThreadPool pool;
+	for (uint32_t level = 0; level < levels; level++) {
+		uint32_t levelSize = std::max(size >> level, 1u);
+		float roughness = levels > 1 ? (float)level / (float)(levels - 1) : 0.0f;
+
+		// Filtered importance sampling with view = normal, the same for every texel so built once per level
+		std::vector<Sample> lobe;
+		float totalWeight = 0.0f;
+		if (level == 0) {
+			lobe.push_back({ { 0.0f, 0.0f, 1.0f }, 1.0f, std::log2((float)environment.width / levelSize) });
+			totalWeight = 1.0f;
+		}
+		else {
+			for (uint32_t i = 0; i < samples; i++) {
+				glm::vec3 H = importanceSampleGGX(hammersley(i, samples), roughness);
+				glm::vec3 L = 2.0f * H.z * H - glm::vec3(0.0f, 0.0f, 1.0f);
+				if (L.z <= 0.0f)
+					continue;
+
+				float pdf = distributionGGX(H.z, roughness) / 4.0f + 0.0001f;
+				float sampleSolidAngle = 1.0f / (samples * pdf);
+				lobe.push_back({ L, L.z, std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle), 0.0f) });
+				totalWeight += L.z;
+			}
+		}
+
+		pool.ParallelFor(6 * levelSize, [&](uint32_t row) {
+			uint32_t face = row / levelSize, y = row % levelSize;
+			glm::vec3* texels = (glm::vec3*)cubemap.images[level * 6 + face].data() + (size_t)y * levelSize;
+			for (uint32_t x = 0; x < levelSize; x++) {
+				glm::vec3 N = glm::normalize(faceDirection(face, (x + 0.5f) / levelSize * 2.0f - 1.0f, (y + 0.5f) / levelSize * 2.0f - 1.0f));
+				glm::vec3 up = std::abs(N.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+				glm::vec3 tangent = glm::normalize(glm::cross(up, N));
+				glm::vec3 bitangent = glm::cross(N, tangent);
+
+				glm::vec3 color(0.0f);
+				for (const auto& sample : lobe) {
+					glm::vec3 L = tangent * sample.direction.x + bitangent * sample.direction.y + N * sample.direction.z;
+					color += source.Sample(L, sample.level) * sample.weight;
+				}
+				texels[x] = color / totalWeight;
+			}
+		});
+	}
+
+	return cubemap;
+}
+
+TextureFileData IBLBaker::RenderIrradiance(const SphericalHarmonics9& sh, uint32_t size) {
+	TextureFileData cubemap = makeCubemap(ImageFormat::RGB16F, size, 1);
+	for (uint32_t face = 0; face < 6; face++) {
+		glm::vec3* texels = (glm::vec3*)cubemap.images[face].data();
+		for (uint32_t y = 0; y < size; y++)
+			for (uint32_t x = 0; x < size; x++)
+				texels[y * size + x] = sh.EvaluateIrradiance(glm::normalize(faceDirection(face, (x + 0.5f) / size * 2.0f - 1.0f, (y + 0.5f) / size * 2.0f - 1.0f)));
+	}
+	return cubemap;
+}
+
+TextureFileData IBLBaker::IntegrateBRDF(uint32_t size, uint32_t samples) {
+	TextureFileData lookup;
+	lookup.format = ImageFormat::RG16F;
+	lookup.width = lookup.height = size;
+	lookup.images.emplace_back((size_t)size * size * sizeof(glm::vec2));
+	glm::vec2* texels = (glm::vec2*)lookup.images[0].data();
+
+	ThreadPool pool;
+	pool.ParallelFor(size, [&](uint32_t y) {
+		float roughness = (y + 0.5f) / size;
+		for (uint32_t x = 0; x < size; x++) {
+			float NdotV = (x + 0.5f) / size;
+			glm::vec3 V(std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+
+			float scale = 0.0f, bias = 0.0f;
+			for (uint32_t i = 0; i < samples; i++) {
+				glm::vec3 H = importanceSampleGGX(hammersley(i, samples), roughness);
+				float VdotH = glm::dot(V, H);
+				glm::vec3 L = 2.0f * VdotH * H - V;
+				if (L.z <= 0.0f)
+					continue;
+
+				float G = geometrySchlickGGX(NdotV, roughness) * geometrySchlickGGX(L.z, roughness);
+				float visibility = G * std::max(VdotH, 0.0f) / (H.z * NdotV);
+				float fresnel = std::pow(1.0f - std::max(VdotH, 0.0f), 5.0f);
+				scale += (1.0f - fresnel) * visibility;
+				bias += fresnel * visibility;
+			}
+			texels[y * size + x] = glm::vec2(scale, bias) / (float)samples;
+		}
+	});
+
+	return lookup;
+}
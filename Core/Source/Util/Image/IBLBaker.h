@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "TextureFile.h"
+
+namespace Engine {
+	// Radiance projected onto the first three bands of the real spherical harmonics
+	struct SphericalHarmonics9 {
+		glm::vec3 coefficients[9] = {};
+
+		// Cosine convolved irradiance around the normal divided by pi, ie. what a white Lambertian surface reflects
+		glm::vec3 EvaluateIrradiance(const glm::vec3& normal) const;
+	};
+
+	struct IBLSettings {
+		uint32_t sourceSize = 256;      // Face size the environment is resampled to before it is filtered
+		uint32_t irradianceSize = 32;
+		uint32_t specularSize = 128;
+		uint32_t specularLevels = 6;    // Roughness goes from 0 at the base level to 1 at the last
+		uint32_t specularSamples = 128;
+		uint32_t brdfSize = 128;
+		uint32_t brdfSamples = 256;
+	};
+
+	// Prefilters environments for image based lighting on the CPU, spread over every hardware thread.
+	// Cubemaps use the GL face order and orientation and hold floats, 16F formats are converted to
+	// half floats when they are written to a container.
+	class IBLBaker {
+	public:
+		// Part of every baked cache key, bump whenever a bake's output changes so old entries are rebuilt
+		static const uint32_t VERSION = 1;
+
+		// Resamples an equirectangular float image with 3 or 4 channels, top row first, into an RGB32F cubemap
+		// with its full box filtered mip chain
+		static TextureFileData CubemapFromEquirectangular(const float* pixels, uint32_t width, uint32_t height, uint32_t channels, uint32_t faceSize);
+		// Cubemaps as returned by CubemapFromEquirectangular
+		static SphericalHarmonics9 ProjectSH(const TextureFileData& environment);
+		static TextureFileData PrefilterSpecular(const TextureFileData& environment, uint32_t size, uint32_t levels, uint32_t samples);
+
+		// RGB16F cubemap evaluated from the harmonics, smooth enough that a few texels per face are plenty
+		static TextureFileData RenderIrradiance(const SphericalHarmonics9& sh, uint32_t size);
+		// RG16F scale and bias to F0 of the split sum approximation, by NdotV along x and roughness along y
+		static TextureFileData IntegrateBRDF(uint32_t size, uint32_t samples);
+	};
+}
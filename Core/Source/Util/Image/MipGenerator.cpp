@@ -0,0 +1,199 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Logging/Logging.h"
+
+using namespace Engine;
+
+namespace {
+	// Source pixels contributing to one destination pixel along an axis, first may lie outside the image
+	struct Taps {
+		int32_t first;
+		std::vector<float> weights;
+	};
+
+	float besselI0(float x) {
+		float sum = 1.0f, term = 1.0f;
+		float halfX = x * 0.5f;
+		for (int k = 1; k < 32 && term > sum * 1e-7f; k++) {
+			term *= (halfX / k) * (halfX / k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	float sinc(float x) {
+		if (std::abs(x) < 1e-6f)
+			return 1.0f;
+		x *= 3.14159265f;
+		return std::sin(x) / x;
+	}
+
+	float srgbToLinear(float value) {
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float linearToSrgb(float value) {
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	std::vector<Taps> computeTaps(uint32_t sourceSize, uint32_t size, const MipSettings& settings) {
+		std::vector<Taps> taps(size);
+		float scale = (float)sourceSize / size;
+
+		for (uint32_t i = 0; i < size; i++) {
+			Taps& pixel = taps[i];
+			if (settings.filter == MipFilter::Box) {
+				// Weight each source pixel by how much of it the destination pixel covers
+				float begin = i * scale, end = (i + 1) * scale;
+				pixel.first = (int32_t)std::floor(begin);
+				int32_t last = std::min((int32_t)std::ceil(end), (int32_t)sourceSize) - 1;
+				for (int32_t j = pixel.first; j <= last; j++)
+					pixel.weights.push_back(std::min(end, j + 1.0f) - std::max(begin, (float)j));
+			}
+			else {
+				float center = (i + 0.5f) * scale;
+				float radius = settings.kaiserRadius * scale;
+				float windowScale = 1.0f / besselI0(settings.kaiserAlpha);
+				pixel.first = (int32_t)std::floor(center - radius);
+				int32_t last = (int32_t)std::ceil(center + radius);
+				for (int32_t j = pixel.first; j <= last; j++) {
+					float x = (j + 0.5f - center) / scale;
+					float t = x / settings.kaiserRadius;
+					float window = std::abs(t) < 1.0f ? besselI0(settings.kaiserAlpha * std::sqrt(1.0f - t * t)) * windowScale : 0.0f;
+					pixel.weights.push_back(sinc(x) * window);
+				}
+			}
+
+			float total = 0.0f;
+			for (float weight : pixel.weights)
+				total += weight;
+			if (total != 0.0f)
+				for (float& weight : pixel.weights)
+					weight /= total;
+		}
+
+		return taps;
+	}
+
+	uint32_t address(int32_t index, uint32_t size, bool wrap) {
+		if (wrap)
+			return (uint32_t)(((index % (int32_t)size) + (int32_t)size) % (int32_t)size);
+		return (uint32_t)std::clamp(index, 0, (int32_t)size - 1);
+	}
+
+	// Separable resample, rows first then columns
+	std::vector<float> resample(const std::vector<float>& source, uint32_t sourceWidth, uint32_t sourceHeight,
+		uint32_t width, uint32_t height, uint32_t channels, const MipSettings& settings) {
+		std::vector<Taps> columnTaps = computeTaps(sourceWidth, width, settings);
+		std::vector<Taps> rowTaps = computeTaps(sourceHeight, height, settings);
+
+		std::vector<float> horizontal((size_t)width * sourceHeight * channels, 0.0f);
+		for (uint32_t y = 0; y < sourceHeight; y++) {
+			const float* sourceRow = &source[(size_t)y * sourceWidth * channels];
+			float* row = &horizontal[(size_t)y * width * channels];
+			for (uint32_t x = 0; x < width; x++) {
+				const Taps& taps = columnTaps[x];
+				for (uint32_t t = 0; t < taps.weights.size(); t++) {
+					const float* texel = sourceRow + (size_t)address(taps.first + (int32_t)t, sourceWidth, settings.wrap) * channels;
+					for (uint32_t c = 0; c < channels; c++)
+						row[x * channels + c] += texel[c] * taps.weights[t];
+				}
+			}
+		}
+
+		std::vector<float> result((size_t)width * height * channels, 0.0f);
+		size_t rowSize = (size_t)width * channels;
+		for (uint32_t y = 0; y < height; y++) {
+			const Taps& taps = rowTaps[y];
+			float* row = &result[y * rowSize];
+			for (uint32_t t = 0; t < taps.weights.size(); t++) {
+				const float* sourceRow = &horizontal[address(taps.first + (int32_t)t, sourceHeight, settings.wrap) * rowSize];
+				for (size_t i = 0; i < rowSize; i++)
+					row[i] += sourceRow[i] * taps.weights[t];
+			}
+		}
+
+		return result;
+	}
+}
+
+bool MipGenerator::IsFormatSupported(ImageFormat format) {
+	switch (format) {
+	case ImageFormat::R8:
+	case ImageFormat::RG8:
+	case ImageFormat::RGB8:
+	case ImageFormat::RGBA8:
+	case ImageFormat::R16F:
+	case ImageFormat::RG16F:
+	case ImageFormat::RGB16F:
+	case ImageFormat::RGBA16F:
+	case ImageFormat::R32F:
+	case ImageFormat::RG32F:
+	case ImageFormat::RGB32F:
+	case ImageFormat::RGBA32F:
+		return true;
+	default:
+		return false;
+	}
+}
+
+std::vector<MipLevel> MipGenerator::Generate(const void* data, uint32_t width, uint32_t height, ImageFormat format, const MipSettings& settings) {
+	std::vector<MipLevel> levels;
+	if (!data || width == 0 || height == 0)
+		return levels;
+
+	if (!IsFormatSupported(format)) {
+		ENGINE_WARN("[MipGenerator::Generate] Unsupported image format {}", (int)format);
+		return levels;
+	}
+
+	uint32_t channels = Utils::ImageFormatChannelCount(format);
+	bool bytes = Utils::ImageFormatDataSize(format) == channels;
+	// Alpha is coverage, never gamma encoded
+	uint32_t colorChannels = channels == 4 ? 3 : channels;
+	bool srgb = settings.srgb && bytes;
+
+	size_t count = (size_t)width * height * channels;
+	std::vector<float> current(count);
+	if (bytes) {
+		const uint8_t* source = (const uint8_t*)data;
+		for (size_t i = 0; i < count; i++) {
+			float value = source[i] / 255.0f;
+			current[i] = srgb && i % channels < colorChannels ? srgbToLinear(value) : value;
+		}
+	}
+	else {
+		std::memcpy(current.data(), data, count * sizeof(float));
+	}
+
+	while (width > 1 || height > 1) {
+		uint32_t nextWidth = std::max(width / 2, 1u);
+		uint32_t nextHeight = std::max(height / 2, 1u);
+		current = resample(current, width, height, nextWidth, nextHeight, channels, settings);
+		width = nextWidth;
+		height = nextHeight;
+
+		MipLevel& level = levels.emplace_back();
+		level.width = width;
+		level.height = height;
+		if (bytes) {
+			level.data.resize(current.size());
+			for (size_t i = 0; i < current.size(); i++) {
+				float value = std::clamp(current[i], 0.0f, 1.0f);
+				if (srgb && i % channels < colorChannels)
+					value = linearToSrgb(value);
+				level.data[i] = (uint8_t)(value * 255.0f + 0.5f);
+			}
+		}
+		else {
+			level.data.resize(current.size() * sizeof(float));
+			std::memcpy(level.data.data(), current.data(), level.data.size());
+		}
+	}
+
+	return levels;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Rendering/Platform/ImageFormat.h"
+
+namespace Engine {
+	enum class MipFilter {
+		Box,    // Area average, cheap and slightly blurry
+		Kaiser  // Kaiser windowed sinc, keeps more detail at the cost of a little ringing
+	};
+
+	struct MipLevel {
+		uint32_t width, height;
+		std::vector<uint8_t> data; // Tightly packed, same layout as the base level
+	};
+
+	struct MipSettings {
+		MipFilter filter = MipFilter::Box;
+		bool srgb = false;          // Filter 8 bit colour in linear space, alpha is always linear
+		bool wrap = false;          // Sample across the edges as a repeating texture would, otherwise clamp
+		float kaiserAlpha = 4.0f;   // Window shape, higher is smoother with less ringing
+		float kaiserRadius = 3.0f;  // Filter half width, in destination pixels
+	};
+
+	// Downsamples a base level into the rest of its mip chain on the CPU, for assets baked offline where
+	// the quality of the filter matters more than the time it takes. Each level is filtered from the
+	// one above it at full float precision, so 8 bit formats are only quantised once per level.
+	class MipGenerator {
+	public:
+		// Returns the levels below the base, none if the format is not 8 bit unsigned or floating point
+		static std::vector<MipLevel> Generate(const void* data, uint32_t width, uint32_t height, ImageFormat format, const MipSettings& settings = {});
+		static bool IsFormatSupported(ImageFormat format);
+	};
+}
@@ -0,0 +1,59 @@
+#include "TextureCache.h"
+
+#include <filesystem>
+
+#include "Logging/Logging.h"
+#include "Util/CacheKey.h"
+
+using namespace Engine;
+
+namespace {
+	// Bump whenever the encoders or the conversions change so old entries are rebuilt
+	const uint32_t CACHE_VERSION = 2;
+}
+
+std::string TextureCache::_directory = ".cache/textures";
+
+std::string TextureCache::MakeKey(const std::string& sourcePath, const std::string& settings) {
+	return CacheKey::Make(sourcePath, settings, CACHE_VERSION);
+}
+
+std::shared_ptr<TextureFile> TextureCache::Load(const std::string& key) {
+	if (key.empty() || !std::filesystem::exists(getPath(key)))
+		return nullptr;
+
+	auto file = TextureFile::Open(getPath(key));
+	if (!file)
+		ENGINE_WARN("[TextureCache::Load] Ignoring invalid cache entry {}", key);
+	return file;
+}
+
+bool TextureCache::Store(const std::string& key, const TextureFileData& data) {
+	if (key.empty())
+		return false;
+	if (!TextureFile::WriteKTX2(getPath(key), data))
+		return false;
+
+	// An entry that cannot be read back would be rebuilt on every run, so check it once here
+	if (!TextureFile::Open(getPath(key))) {
+		ENGINE_ERROR("[TextureCache::Store] Entry {} does not load back, removing it", key);
+		std::error_code error;
+		std::filesystem::remove(getPath(key), error);
+		return false;
+	}
+	return true;
+}
+
+bool TextureCache::Store(const std::string& key, const CompressedImage& image) {
+	TextureFileData data;
+	data.format = image.format;
+	data.width = image.width;
+	data.height = image.height;
+	data.levelCount = (uint32_t)image.levels.size();
+	data.images = image.levels;
+	return Store(key, data);
+}
+
+std::string TextureCache::getPath(const std::string& key) {
+	return (std::filesystem::path(_directory) / (key + ".ktx2")).string();
+}
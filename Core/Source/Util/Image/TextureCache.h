@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include <string>
+
+#include "TextureCompressor.h"
+#include "TextureFile.h"
+
+namespace Engine {
+	// Processed textures kept on disk as KTX2 between runs, so each source image is only decoded, converted
+	// and encoded once. Entries are keyed on the source file's path, size and modification time along with
+	// the settings used to build them, editing the source or changing the settings simply misses and
+	// builds a new entry.
+	class TextureCache {
+	public:
+		static void SetDirectory(const std::string& directory) { _directory = directory; }
+		static const std::string& GetDirectory() { return _directory; }
+
+		// Empty if the source file does not exist
+		static std::string MakeKey(const std::string& sourcePath, const std::string& settings);
+
+		// Mapped rather than read, nullptr on a miss
+		static std::shared_ptr<TextureFile> Load(const std::string& key);
+		static bool Store(const std::string& key, const TextureFileData& data);
+		static bool Store(const std::string& key, const CompressedImage& image);
+	private:
+		static std::string getPath(const std::string& key);
+	private:
+		static std::string _directory;
+	};
+}
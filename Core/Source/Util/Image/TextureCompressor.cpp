@@ -0,0 +1,489 @@
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "Logging/Logging.h"
+
+using namespace Engine;
+
+namespace {
+	// 4x4 texels as RGBA in the 0-255 range
+	struct Block {
+		float texels[16][4];
+	};
+
+	const uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	void fetchBlock(const uint8_t* data, uint32_t width, uint32_t height, uint32_t channels, uint32_t blockX, uint32_t blockY, Block& block) {
+		for (uint32_t y = 0; y < 4; y++) {
+			for (uint32_t x = 0; x < 4; x++) {
+				uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+				uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+				const uint8_t* texel = data + ((size_t)sourceY * width + sourceX) * channels;
+				float* out = block.texels[y * 4 + x];
+				out[0] = texel[0];
+				out[1] = channels > 1 ? texel[1] : 0.0f;
+				out[2] = channels > 2 ? texel[2] : 0.0f;
+				out[3] = channels > 3 ? texel[3] : 255.0f;
+			}
+		}
+	}
+
+	float distanceSquared(const float* a, const float* b, uint32_t dimensions) {
+		float sum = 0.0f;
+		for (uint32_t c = 0; c < dimensions; c++)
+			sum += (a[c] - b[c]) * (a[c] - b[c]);
+		return sum;
+	}
+
+	// Endpoints at the extremes of the block projected onto its principal axis, over the first dimensions channels
+	void fitEndpoints(const Block& block, uint32_t dimensions, float start[4], float end[4]) {
+		float mean[4] = {}, minimum[4], maximum[4];
+		for (uint32_t c = 0; c < 4; c++) {
+			minimum[c] = 255.0f;
+			maximum[c] = 0.0f;
+		}
+		for (const auto& texel : block.texels) {
+			for (uint32_t c = 0; c < dimensions; c++) {
+				mean[c] += texel[c] / 16.0f;
+				minimum[c] = std::min(minimum[c], texel[c]);
+				maximum[c] = std::max(maximum[c], texel[c]);
+			}
+		}
+
+		float covariance[4][4] = {};
+		for (const auto& texel : block.texels)
+			for (uint32_t i = 0; i < dimensions; i++)
+				for (uint32_t j = 0; j < dimensions; j++)
+					covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+
+		// Power iteration from the bounding box diagonal
+		float axis[4] = {};
+		float length = 0.0f;
+		for (uint32_t c = 0; c < dimensions; c++) {
+			axis[c] = maximum[c] - minimum[c];
+			length += axis[c] * axis[c];
+		}
+
+		if (length == 0.0f) {
+			for (uint32_t c = 0; c < 4; c++)
+				start[c] = end[c] = c < dimensions ? mean[c] : 255.0f;
+			return;
+		}
+
+		for (int iteration = 0; iteration < 8; iteration++) {
+			float next[4] = {};
+			float nextLength = 0.0f;
+			for (uint32_t i = 0; i < dimensions; i++) {
+				for (uint32_t j = 0; j < dimensions; j++)
+					next[i] += covariance[i][j] * axis[j];
+				nextLength += next[i] * next[i];
+			}
+			if (nextLength < 1e-12f)
+				break;
+
+			nextLength = 1.0f / std::sqrt(nextLength);
+			for (uint32_t c = 0; c < dimensions; c++)
+				axis[c] = next[c] * nextLength;
+		}
+
+		float axisLength = 0.0f;
+		for (uint32_t c = 0; c < dimensions; c++)
+			axisLength += axis[c] * axis[c];
+		axisLength = 1.0f / std::sqrt(axisLength);
+
+		float lowest = FLT_MAX, highest = -FLT_MAX;
+		for (const auto& texel : block.texels) {
+			float t = 0.0f;
+			for (uint32_t c = 0; c < dimensions; c++)
+				t += (texel[c] - mean[c]) * axis[c] * axisLength;
+			lowest = std::min(lowest, t);
+			highest = std::max(highest, t);
+		}
+
+		for (uint32_t c = 0; c < 4; c++) {
+			start[c] = c < dimensions ? std::clamp(mean[c] + axis[c] * axisLength * lowest, 0.0f, 255.0f) : 255.0f;
+			end[c] = c < dimensions ? std::clamp(mean[c] + axis[c] * axisLength * highest, 0.0f, 255.0f) : 255.0f;
+		}
+	}
+
+	// Least squares endpoints for fixed interpolation weights (0 = start, 1 = end), false if the system is degenerate
+	bool refineEndpoints(const Block& block, uint32_t dimensions, const float weights[16], float start[4], float end[4]) {
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+		for (uint32_t i = 0; i < 16; i++) {
+			float b = weights[i], a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (uint32_t c = 0; c < dimensions; c++) {
+				ax[c] += a * block.texels[i][c];
+				bx[c] += b * block.texels[i][c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::abs(determinant) < 1e-6f)
+			return false;
+
+		determinant = 1.0f / determinant;
+		for (uint32_t c = 0; c < dimensions; c++) {
+			start[c] = std::clamp((ax[c] * bb - bx[c] * ab) * determinant, 0.0f, 255.0f);
+			end[c] = std::clamp((bx[c] * aa - ax[c] * ab) * determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+#pragma region BC1
+
+	uint16_t toRGB565(const float color[4]) {
+		uint32_t r = (uint32_t)(color[0] * 31.0f / 255.0f + 0.5f);
+		uint32_t g = (uint32_t)(color[1] * 63.0f / 255.0f + 0.5f);
+		uint32_t b = (uint32_t)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void fromRGB565(uint16_t value, float color[4]) {
+		uint32_t r = value >> 11, g = (value >> 5) & 63, b = value & 31;
+		color[0] = (float)((r << 3) | (r >> 2));
+		color[1] = (float)((g << 2) | (g >> 4));
+		color[2] = (float)((b << 3) | (b >> 2));
+	}
+
+	struct BC1Result {
+		uint16_t color0, color1;
+		uint32_t indices;
+		float error;
+	};
+
+	// Always four colour mode (color0 > color1), which BC3 requires as well
+	BC1Result tryBC1(const Block& block, const float start[4], const float end[4]) {
+		BC1Result result = { toRGB565(start), toRGB565(end), 0, 0.0f };
+		if (result.color0 < result.color1)
+			std::swap(result.color0, result.color1);
+
+		float palette[4][4];
+		fromRGB565(result.color0, palette[0]);
+		fromRGB565(result.color1, palette[1]);
+
+		if (result.color0 == result.color1) {
+			for (const auto& texel : block.texels)
+				result.error += distanceSquared(texel, palette[0], 3);
+			return result;
+		}
+
+		for (uint32_t c = 0; c < 3; c++) {
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+
+		for (uint32_t i = 0; i < 16; i++) {
+			uint32_t best = 0;
+			float bestError = FLT_MAX;
+			for (uint32_t p = 0; p < 4; p++) {
+				float error = distanceSquared(block.texels[i], palette[p], 3);
+				if (error < bestError) {
+					bestError = error;
+					best = p;
+				}
+			}
+			result.indices |= best << (i * 2);
+			result.error += bestError;
+		}
+		return result;
+	}
+
+	void encodeBC1(const Block& block, uint8_t* output) {
+		float start[4], end[4];
+		fitEndpoints(block, 3, start, end);
+		BC1Result result = tryBC1(block, start, end);
+
+		if (result.color0 != result.color1) {
+			const float indexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			float weights[16];
+			for (uint32_t i = 0; i < 16; i++)
+				weights[i] = indexWeights[(result.indices >> (i * 2)) & 3];
+
+			float color0[4], color1[4];
+			fromRGB565(result.color0, color0);
+			fromRGB565(result.color1, color1);
+			if (refineEndpoints(block, 3, weights, color0, color1)) {
+				BC1Result refined = tryBC1(block, color0, color1);
+				if (refined.error < result.error)
+					result = refined;
+			}
+		}
+
+		std::memcpy(output, &result.color0, 2);
+		std::memcpy(output + 2, &result.color1, 2);
+		std::memcpy(output + 4, &result.indices, 4);
+	}
+
+#pragma endregion
+
+#pragma region BC4
+
+	// One channel, eight interpolated values
+	void encodeBC4(const Block& block, uint32_t channel, uint8_t* output) {
+		float lowest = 255.0f, highest = 0.0f;
+		for (const auto& texel : block.texels) {
+			lowest = std::min(lowest, texel[channel]);
+			highest = std::max(highest, texel[channel]);
+		}
+
+		uint8_t value0 = (uint8_t)(highest + 0.5f);
+		uint8_t value1 = (uint8_t)(lowest + 0.5f);
+		output[0] = value0;
+		output[1] = value1;
+
+		uint64_t indices = 0;
+		if (value0 != value1) {
+			float palette[8] = { (float)value0, (float)value1 };
+			for (uint32_t i = 1; i < 7; i++)
+				palette[i + 1] = ((7 - i) * value0 + i * value1) / 7.0f;
+
+			for (uint32_t i = 0; i < 16; i++) {
+				uint64_t best = 0;
+				float bestError = FLT_MAX;
+				for (uint32_t p = 0; p < 8; p++) {
+					float error = std::abs(block.texels[i][channel] - palette[p]);
+					if (error < bestError) {
+						bestError = error;
+						best = p;
+					}
+				}
+				indices |= best << (i * 3);
+			}
+		}
+
+		for (uint32_t i = 0; i < 6; i++)
+			output[2 + i] = (uint8_t)(indices >> (i * 8));
+	}
+
+#pragma endregion
+
+#pragma region BC7
+
+	struct BC7Endpoint {
+		uint8_t values[4]; // 7 bits each
+		uint8_t pBit;
+	};
+
+	struct BC7Result {
+		BC7Endpoint endpoints[2];
+		uint8_t indices[16];
+		float error;
+	};
+
+	// The shared p-bit is the low bit of every channel, pick the one that lands closest
+	BC7Endpoint quantizeBC7(const float color[4]) {
+		BC7Endpoint best = {};
+		float bestError = FLT_MAX;
+		for (uint8_t pBit = 0; pBit < 2; pBit++) {
+			BC7Endpoint endpoint = {};
+			endpoint.pBit = pBit;
+			float error = 0.0f;
+			for (uint32_t c = 0; c < 4; c++) {
+				int value = std::clamp((int)std::lround((color[c] - pBit) / 2.0f), 0, 127);
+				endpoint.values[c] = (uint8_t)value;
+				float reconstructed = (float)((value << 1) | pBit);
+				error += (reconstructed - color[c]) * (reconstructed - color[c]);
+			}
+			if (error < bestError) {
+				bestError = error;
+				best = endpoint;
+			}
+		}
+		return best;
+	}
+
+	BC7Result tryBC7(const Block& block, const float start[4], const float end[4]) {
+		BC7Result result = {};
+		result.endpoints[0] = quantizeBC7(start);
+		result.endpoints[1] = quantizeBC7(end);
+
+		uint32_t color0[4], color1[4];
+		for (uint32_t c = 0; c < 4; c++) {
+			color0[c] = (result.endpoints[0].values[c] << 1) | result.endpoints[0].pBit;
+			color1[c] = (result.endpoints[1].values[c] << 1) | result.endpoints[1].pBit;
+		}
+
+		float palette[16][4];
+		for (uint32_t p = 0; p < 16; p++)
+			for (uint32_t c = 0; c < 4; c++)
+				palette[p][c] = (float)(((64 - BC7_WEIGHTS[p]) * color0[c] + BC7_WEIGHTS[p] * color1[c] + 32) >> 6);
+
+		for (uint32_t i = 0; i < 16; i++) {
+			uint8_t best = 0;
+			float bestError = FLT_MAX;
+			for (uint8_t p = 0; p < 16; p++) {
+				float error = distanceSquared(block.texels[i], palette[p], 4);
+				if (error < bestError) {
+					bestError = error;
+					best = p;
+				}
+			}
+			result.indices[i] = best;
+			result.error += bestError;
+		}
+		return result;
+	}
+
+	struct BitWriter {
+		uint8_t* output;
+		uint32_t position = 0;
+
+		void Write(uint32_t value, uint32_t bits) {
+			for (uint32_t i = 0; i < bits; i++, position++)
+				if ((value >> i) & 1)
+					output[position >> 3] |= (uint8_t)(1 << (position & 7));
+		}
+	};
+
+	void encodeBC7(const Block& block, uint8_t* output) {
+		float start[4], end[4];
+		fitEndpoints(block, 4, start, end);
+		BC7Result result = tryBC7(block, start, end);
+
+		float weights[16];
+		for (uint32_t i = 0; i < 16; i++)
+			weights[i] = BC7_WEIGHTS[result.indices[i]] / 64.0f;
+		if (refineEndpoints(block, 4, weights, start, end)) {
+			BC7Result refined = tryBC7(block, start, end);
+			if (refined.error < result.error)
+				result = refined;
+		}
+
+		// The first index is stored without its top bit, swap the endpoints so that bit is zero
+		if (result.indices[0] & 8) {
+			std::swap(result.endpoints[0], result.endpoints[1]);
+			for (auto& index : result.indices)
+				index = 15 - index;
+		}
+
+		std::memset(output, 0, 16);
+		BitWriter writer{ output };
+		writer.Write(1 << 6, 7); // Mode 6
+		for (uint32_t c = 0; c < 4; c++) {
+			writer.Write(result.endpoints[0].values[c], 7);
+			writer.Write(result.endpoints[1].values[c], 7);
+		}
+		writer.Write(result.endpoints[0].pBit, 1);
+		writer.Write(result.endpoints[1].pBit, 1);
+		writer.Write(result.indices[0], 3);
+		for (uint32_t i = 1; i < 16; i++)
+			writer.Write(result.indices[i], 4);
+	}
+
+#pragma endregion
+}
+
+ImageFormat TextureCompressor::ChooseFormat(TextureCompression compression, const void* data, uint32_t width, uint32_t height, ImageFormat source) {
+	if (compression == TextureCompression::None || !data || !CanEncode(source, ImageFormat::BC1))
+		return ImageFormat::None;
+
+	if (compression == TextureCompression::Normal)
+		return ImageFormat::BC5;
+
+	bool hasAlpha = false;
+	if (source == ImageFormat::RGBA8) {
+		const uint8_t* texels = (const uint8_t*)data;
+		for (size_t i = 3; i < (size_t)width * height * 4 && !hasAlpha; i += 4)
+			hasAlpha = texels[i] != 255;
+	}
+
+	if (hasAlpha) {
+		if (Utils::ImageFormatIsSupported(ImageFormat::BC7))
+			return ImageFormat::BC7;
+		return Utils::ImageFormatIsSupported(ImageFormat::BC3) ? ImageFormat::BC3 : ImageFormat::None;
+	}
+
+	if (Utils::ImageFormatIsSupported(ImageFormat::BC1))
+		return ImageFormat::BC1;
+	return Utils::ImageFormatIsSupported(ImageFormat::BC7) ? ImageFormat::BC7 : ImageFormat::None;
+}
+
+bool TextureCompressor::CanEncode(ImageFormat source, ImageFormat target) {
+	switch (source) {
+	case ImageFormat::R8:
+	case ImageFormat::RG8:
+	case ImageFormat::RGB8:
+	case ImageFormat::RGBA8:
+		break;
+	default:
+		return false;
+	}
+
+	switch (target) {
+	case ImageFormat::BC1:
+	case ImageFormat::BC3:
+	case ImageFormat::BC5:
+	case ImageFormat::BC7:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool TextureCompressor::CompressLevel(const void* data, uint32_t width, uint32_t height, ImageFormat source, ImageFormat target, std::vector<uint8_t>& output) {
+	if (!CanEncode(source, target)) {
+		ENGINE_ERROR("[TextureCompressor::CompressLevel] Cannot encode format {} to {}", (int)source, (int)target);
+		return false;
+	}
+
+	uint32_t channels = Utils::ImageFormatChannelCount(source);
+	uint32_t blockSize = Utils::ImageFormatBlockSize(target);
+	uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	output.resize((size_t)blocksX * blocksY * blockSize);
+
+	Block block;
+	uint8_t* out = output.data();
+	for (uint32_t y = 0; y < blocksY; y++) {
+		for (uint32_t x = 0; x < blocksX; x++, out += blockSize) {
+			fetchBlock((const uint8_t*)data, width, height, channels, x, y, block);
+			switch (target) {
+			case ImageFormat::BC1:
+				encodeBC1(block, out);
+				break;
+			case ImageFormat::BC3:
+				encodeBC4(block, 3, out);
+				encodeBC1(block, out + 8);
+				break;
+			case ImageFormat::BC5:
+				encodeBC4(block, 0, out);
+				encodeBC4(block, 1, out + 8);
+				break;
+			case ImageFormat::BC7:
+				encodeBC7(block, out);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+bool TextureCompressor::Compress(const void* data, uint32_t width, uint32_t height, ImageFormat source, ImageFormat target,
+	bool mips, CompressedImage& image, const MipSettings& mipSettings) {
+	image = CompressedImage();
+	image.format = target;
+	image.width = width;
+	image.height = height;
+	image.levels.emplace_back();
+	if (!CompressLevel(data, width, height, source, target, image.levels.back()))
+		return false;
+
+	if (!mips)
+		return true;
+
+	for (const auto& level : MipGenerator::Generate(data, width, height, source, mipSettings)) {
+		image.levels.emplace_back();
+		if (!CompressLevel(level.data.data(), level.width, level.height, source, target, image.levels.back()))
+			return false;
+	}
+	return true;
+}
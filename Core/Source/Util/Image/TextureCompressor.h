@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Rendering/Platform/ImageFormat.h"
+#include "MipGenerator.h"
+
+namespace Engine {
+	// What a texture holds, which decides the block format it is compressed to
+	enum class TextureCompression {
+		None,
+		Color,  // BC1 when opaque, BC7 (BC3 without BPTC support) when alpha is used
+		Normal  // BC5, the shader rebuilds Z from X and Y
+	};
+
+	struct CompressedImage {
+		ImageFormat format = ImageFormat::None;
+		uint32_t width = 0, height = 0;
+		std::vector<std::vector<uint8_t>> levels; // Base level first
+	};
+
+	// Offline block compression of 8 bit images. Endpoints are fitted along the principal axis of each
+	// block and refined once by least squares, BC7 only uses mode 6 (one subset, RGBA endpoints with
+	// 16 levels) which is the best single mode for natural images.
+	class TextureCompressor {
+	public:
+		// ImageFormat::None if the source cannot be compressed or the driver cannot sample the result
+		static ImageFormat ChooseFormat(TextureCompression compression, const void* data, uint32_t width, uint32_t height, ImageFormat source);
+		static bool CanEncode(ImageFormat source, ImageFormat target);
+
+		// Encodes one level, partial blocks at the edges repeat the last row and column
+		static bool CompressLevel(const void* data, uint32_t width, uint32_t height, ImageFormat source, ImageFormat target, std::vector<uint8_t>& output);
+		// Encodes the base level and, when mips is set, a chain downsampled with the mip settings
+		static bool Compress(const void* data, uint32_t width, uint32_t height, ImageFormat source, ImageFormat target,
+			bool mips, CompressedImage& image, const MipSettings& mipSettings = {});
+	};
+}
@@ -0,0 +1,514 @@
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "Logging/Logging.h"
+#include "Util/FileIO.h"
+
+using namespace Engine;
+
+namespace {
+	struct FormatInfo {
+		ImageFormat format;
+		bool halfFloat;
+		uint32_t vkFormat;
+		uint32_t dxgiFormat; // 0 where DXGI has no equivalent
+	};
+
+	const FormatInfo FORMATS[] = {
+		{ ImageFormat::R8,      false, 9,   61 },
+		{ ImageFormat::RG8,     false, 16,  49 },
+		{ ImageFormat::RGB8,    false, 23,  0 },
+		{ ImageFormat::RGBA8,   false, 37,  28 },
+		{ ImageFormat::R16F,    true,  76,  54 },
+		{ ImageFormat::RG16F,   true,  83,  34 },
+		{ ImageFormat::RGB16F,  true,  90,  0 },
+		{ ImageFormat::RGBA16F, true,  97,  10 },
+		{ ImageFormat::R32F,    false, 100, 41 },
+		{ ImageFormat::RG32F,   false, 103, 16 },
+		{ ImageFormat::RGB32F,  false, 106, 6 },
+		{ ImageFormat::RGBA32F, false, 109, 2 },
+		{ ImageFormat::BC1,     false, 131, 71 },
+		{ ImageFormat::BC3,     false, 137, 77 },
+		{ ImageFormat::BC5,     false, 141, 83 },
+		{ ImageFormat::BC7,     false, 145, 98 },
+	};
+
+	// sRGB and alpha variants with no format of their own, loaded as their linear counterpart
+	const std::pair<uint32_t, uint32_t> VK_ALIASES[] = { { 43, 37 }, { 132, 131 }, { 133, 131 }, { 138, 137 }, { 146, 145 } };
+	const std::pair<uint32_t, uint32_t> DXGI_ALIASES[] = { { 29, 28 }, { 72, 71 }, { 78, 77 }, { 99, 98 } };
+
+	const FormatInfo* findFormat(ImageFormat format) {
+		for (const auto& info : FORMATS)
+			if (info.format == format)
+				return &info;
+		return nullptr;
+	}
+
+	const FormatInfo* findVkFormat(uint32_t vkFormat) {
+		for (const auto& alias : VK_ALIASES)
+			if (alias.first == vkFormat)
+				vkFormat = alias.second;
+		for (const auto& info : FORMATS)
+			if (info.vkFormat == vkFormat)
+				return &info;
+		return nullptr;
+	}
+
+	const FormatInfo* findDxgiFormat(uint32_t dxgiFormat) {
+		for (const auto& alias : DXGI_ALIASES)
+			if (alias.first == dxgiFormat)
+				dxgiFormat = alias.second;
+		for (const auto& info : FORMATS)
+			if (info.dxgiFormat != 0 && info.dxgiFormat == dxgiFormat)
+				return &info;
+		return nullptr;
+	}
+
+	uint64_t imageSize(ImageFormat format, bool halfFloat, uint32_t width, uint32_t height) {
+		if (halfFloat)
+			return (uint64_t)width * height * Utils::ImageFormatChannelCount(format) * 2;
+		return Utils::ImageFormatLevelSize(format, width, height);
+	}
+
+	// Bytes per pixel, or per block for compressed formats
+	uint32_t texelBlockSize(ImageFormat format, bool halfFloat) {
+		if (Utils::ImageFormatIsCompressed(format))
+			return Utils::ImageFormatBlockSize(format);
+		return halfFloat ? Utils::ImageFormatChannelCount(format) * 2 : Utils::ImageFormatDataSize(format);
+	}
+
+	uint16_t floatToHalf(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, 4);
+		uint32_t sign = (bits >> 16) & 0x8000;
+		int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+		uint32_t mantissa = bits & 0x7FFFFF;
+
+		if (((bits >> 23) & 0xFF) == 0xFF)
+			return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+		if (exponent >= 31)
+			return (uint16_t)(sign | 0x7C00);
+		if (exponent <= 0) {
+			if (exponent < -10)
+				return (uint16_t)sign;
+			mantissa |= 0x800000;
+			uint32_t shift = 14 - exponent;
+			return (uint16_t)(sign | ((mantissa + (1 << (shift - 1))) >> shift));
+		}
+		// Rounding may carry into the exponent, which is still correct
+		return (uint16_t)(sign | (((uint32_t)exponent << 10) + ((mantissa + 0x1000) >> 13)));
+	}
+
+#pragma region KTX2
+
+	const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	struct KTX2Header {
+		uint8_t identifier[12];
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth, pixelHeight, pixelDepth;
+		uint32_t layerCount, faceCount, levelCount;
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset, dfdByteLength;
+		uint32_t kvdByteOffset, kvdByteLength;
+		uint64_t sgdByteOffset, sgdByteLength;
+	};
+
+	struct KTX2Level {
+		uint64_t byteOffset, byteLength, uncompressedByteLength;
+	};
+
+	// Basic data format descriptor, the only one readers are required to understand
+	std::vector<uint32_t> buildDataFormatDescriptor(ImageFormat format, bool halfFloat) {
+		struct Sample {
+			uint32_t bitOffset, bitLength, channel, lower, upper;
+		};
+
+		const uint32_t CHANNEL_ALPHA = 15, QUALIFIER_FLOAT_SIGNED = 0xC0;
+		std::vector<Sample> samples;
+		uint32_t model = 1; // RGBSDA
+		uint32_t blockDimensions = 0;
+		uint32_t qualifiers = 0;
+
+		switch (format) {
+		case ImageFormat::BC1:
+			model = 128;
+			samples.push_back({ 0, 63, 0, 0, 0xFFFFFFFF });
+			break;
+		case ImageFormat::BC3:
+			model = 130;
+			samples.push_back({ 0, 63, CHANNEL_ALPHA, 0, 0xFFFFFFFF });
+			samples.push_back({ 64, 63, 0, 0, 0xFFFFFFFF });
+			break;
+		case ImageFormat::BC5:
+			model = 132;
+			samples.push_back({ 0, 63, 0, 0, 0xFFFFFFFF });
+			samples.push_back({ 64, 63, 1, 0, 0xFFFFFFFF });
+			break;
+		case ImageFormat::BC7:
+			model = 134;
+			samples.push_back({ 0, 127, 0, 0, 0xFFFFFFFF });
+			break;
+		default: {
+			uint32_t channels = Utils::ImageFormatChannelCount(format);
+			uint32_t bits = texelBlockSize(format, halfFloat) / channels * 8;
+			bool isFloat = bits > 8;
+			if (isFloat)
+				qualifiers = QUALIFIER_FLOAT_SIGNED;
+			for (uint32_t c = 0; c < channels; c++) {
+				uint32_t channel = c == 3 ? CHANNEL_ALPHA : c;
+				// Floats are normalised to -1..1, given as the bits of a 32 bit float
+				samples.push_back({ c * bits, bits - 1, channel, isFloat ? 0xBF800000 : 0, isFloat ? 0x3F800000 : (1u << bits) - 1 });
+			}
+			break;
+		}
+		}
+
+		if (Utils::ImageFormatIsCompressed(format))
+			blockDimensions = 3 | (3 << 8);
+
+		uint32_t blockSize = 24 + 16 * (uint32_t)samples.size();
+		std::vector<uint32_t> words = {
+			4 + blockSize,                      // Total size
+			0,                                  // Khronos vendor, basic descriptor
+			2 | (blockSize << 16),              // Version 1.3
+			model | (1 << 8) | (1 << 16),       // BT.709 primaries, linear transfer, straight alpha
+			blockDimensions,
+			texelBlockSize(format, halfFloat),  // Bytes in plane 0
+			0
+		};
+
+		for (const auto& sample : samples) {
+			words.push_back(sample.bitOffset | (sample.bitLength << 16) | ((sample.channel | qualifiers) << 24));
+			words.push_back(0);
+			words.push_back(sample.lower);
+			words.push_back(sample.upper);
+		}
+		return words;
+	}
+
+#pragma endregion
+
+#pragma region DDS
+
+	constexpr uint32_t makeFourCC(char a, char b, char c, char d) {
+		return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+	}
+
+	struct DDSPixelFormat {
+		uint32_t size, flags, fourCC, rgbBitCount;
+		uint32_t rMask, gMask, bMask, aMask;
+	};
+
+	struct DDSHeader {
+		uint32_t size, flags, height, width, pitchOrLinearSize, depth, mipMapCount;
+		uint32_t reserved1[11];
+		DDSPixelFormat pixelFormat;
+		uint32_t caps, caps2, caps3, caps4, reserved2;
+	};
+
+	struct DDSHeaderDX10 {
+		uint32_t dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+	};
+
+	const uint32_t DDS_MAGIC = makeFourCC('D', 'D', 'S', ' ');
+	const uint32_t DDPF_FOURCC = 0x4, DDPF_RGB = 0x40, DDPF_LUMINANCE = 0x20000;
+	const uint32_t DDSCAPS2_CUBEMAP = 0x200, DDSCAPS2_CUBEMAP_ALL_FACES = 0xFC00, DDSCAPS2_VOLUME = 0x200000;
+	const uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+#pragma endregion
+}
+
+bool TextureFile::IsContainer(const std::string& path) {
+	return FileIO::HasExtension(path, ".ktx2") || FileIO::HasExtension(path, ".dds");
+}
+
+std::shared_ptr<TextureFile> TextureFile::Open(const std::string& path) {
+	auto file = std::make_shared<TextureFile>();
+	if (!file->_file.Open(path))
+		return nullptr;
+
+	const uint8_t* data = file->_file.GetData();
+	uint64_t size = file->_file.GetSize();
+
+	bool parsed = false;
+	if (size >= sizeof(KTX2Header) && std::memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+		parsed = file->parseKTX2(path);
+	else if (size >= 4 + sizeof(DDSHeader) && std::memcmp(data, &DDS_MAGIC, 4) == 0)
+		parsed = file->parseDDS(path);
+	else
+		ENGINE_ERROR("[TextureFile::Open] '{}' is not a KTX2 or DDS file", path);
+
+	if (!parsed || !file->validate(path))
+		return nullptr;
+	return file;
+}
+
+bool TextureFile::parseKTX2(const std::string& path) {
+	KTX2Header header;
+	std::memcpy(&header, _file.GetData(), sizeof(header));
+
+	const FormatInfo* info = findVkFormat(header.vkFormat);
+	if (!info) {
+		ENGINE_ERROR("[TextureFile::parseKTX2] '{}' uses unsupported Vulkan format {}", path, header.vkFormat);
+		return false;
+	}
+	if (header.supercompressionScheme != 0) {
+		ENGINE_ERROR("[TextureFile::parseKTX2] '{}' is supercompressed (scheme {}), which is not supported", path, header.supercompressionScheme);
+		return false;
+	}
+	if (header.pixelHeight == 0 || header.pixelDepth != 0 || header.layerCount > 1 || (header.faceCount != 1 && header.faceCount != 6)) {
+		ENGINE_ERROR("[TextureFile::parseKTX2] '{}' is not a 2D texture or cubemap", path);
+		return false;
+	}
+
+	_format = info->format;
+	_halfFloat = info->halfFloat;
+	_width = header.pixelWidth;
+	_height = header.pixelHeight;
+	_faceCount = header.faceCount;
+	// 0 asks the loader to generate mipmaps, only the base level is stored
+	_levelCount = std::max(header.levelCount, 1u);
+
+	uint64_t levelIndexEnd = sizeof(KTX2Header) + sizeof(KTX2Level) * _levelCount;
+	if (levelIndexEnd > _file.GetSize()) {
+		ENGINE_ERROR("[TextureFile::parseKTX2] '{}' is truncated", path);
+		return false;
+	}
+
+	_images.clear();
+	for (uint32_t level = 0; level < _levelCount; level++) {
+		KTX2Level levelIndex;
+		std::memcpy(&levelIndex, _file.GetData() + sizeof(KTX2Header) + sizeof(KTX2Level) * level, sizeof(levelIndex));
+
+		uint64_t faceSize = imageSize(_format, _halfFloat, std::max(_width >> level, 1u), std::max(_height >> level, 1u));
+		if (faceSize * _faceCount != levelIndex.byteLength) {
+			ENGINE_ERROR("[TextureFile::parseKTX2] Level {} of '{}' is {} bytes, expected {}", level, path, levelIndex.byteLength, faceSize * _faceCount);
+			return false;
+		}
+
+		for (uint32_t face = 0; face < _faceCount; face++)
+			_images.push_back({ levelIndex.byteOffset + face * faceSize, faceSize });
+	}
+	return true;
+}
+
+bool TextureFile::parseDDS(const std::string& path) {
+	DDSHeader header;
+	std::memcpy(&header, _file.GetData() + 4, sizeof(header));
+	uint64_t dataOffset = 4 + sizeof(DDSHeader);
+
+	const FormatInfo* info = nullptr;
+	_faceCount = 1;
+	const DDSPixelFormat& pixelFormat = header.pixelFormat;
+
+	if ((pixelFormat.flags & DDPF_FOURCC) && pixelFormat.fourCC == makeFourCC('D', 'X', '1', '0')) {
+		if (_file.GetSize() < dataOffset + sizeof(DDSHeaderDX10)) {
+			ENGINE_ERROR("[TextureFile::parseDDS] '{}' is truncated", path);
+			return false;
+		}
+
+		DDSHeaderDX10 header10;
+		std::memcpy(&header10, _file.GetData() + dataOffset, sizeof(header10));
+		dataOffset += sizeof(DDSHeaderDX10);
+
+		info = findDxgiFormat(header10.dxgiFormat);
+		if (header10.arraySize > 1) {
+			ENGINE_ERROR("[TextureFile::parseDDS] '{}' is a texture array, which is not supported", path);
+			return false;
+		}
+		if (header10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+			_faceCount = 6;
+	}
+	else if (pixelFormat.flags & DDPF_FOURCC) {
+		switch (pixelFormat.fourCC) {
+		case makeFourCC('D', 'X', 'T', '1'): info = findFormat(ImageFormat::BC1); break;
+		case makeFourCC('D', 'X', 'T', '5'): info = findFormat(ImageFormat::BC3); break;
+		case makeFourCC('A', 'T', 'I', '2'):
+		case makeFourCC('B', 'C', '5', 'U'): info = findFormat(ImageFormat::BC5); break;
+		case 113: info = findFormat(ImageFormat::RGBA16F); break; // D3DFMT_A16B16G16R16F
+		case 116: info = findFormat(ImageFormat::RGBA32F); break; // D3DFMT_A32B32G32R32F
+		}
+	}
+	else if ((pixelFormat.flags & DDPF_RGB) && pixelFormat.rgbBitCount == 32 &&
+		pixelFormat.rMask == 0xFF && pixelFormat.gMask == 0xFF00 && pixelFormat.bMask == 0xFF0000) {
+		info = findFormat(ImageFormat::RGBA8);
+	}
+	else if ((pixelFormat.flags & DDPF_LUMINANCE) && pixelFormat.rgbBitCount == 8) {
+		info = findFormat(ImageFormat::R8);
+	}
+
+	if (!info) {
+		ENGINE_ERROR("[TextureFile::parseDDS] '{}' uses an unsupported pixel format", path);
+		return false;
+	}
+	if (header.caps2 & DDSCAPS2_VOLUME) {
+		ENGINE_ERROR("[TextureFile::parseDDS] '{}' is a volume texture, which is not supported", path);
+		return false;
+	}
+	if (header.caps2 & DDSCAPS2_CUBEMAP) {
+		if ((header.caps2 & DDSCAPS2_CUBEMAP_ALL_FACES) != DDSCAPS2_CUBEMAP_ALL_FACES) {
+			ENGINE_ERROR("[TextureFile::parseDDS] '{}' is a partial cubemap, which is not supported", path);
+			return false;
+		}
+		_faceCount = 6;
+	}
+
+	_format = info->format;
+	_halfFloat = info->halfFloat;
+	_width = header.width;
+	_height = header.height;
+	_levelCount = std::max(header.mipMapCount, 1u);
+
+	// Faces are stored one after the other, each with its whole mip chain
+	std::vector<Image> faceMajor;
+	uint64_t offset = dataOffset;
+	for (uint32_t face = 0; face < _faceCount; face++) {
+		for (uint32_t level = 0; level < _levelCount; level++) {
+			uint64_t size = imageSize(_format, _halfFloat, std::max(_width >> level, 1u), std::max(_height >> level, 1u));
+			faceMajor.push_back({ offset, size });
+			offset += size;
+		}
+	}
+
+	_images.resize(faceMajor.size());
+	for (uint32_t face = 0; face < _faceCount; face++)
+		for (uint32_t level = 0; level < _levelCount; level++)
+			_images[level * _faceCount + face] = faceMajor[face * _levelCount + level];
+	return true;
+}
+
+bool TextureFile::validate(const std::string& path) const {
+	for (const auto& image : _images) {
+		if (image.offset + image.size > _file.GetSize()) {
+			ENGINE_ERROR("[TextureFile::validate] '{}' is truncated", path);
+			return false;
+		}
+	}
+	return true;
+}
+
+const uint8_t* TextureFile::GetData(uint32_t level, uint32_t face) const {
+	if (level >= _levelCount || face >= _faceCount)
+		return nullptr;
+	return _file.GetData() + _images[level * _faceCount + face].offset;
+}
+
+uint64_t TextureFile::GetSize(uint32_t level, uint32_t face) const {
+	if (level >= _levelCount || face >= _faceCount)
+		return 0;
+	return _images[level * _faceCount + face].size;
+}
+
+bool TextureFile::WriteKTX2(const std::string& path, const TextureFileData& data) {
+	const FormatInfo* info = findFormat(data.format);
+	if (!info) {
+		ENGINE_ERROR("[TextureFile::WriteKTX2] Format {} cannot be written to KTX2", (int)data.format);
+		return false;
+	}
+	if (data.images.size() != (size_t)data.levelCount * data.faceCount) {
+		ENGINE_ERROR("[TextureFile::WriteKTX2] Expected {} images, got {}", data.levelCount * data.faceCount, data.images.size());
+		return false;
+	}
+
+	// KTX2 has no 16 bit float formats holding 32 bit floats, convert them
+	bool convertToHalf = info->halfFloat && !data.halfFloat;
+	for (uint32_t level = 0; level < data.levelCount; level++) {
+		uint32_t width = std::max(data.width >> level, 1u), height = std::max(data.height >> level, 1u);
+		uint64_t expected = imageSize(data.format, data.halfFloat, width, height);
+		for (uint32_t face = 0; face < data.faceCount; face++) {
+			if (data.images[level * data.faceCount + face].size() != expected) {
+				ENGINE_ERROR("[TextureFile::WriteKTX2] Level {} face {} is {} bytes, expected {}", level, face, data.images[level * data.faceCount + face].size(), expected);
+				return false;
+			}
+		}
+	}
+
+	std::vector<uint32_t> descriptor = buildDataFormatDescriptor(data.format, info->halfFloat);
+	uint64_t levelIndexSize = sizeof(KTX2Level) * data.levelCount;
+	uint64_t descriptorOffset = sizeof(KTX2Header) + levelIndexSize;
+	uint64_t descriptorSize = descriptor.size() * sizeof(uint32_t);
+
+	// Every level starts at a multiple of the texel block size and of 4
+	uint64_t blockSize = texelBlockSize(data.format, info->halfFloat);
+	uint64_t alignment = blockSize % 4 == 0 ? blockSize : (blockSize % 2 == 0 ? blockSize * 2 : blockSize * 4);
+
+	std::vector<KTX2Level> levels(data.levelCount);
+	uint64_t offset = descriptorOffset + descriptorSize;
+	for (uint32_t level = data.levelCount; level-- > 0;) {
+		offset = (offset + alignment - 1) / alignment * alignment;
+		uint32_t width = std::max(data.width >> level, 1u), height = std::max(data.height >> level, 1u);
+		uint64_t size = imageSize(data.format, info->halfFloat, width, height) * data.faceCount;
+		levels[level] = { offset, size, size };
+		offset += size;
+	}
+
+	KTX2Header header = {};
+	std::memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+	header.vkFormat = info->vkFormat;
+	header.typeSize = Utils::ImageFormatIsCompressed(data.format) ? 1 : (uint32_t)(blockSize / Utils::ImageFormatChannelCount(data.format));
+	header.pixelWidth = data.width;
+	header.pixelHeight = data.height;
+	header.faceCount = data.faceCount;
+	header.levelCount = data.levelCount;
+	header.dfdByteOffset = (uint32_t)descriptorOffset;
+	header.dfdByteLength = (uint32_t)descriptorSize;
+
+	std::error_code error;
+	std::filesystem::path parent = std::filesystem::path(path).parent_path();
+	if (!parent.empty())
+		std::filesystem::create_directories(parent, error);
+
+	// Written under a temporary name first so a crash never leaves a partial file behind, unique per thread
+	// since loader threads may store the same entry at once
+	std::string temporaryPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			ENGINE_ERROR("[TextureFile::WriteKTX2] Could not write to {}", temporaryPath);
+			return false;
+		}
+
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)levels.data(), levelIndexSize);
+		file.write((const char*)descriptor.data(), descriptorSize);
+
+		std::vector<uint16_t> halves;
+		for (uint32_t level = data.levelCount; level-- > 0;) {
+			static const char padding[16] = {};
+			file.write(padding, levels[level].byteOffset - (uint64_t)file.tellp());
+
+			for (uint32_t face = 0; face < data.faceCount; face++) {
+				const auto& image = data.images[level * data.faceCount + face];
+				if (convertToHalf) {
+					const float* floats = (const float*)image.data();
+					halves.resize(image.size() / sizeof(float));
+					for (size_t i = 0; i < halves.size(); i++)
+						halves[i] = floatToHalf(floats[i]);
+					file.write((const char*)halves.data(), halves.size() * sizeof(uint16_t));
+				}
+				else {
+					file.write((const char*)image.data(), image.size());
+				}
+			}
+		}
+
+		if (!file) {
+			ENGINE_ERROR("[TextureFile::WriteKTX2] Failed writing {}", temporaryPath);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error) {
+		ENGINE_ERROR("[TextureFile::WriteKTX2] Could not move {} into place: {}", temporaryPath, error.message());
+		return false;
+	}
+	return true;
+}
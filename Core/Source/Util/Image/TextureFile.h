@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Rendering/Platform/ImageFormat.h"
+#include "Util/MappedFile.h"
+
+namespace Engine {
+	// Images to write into a container, 16F formats hold half floats when halfFloat is set and floats otherwise
+	struct TextureFileData {
+		ImageFormat format = ImageFormat::None;
+		bool halfFloat = false;
+		uint32_t width = 0, height = 0;
+		uint32_t faceCount = 1; // 6 for cubemaps
+		uint32_t levelCount = 1;
+		std::vector<std::vector<uint8_t>> images; // level * faceCount + face
+	};
+
+	// A KTX2 or DDS texture mapped into memory. Every level and face points straight into the mapping,
+	// ready to upload without any decoding. Supercompressed KTX2 files and swizzled DDS formats are rejected.
+	class TextureFile {
+	public:
+		static bool IsContainer(const std::string& path);
+		// Recognised by the file's magic, nullptr if it is neither format or uses an unsupported one
+		static std::shared_ptr<TextureFile> Open(const std::string& path);
+
+		// Levels are stored smallest first as the format requires, 16F data is written as half floats
+		static bool WriteKTX2(const std::string& path, const TextureFileData& data);
+
+		inline ImageFormat GetFormat() const { return _format; }
+		// 16F data is stored as half floats, uploads must use GL_HALF_FLOAT
+		inline bool IsHalfFloat() const { return _halfFloat; }
+		inline uint32_t GetWidth() const { return _width; }
+		inline uint32_t GetHeight() const { return _height; }
+		inline uint32_t GetFaceCount() const { return _faceCount; }
+		inline uint32_t GetLevelCount() const { return _levelCount; }
+		inline bool IsCubemap() const { return _faceCount == 6; }
+
+		const uint8_t* GetData(uint32_t level, uint32_t face = 0) const;
+		uint64_t GetSize(uint32_t level, uint32_t face = 0) const;
+	private:
+		bool parseKTX2(const std::string& path);
+		bool parseDDS(const std::string& path);
+		// Checks every image lies inside the file
+		bool validate(const std::string& path) const;
+	private:
+		struct Image {
+			uint64_t offset, size;
+		};
+
+		MappedFile _file;
+		ImageFormat _format = ImageFormat::None;
+		bool _halfFloat = false;
+		uint32_t _width = 0, _height = 0;
+		uint32_t _faceCount = 1, _levelCount = 1;
+		std::vector<Image> _images; // level * faceCount + face
+	};
+}
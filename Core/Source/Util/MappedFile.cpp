@@ -0,0 +1,108 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Logging/Logging.h"
+
+using namespace Engine;
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path) {
+	Close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		ENGINE_ERROR("[MappedFile::Open] Could not open file: {}", path);
+		return false;
+	}
+	_file = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		ENGINE_ERROR("[MappedFile::Open] File is empty: {}", path);
+		Close();
+		return false;
+	}
+
+	_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mapping)
+		_data = (const uint8_t*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!_data) {
+		ENGINE_ERROR("[MappedFile::Open] Could not map file: {}", path);
+		Close();
+		return false;
+	}
+
+	_size = (uint64_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (_data)
+		UnmapViewOfFile(_data);
+	if (_mapping)
+		CloseHandle(_mapping);
+	if (_file)
+		CloseHandle(_file);
+
+	_data = nullptr;
+	_mapping = _file = nullptr;
+	_size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path) {
+	Close();
+
+	_descriptor = open(path.c_str(), O_RDONLY);
+	if (_descriptor < 0) {
+		ENGINE_ERROR("[MappedFile::Open] Could not open file: {}", path);
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(_descriptor, &status) != 0 || status.st_size == 0) {
+		ENGINE_ERROR("[MappedFile::Open] File is empty: {}", path);
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, _descriptor, 0);
+	if (data == MAP_FAILED) {
+		ENGINE_ERROR("[MappedFile::Open] Could not map file: {}", path);
+		Close();
+		return false;
+	}
+
+	_data = (const uint8_t*)data;
+	_size = (uint64_t)status.st_size;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (_data)
+		munmap((void*)_data, (size_t)_size);
+	if (_descriptor >= 0)
+		close(_descriptor);
+
+	_data = nullptr;
+	_descriptor = -1;
+	_size = 0;
+}
+
+#endif
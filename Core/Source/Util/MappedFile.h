@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace Engine {
+	// A read only file mapped into memory, pages are read in by the OS as they are touched
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::string& path);
+		void Close();
+
+		inline bool IsOpen() const { return _data != nullptr; }
+		inline const uint8_t* GetData() const { return _data; }
+		inline uint64_t GetSize() const { return _size; }
+	private:
+		const uint8_t* _data = nullptr;
+		uint64_t _size = 0;
+
+#ifdef _WIN32
+		void* _file = nullptr;    // HANDLE
+		void* _mapping = nullptr; // HANDLE
+#else
+		int _descriptor = -1;
+#endif
+	};
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <cfloat>
+#include <glm/glm.hpp>
+
+namespace Engine {
+	// Axis aligned box, a default constructed box is empty and grows from nothing
+	struct BoundingBox {
+		glm::vec3 min, max;
+
+		BoundingBox() : min(FLT_MAX), max(-FLT_MAX) {}
+		BoundingBox(const glm::vec3& min, const glm::vec3& max) : min(min), max(max) {}
+
+		bool IsValid() const {
+			return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+		}
+
+		void GrowToInclude(const glm::vec3& point) {
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void GrowToInclude(const BoundingBox& other) {
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		std::vector<glm::vec3> GetCorners() const {
+			std::vector<glm::vec3> corners(8);
+			corners[0] = glm::vec3(min.x, min.y, min.z);
+			corners[1] = glm::vec3(min.x, min.y, max.z);
+			corners[2] = glm::vec3(min.x, max.y, min.z);
+			corners[3] = glm::vec3(min.x, max.y, max.z);
+			corners[4] = glm::vec3(max.x, min.y, min.z);
+			corners[5] = glm::vec3(max.x, min.y, max.z);
+			corners[6] = glm::vec3(max.x, max.y, min.z);
+			corners[7] = glm::vec3(max.x, max.y, max.z);
+			return corners;
+		};
+
+		glm::vec3 GetCenter() const {
+			return (min + max) / 2.0f;
+		}
+
+		glm::vec3 GetSize() const {
+			return max - min;
+		}
+
+		float GetSurfaceArea() const {
+			glm::vec3 size = GetSize();
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		bool Overlaps(const BoundingBox& other) const {
+			return min.x <= other.max.x && max.x >= other.min.x
+				&& min.y <= other.max.y && max.y >= other.min.y
+				&& min.z <= other.max.z && max.z >= other.min.z;
+		}
+
+		// Box around this box after transforming it, projects the extents onto the matrix axes instead of transforming 8 corners
+		BoundingBox Transformed(const glm::mat4& transform) const {
+			glm::vec3 center = transform * glm::vec4(GetCenter(), 1.0f);
+			glm::vec3 extents = GetSize() * 0.5f;
+			glm::vec3 newExtents = glm::abs(glm::vec3(transform[0])) * extents.x
+				+ glm::abs(glm::vec3(transform[1])) * extents.y
+				+ glm::abs(glm::vec3(transform[2])) * extents.z;
+			return BoundingBox(center - newExtents, center + newExtents);
+		}
+	};
+}
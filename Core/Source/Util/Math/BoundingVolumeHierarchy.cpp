@@ -0,0 +1,370 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+
+using namespace Engine;
+
+void BoundingVolumeHierarchy::Insert(uint32_t key, const BoundingBox& bounds) {
+	auto it = _itemIndices.find(key);
+	if (it != _itemIndices.end()) {
+		Update(key, bounds);
+		return;
+	}
+
+	_itemIndices[key] = (uint32_t)_items.size();
+	_items.push_back({ key, bounds });
+	_structureDirty = true;
+}
+
+void BoundingVolumeHierarchy::Update(uint32_t key, const BoundingBox& bounds) {
+	auto it = _itemIndices.find(key);
+	if (it == _itemIndices.end()) {
+		Insert(key, bounds);
+		return;
+	}
+
+	Item& item = _items[it->second];
+	if (item.bounds.min == bounds.min && item.bounds.max == bounds.max)
+		return;
+
+	item.bounds = bounds;
+	_boundsDirty = true;
+}
+
+void BoundingVolumeHierarchy::Remove(uint32_t key) {
+	auto it = _itemIndices.find(key);
+	if (it == _itemIndices.end())
+		return;
+
+	// Swap with the last item, the tree references items by index so it must be rebuilt
+	uint32_t index = it->second;
+	_itemIndices.erase(it);
+	if (index != _items.size() - 1) {
+		_items[index] = _items.back();
+		_itemIndices[_items[index].key] = index;
+	}
+	_items.pop_back();
+	_structureDirty = true;
+}
+
+void BoundingVolumeHierarchy::Clear() {
+	_items.clear();
+	_itemIndices.clear();
+	_itemOrder.clear();
+	_nodes.clear();
+	_structureDirty = _boundsDirty = false;
+	_stats = {};
+}
+
+void BoundingVolumeHierarchy::Commit() {
+	if (_structureDirty) {
+		Rebuild();
+		return;
+	}
+
+	if (!_boundsDirty)
+		return;
+
+	Refit();
+	if (_stats.cost > _stats.builtCost * rebuildThreshold)
+		Rebuild();
+}
+
+void BoundingVolumeHierarchy::Rebuild() {
+	_nodes.clear();
+	_itemOrder.resize(_items.size());
+	for (uint32_t i = 0; i < (uint32_t)_items.size(); i++)
+		_itemOrder[i] = i;
+
+	_stats.depth = 0;
+	if (!_items.empty()) {
+		// A binary tree with leaves of at least one item never has more than 2n - 1 nodes
+		_nodes.reserve(_items.size() * 2);
+		_nodes.emplace_back();
+		build(0, 0, (uint32_t)_items.size(), 1);
+	}
+
+	_structureDirty = _boundsDirty = false;
+	_stats.items = (uint32_t)_items.size();
+	_stats.nodes = (uint32_t)_nodes.size();
+	_stats.cost = _stats.builtCost = computeCost();
+	_stats.rebuilds++;
+}
+
+void BoundingVolumeHierarchy::build(uint32_t nodeIndex, uint32_t begin, uint32_t end, uint32_t depth) {
+	_stats.depth = std::max(_stats.depth, depth);
+
+	BoundingBox bounds, centroidBounds;
+	for (uint32_t i = begin; i < end; i++) {
+		const BoundingBox& itemBounds = _items[_itemOrder[i]].bounds;
+		bounds.GrowToInclude(itemBounds);
+		centroidBounds.GrowToInclude(itemBounds.GetCenter());
+	}
+
+	_nodes[nodeIndex].bounds = bounds;
+	uint32_t count = end - begin;
+	if (count <= MAX_LEAF_ITEMS) {
+		_nodes[nodeIndex].first = begin;
+		_nodes[nodeIndex].count = count;
+		return;
+	}
+
+	// Bin the centroids along every axis and keep the split with the lowest surface area cost
+	int bestAxis = -1;
+	uint32_t bestSplit = 0;
+	float bestCost = FLT_MAX;
+	glm::vec3 centroidSize = centroidBounds.GetSize();
+
+	for (int axis = 0; axis < 3; axis++) {
+		if (centroidSize[axis] <= 0.0f)
+			continue;
+
+		BoundingBox binBounds[SAH_BINS];
+		uint32_t binCounts[SAH_BINS] = {};
+		float scale = SAH_BINS / centroidSize[axis];
+		for (uint32_t i = begin; i < end; i++) {
+			const BoundingBox& itemBounds = _items[_itemOrder[i]].bounds;
+			uint32_t bin = std::min((uint32_t)((itemBounds.GetCenter()[axis] - centroidBounds.min[axis]) * scale), SAH_BINS - 1);
+			binBounds[bin].GrowToInclude(itemBounds);
+			binCounts[bin]++;
+		}
+
+		// Sweep from the right to get the area and count of everything past each split
+		float rightAreas[SAH_BINS];
+		uint32_t rightCounts[SAH_BINS];
+		BoundingBox right;
+		uint32_t rightCount = 0;
+		for (uint32_t bin = SAH_BINS - 1; bin > 0; bin--) {
+			if (binCounts[bin] > 0)
+				right.GrowToInclude(binBounds[bin]);
+			rightCount += binCounts[bin];
+			rightAreas[bin] = right.IsValid() ? right.GetSurfaceArea() : 0.0f;
+			rightCounts[bin] = rightCount;
+		}
+
+		BoundingBox left;
+		uint32_t leftCount = 0;
+		for (uint32_t split = 1; split < SAH_BINS; split++) {
+			if (binCounts[split - 1] > 0)
+				left.GrowToInclude(binBounds[split - 1]);
+			leftCount += binCounts[split - 1];
+			if (leftCount == 0 || rightCounts[split] == 0)
+				continue;
+
+			float cost = left.GetSurfaceArea() * leftCount + rightAreas[split] * rightCounts[split];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	uint32_t middle;
+	if (bestAxis >= 0) {
+		auto it = std::partition(_itemOrder.begin() + begin, _itemOrder.begin() + end, [&](uint32_t index) {
+			const BoundingBox& itemBounds = _items[index].bounds;
+			uint32_t bin = std::min((uint32_t)((itemBounds.GetCenter()[bestAxis] - centroidBounds.min[bestAxis]) * (SAH_BINS / centroidSize[bestAxis])), SAH_BINS - 1);
+			return bin < bestSplit;
+		});
+		middle = (uint32_t)(it - _itemOrder.begin());
+	}
+	else {
+		// Every centroid is in the same place, any split is as good as another
+		middle = begin + count / 2;
+	}
+
+	if (middle == begin || middle == end)
+		middle = begin + count / 2;
+
+	uint32_t children = (uint32_t)_nodes.size();
+	_nodes.emplace_back();
+	_nodes.emplace_back();
+	_nodes[nodeIndex].first = children;
+	_nodes[nodeIndex].count = 0;
+
+	build(children, begin, middle, depth + 1);
+	build(children + 1, middle, end, depth + 1);
+}
+
+void BoundingVolumeHierarchy::Refit() {
+	// Children are always created after their parent, so walking backwards visits them first
+	for (uint32_t i = (uint32_t)_nodes.size(); i-- > 0;) {
+		Node& node = _nodes[i];
+		BoundingBox bounds;
+		if (node.IsLeaf()) {
+			for (uint32_t j = node.first; j < node.first + node.count; j++)
+				bounds.GrowToInclude(_items[_itemOrder[j]].bounds);
+		}
+		else {
+			bounds = _nodes[node.first].bounds;
+			bounds.GrowToInclude(_nodes[node.first + 1].bounds);
+		}
+		node.bounds = bounds;
+	}
+
+	_boundsDirty = false;
+	_stats.cost = computeCost();
+	_stats.refits++;
+}
+
+float BoundingVolumeHierarchy::computeCost() const {
+	if (_nodes.empty())
+		return 0.0f;
+
+	float rootArea = _nodes[0].bounds.GetSurfaceArea();
+	if (rootArea <= 0.0f)
+		return 0.0f;
+
+	// Traversal and item tests are weighted equally
+	float cost = 0.0f;
+	for (const auto& node : _nodes)
+		cost += node.bounds.GetSurfaceArea() * (node.IsLeaf() ? (float)node.count : 1.0f);
+	return cost / rootArea;
+}
+
+void BoundingVolumeHierarchy::appendSubtree(uint32_t nodeIndex, std::vector<uint32_t>& keys) const {
+	const Node& node = _nodes[nodeIndex];
+	if (node.IsLeaf()) {
+		for (uint32_t i = node.first; i < node.first + node.count; i++)
+			keys.push_back(_items[_itemOrder[i]].key);
+		return;
+	}
+
+	appendSubtree(node.first, keys);
+	appendSubtree(node.first + 1, keys);
+}
+
+void BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& keys) const {
+	if (_nodes.empty())
+		return;
+
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty()) {
+		uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+
+		const Node& node = _nodes[nodeIndex];
+		if (!frustum.Intersects(node.bounds))
+			continue;
+
+		if (frustum.Contains(node.bounds)) {
+			appendSubtree(nodeIndex, keys);
+			continue;
+		}
+
+		if (node.IsLeaf()) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				const Item& item = _items[_itemOrder[i]];
+				if (frustum.Intersects(item.bounds))
+					keys.push_back(item.key);
+			}
+			continue;
+		}
+
+		stack.push_back(node.first);
+		stack.push_back(node.first + 1);
+	}
+}
+
+void BoundingVolumeHierarchy::QueryOverlap(const BoundingBox& bounds, std::vector<uint32_t>& keys) const {
+	if (_nodes.empty())
+		return;
+
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty()) {
+		const Node& node = _nodes[stack.back()];
+		stack.pop_back();
+
+		if (!node.bounds.Overlaps(bounds))
+			continue;
+
+		if (node.IsLeaf()) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				const Item& item = _items[_itemOrder[i]];
+				if (item.bounds.Overlaps(bounds))
+					keys.push_back(item.key);
+			}
+			continue;
+		}
+
+		stack.push_back(node.first);
+		stack.push_back(node.first + 1);
+	}
+}
+
+void BoundingVolumeHierarchy::QueryRay(const Ray& ray, float maxDistance, std::vector<uint32_t>& keys) const {
+	if (_nodes.empty())
+		return;
+
+	float distance;
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty()) {
+		const Node& node = _nodes[stack.back()];
+		stack.pop_back();
+
+		if (!ray.Intersects(node.bounds, maxDistance, distance))
+			continue;
+
+		if (node.IsLeaf()) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				const Item& item = _items[_itemOrder[i]];
+				if (ray.Intersects(item.bounds, maxDistance, distance))
+					keys.push_back(item.key);
+			}
+			continue;
+		}
+
+		stack.push_back(node.first);
+		stack.push_back(node.first + 1);
+	}
+}
+
+bool BoundingVolumeHierarchy::Raycast(const Ray& ray, float maxDistance, uint32_t& key, float& distance) const {
+	if (_nodes.empty())
+		return false;
+
+	bool hit = false;
+	float closest = maxDistance;
+	float nodeDistance;
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty()) {
+		const Node& node = _nodes[stack.back()];
+		stack.pop_back();
+
+		// Anything entered beyond the closest hit so far cannot be closer
+		if (!ray.Intersects(node.bounds, closest, nodeDistance))
+			continue;
+
+		if (node.IsLeaf()) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				const Item& item = _items[_itemOrder[i]];
+				float itemDistance;
+				if (ray.Intersects(item.bounds, closest, itemDistance) && (!hit || itemDistance < closest)) {
+					hit = true;
+					closest = itemDistance;
+					key = item.key;
+				}
+			}
+			continue;
+		}
+
+		// Push the further child first so the nearer one is visited first
+		float leftDistance = FLT_MAX, rightDistance = FLT_MAX;
+		bool left = ray.Intersects(_nodes[node.first].bounds, closest, leftDistance);
+		bool right = ray.Intersects(_nodes[node.first + 1].bounds, closest, rightDistance);
+		if (left && right) {
+			bool leftFirst = leftDistance <= rightDistance;
+			stack.push_back(leftFirst ? node.first + 1 : node.first);
+			stack.push_back(leftFirst ? node.first : node.first + 1);
+		}
+		else if (left)
+			stack.push_back(node.first);
+		else if (right)
+			stack.push_back(node.first + 1);
+	}
+
+	if (hit)
+		distance = closest;
+	return hit;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include "BoundingBox.h"
+#include "Frustum.h"
+#include "Ray.h"
+
+namespace Engine {
+	struct BVHStats {
+		uint32_t items = 0;
+		uint32_t nodes = 0;
+		uint32_t depth = 0;
+		float cost = 0.0f;      // SAH cost of the current tree
+		float builtCost = 0.0f; // SAH cost right after the last rebuild
+		uint32_t rebuilds = 0;
+		uint32_t refits = 0;
+	};
+
+	// Binary tree of boxes over keyed items (eg. entities). Moving items only refits the node bounds,
+	// the tree is rebuilt with the surface area heuristic when items are added or removed, or when
+	// refitting has made the tree worse than the rebuild threshold allows. Changes are applied by Commit.
+	class BoundingVolumeHierarchy {
+	public:
+		static constexpr uint32_t MAX_LEAF_ITEMS = 4;
+		static constexpr uint32_t SAH_BINS = 12;
+
+		// Rebuild once the refitted cost exceeds the built cost by this factor
+		float rebuildThreshold = 1.5f;
+
+		void Insert(uint32_t key, const BoundingBox& bounds);
+		// Inserts unknown keys, otherwise only marks the tree for refitting if the bounds actually changed
+		void Update(uint32_t key, const BoundingBox& bounds);
+		void Remove(uint32_t key);
+		void Clear();
+
+		bool Contains(uint32_t key) const { return _itemIndices.find(key) != _itemIndices.end(); }
+		uint32_t GetCount() const { return (uint32_t)_items.size(); }
+
+		void Commit();
+		void Rebuild();
+		void Refit();
+
+		// Results are appended, items are reported once
+		void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& keys) const;
+		void QueryOverlap(const BoundingBox& bounds, std::vector<uint32_t>& keys) const;
+		void QueryRay(const Ray& ray, float maxDistance, std::vector<uint32_t>& keys) const;
+		// Closest item whose bounds the ray hits
+		bool Raycast(const Ray& ray, float maxDistance, uint32_t& key, float& distance) const;
+
+		inline const BVHStats& GetStats() const { return _stats; }
+	private:
+		struct Item {
+			uint32_t key;
+			BoundingBox bounds;
+		};
+
+		// Leaves reference count items of _itemOrder from first, internal nodes have their children at first and first + 1
+		struct Node {
+			BoundingBox bounds;
+			uint32_t first = 0;
+			uint32_t count = 0;
+
+			inline bool IsLeaf() const { return count > 0; }
+		};
+
+		void build(uint32_t nodeIndex, uint32_t begin, uint32_t end, uint32_t depth);
+		void appendSubtree(uint32_t nodeIndex, std::vector<uint32_t>& keys) const;
+		float computeCost() const;
+	private:
+		std::vector<Item> _items;
+		std::unordered_map<uint32_t, uint32_t> _itemIndices; // key -> index into _items
+		std::vector<uint32_t> _itemOrder;
+		std::vector<Node> _nodes;
+
+		bool _structureDirty = false;
+		bool _boundsDirty = false;
+		BVHStats _stats;
+	};
+}
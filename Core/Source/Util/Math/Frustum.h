@@ -0,0 +1,63 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include "BoundingBox.h"
+
+namespace Engine {
+	// Six planes pointing inwards (xyz normal, w distance), extracted from a view projection matrix
+	struct Frustum {
+		enum Plane { Left = 0, Right, Bottom, Top, Near, Far };
+		glm::vec4 planes[6];
+
+		static Frustum FromMatrix(const glm::mat4& viewProjection) {
+			// Rows of the matrix, glm is column major
+			glm::vec4 row0 = { viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0] };
+			glm::vec4 row1 = { viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1] };
+			glm::vec4 row2 = { viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2] };
+			glm::vec4 row3 = { viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3] };
+
+			Frustum frustum;
+			frustum.planes[Left] = row3 + row0;
+			frustum.planes[Right] = row3 - row0;
+			frustum.planes[Bottom] = row3 + row1;
+			frustum.planes[Top] = row3 - row1;
+			frustum.planes[Near] = row3 + row2;
+			frustum.planes[Far] = row3 - row2;
+
+			for (auto& plane : frustum.planes)
+				plane /= glm::length(glm::vec3(plane));
+
+			return frustum;
+		}
+
+		// Conservative, boxes near the frustum corners may pass without being visible
+		bool Intersects(const BoundingBox& box) const {
+			for (const auto& plane : planes) {
+				// Corner furthest along the plane normal
+				glm::vec3 positive = {
+					plane.x >= 0.0f ? box.max.x : box.min.x,
+					plane.y >= 0.0f ? box.max.y : box.min.y,
+					plane.z >= 0.0f ? box.max.z : box.min.z
+				};
+				if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+					return false;
+			}
+			return true;
+		}
+
+		// True when the whole box is inside, everything below a contained node can skip testing
+		bool Contains(const BoundingBox& box) const {
+			for (const auto& plane : planes) {
+				// Corner furthest against the plane normal
+				glm::vec3 negative = {
+					plane.x >= 0.0f ? box.min.x : box.max.x,
+					plane.y >= 0.0f ? box.min.y : box.max.y,
+					plane.z >= 0.0f ? box.min.z : box.max.z
+				};
+				if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.0f)
+					return false;
+			}
+			return true;
+		}
+	};
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cfloat>
+#include <glm/glm.hpp>
+
+#include "BoundingBox.h"
+
+namespace Engine {
+	struct Ray {
+		glm::vec3 origin;
+		glm::vec3 direction;
+
+		Ray() : origin(0.0f), direction(0.0f, 0.0f, -1.0f) {}
+		Ray(const glm::vec3& origin, const glm::vec3& direction) : origin(origin), direction(direction) {}
+
+		glm::vec3 GetPoint(float distance) const {
+			return origin + direction * distance;
+		}
+
+		// Slab test, distance is where the ray enters the box (0 when starting inside), in units of direction
+		bool Intersects(const BoundingBox& box, float maxDistance, float& distance) const {
+			glm::vec3 inverse = 1.0f / direction;
+			glm::vec3 t0 = (box.min - origin) * inverse;
+			glm::vec3 t1 = (box.max - origin) * inverse;
+			glm::vec3 tNear = glm::min(t0, t1);
+			glm::vec3 tFar = glm::max(t0, t1);
+
+			float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+			float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDistance));
+			if (enter > exit)
+				return false;
+
+			distance = enter;
+			return true;
+		}
+	};
+}
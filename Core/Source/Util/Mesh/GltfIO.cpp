@@ -1,18 +1,96 @@
 #include "GltfIO.h"
 #include "Logging/Logging.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <limits>
 #include <vector>
-#include <map>
+
+#include <json.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
 
 using namespace Engine;
 
-tinygltf::Model GltfIO::LoadModel(const std::string& path) {
-	tinygltf::Model model;
+namespace {
+	const uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+	const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+	const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+	uint32_t readUint32(const uint8_t* data) {
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	// Header, a JSON chunk and an optional BIN chunk
+	bool readGlbChunks(const uint8_t* data, uint64_t size, const uint8_t*& json, uint64_t& jsonSize, const uint8_t*& bin, uint64_t& binSize) {
+		if (size < 20 || readUint32(data) != GLB_MAGIC || readUint32(data + 4) != 2)
+			return false;
+
+		uint64_t length = std::min<uint64_t>(readUint32(data + 8), size);
+		jsonSize = readUint32(data + 12);
+		if (readUint32(data + 16) != GLB_CHUNK_JSON || 20 + jsonSize > length)
+			return false;
+		json = data + 20;
+
+		uint64_t binChunk = 20 + jsonSize;
+		bin = nullptr;
+		binSize = 0;
+		if (binChunk + 8 <= length && readUint32(data + binChunk + 4) == GLB_CHUNK_BIN) {
+			binSize = readUint32(data + binChunk);
+			if (binChunk + 8 + binSize > length)
+				return false;
+			bin = data + binChunk + 8;
+		}
+		return true;
+	}
+}
+
+const uint8_t* GltfModel::GetBufferData(uint32_t buffer, uint64_t offset, uint64_t size) const {
+	if (buffer >= buffers.size() || offset + size > buffers[buffer].second)
+		return nullptr;
+	return buffers[buffer].first + offset;
+}
+
+GltfModel GltfIO::LoadModel(const std::string& path) {
+	GltfModel gltf;
+	auto file = std::make_shared<MappedFile>();
+	if (!file->Open(path))
+		return {};
+
+	const uint8_t* json = file->GetData();
+	uint64_t jsonSize = file->GetSize();
+	const uint8_t* bin = nullptr;
+	uint64_t binSize = 0;
+	bool binary = jsonSize >= 4 && readUint32(json) == GLB_MAGIC;
+	if (binary && !readGlbChunks(file->GetData(), file->GetSize(), json, jsonSize, bin, binSize)) {
+		ENGINE_ERROR("[GltfIO::LoadModel] {} is not a valid GLB file", path);
+		return {};
+	}
+
+	nlohmann::json document = nlohmann::json::parse(json, json + jsonSize, nullptr, false);
+	if (document.is_discarded() || !document.is_object()) {
+		ENGINE_ERROR("[GltfIO::LoadModel] Failed to parse the JSON of {}", path);
+		return {};
+	}
+
+	// tinygltf would copy every buffer and decode every image, it only gets to parse the rest
+	nlohmann::json buffers = document.contains("buffers") ? std::move(document["buffers"]) : nlohmann::json::array();
+	document.erase("buffers");
+	document.erase("images");
+	std::string text = document.dump();
+
 	tinygltf::TinyGLTF loader;
 	std::string err;
 	std::string warn;
+	std::string baseDirectory = std::filesystem::path(path).parent_path().string();
 
-	bool ret = loader.LoadASCIIFromFile(&model, &err, &warn, path);
+	bool ret = loader.LoadASCIIFromString(&gltf.model, &err, &warn, text.c_str(), (unsigned int)text.size(), baseDirectory);
 
 	if (!warn.empty()) {
 		ENGINE_WARN("[GltfIO::LoadModel] Warn: {}", warn);
@@ -28,96 +106,395 @@ tinygltf::Model GltfIO::LoadModel(const std::string& path) {
 		return {};
 	}
 
+	for (const auto& entry : buffers) {
+		tinygltf::Buffer buffer;
+		buffer.name = entry.value("name", "");
+		buffer.uri = entry.value("uri", "");
+		uint64_t byteLength = entry.value("byteLength", (uint64_t)0);
+
+		const uint8_t* data = nullptr;
+		if (buffer.uri.empty()) {
+			// The GLB's own BIN chunk
+			if (!bin || byteLength > binSize) {
+				ENGINE_ERROR("[GltfIO::LoadModel] Buffer of {} bytes does not fit in the {} byte BIN chunk of {}", byteLength, binSize, path);
+				return {};
+			}
+			data = bin;
+			if (gltf.files.empty())
+				gltf.files.push_back(file);
+		}
+		else if (tinygltf::IsDataURI(buffer.uri)) {
+			std::string mimeType;
+			if (!tinygltf::DecodeDataURI(&buffer.data, mimeType, buffer.uri, byteLength, true)) {
+				ENGINE_ERROR("[GltfIO::LoadModel] Failed to decode a data URI buffer of {}", path);
+				return {};
+			}
+			buffer.uri.clear();
+			data = buffer.data.data();
+		}
+		else {
+			auto bufferFile = std::make_shared<MappedFile>();
+			if (!bufferFile->Open((std::filesystem::path(baseDirectory) / buffer.uri).string()))
+				return {};
+			if (bufferFile->GetSize() < byteLength) {
+				ENGINE_ERROR("[GltfIO::LoadModel] {} holds {} bytes, expected {}", buffer.uri, bufferFile->GetSize(), byteLength);
+				return {};
+			}
+			data = bufferFile->GetData();
+			gltf.files.push_back(bufferFile);
+		}
+
+		gltf.model.buffers.push_back(std::move(buffer));
+		gltf.buffers.push_back({ data, byteLength });
+	}
+
 	ENGINE_INFO("[GltfIO::LoadModel] Successfully loaded glTF");
 
-	return model;
+	return gltf;
 }
 
-std::shared_ptr<VertexArrayObject> GltfIO::LoadPrimitive(const tinygltf::Model& model, const tinygltf::Primitive& primitive) {
-	// Create map of layouts <Accessor(index), <VertexCount, VertexLayout>>
-	std::map<uint32_t, std::pair<uint32_t, VertexLayout>> layoutDescriptors{};
-	{
-		// Create component for each attribute
-		std::multimap<uint32_t, std::pair<uint32_t, VertexComponent>> componentMap{};
-
-		for (const auto& [attributeName, index] : primitive.attributes) {
-			const tinygltf::Accessor& accessor = model.accessors[index];
-
-			VertexComponent component{
-				attributeName,
-				(LType)accessor.componentType,
-				getNumComponents(accessor.type)
-			};
-			componentMap.emplace(accessor.bufferView, std::make_pair(accessor.count, component));
+namespace {
+	// Attributes are laid out in this order so their locations do not depend on how the file stores them
+	uint32_t attributeRank(const std::string& name) {
+		static const char* ORDER[] = { "POSITION", "NORMAL", "TEXCOORD_0", "TANGENT" };
+		for (uint32_t i = 0; i < sizeof(ORDER) / sizeof(ORDER[0]); i++)
+			if (name == ORDER[i])
+				return i;
+		return sizeof(ORDER) / sizeof(ORDER[0]);
+	}
+
+	struct SourceAttribute {
+		VertexComponent component;
+		const uint8_t* data = nullptr; // nullptr reads as zeros
+		uint64_t stride = 0;
+		std::vector<uint8_t> encoded; // Owns data once the attribute has been re-encoded
+	};
+
+	int16_t toSnorm16(float value) { return (int16_t)std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f); }
+	int8_t toSnorm8(float value) { return (int8_t)std::round(std::clamp(value, -1.0f, 1.0f) * 127.0f); }
+	uint16_t toUnorm16(float value) { return (uint16_t)std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f); }
+
+	// Projects the direction onto an octahedron unfolded into [-1, 1]^2, the lower half folded over the corners
+	glm::vec2 octahedralEncode(const glm::vec3& direction) {
+		float sum = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+		if (sum <= 0.0f)
+			return glm::vec2(0.0f);
+
+		glm::vec3 n = direction / sum;
+		if (n.z >= 0.0f)
+			return glm::vec2(n.x, n.y);
+		return glm::vec2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+	}
+
+	// Float attributes only, up to 4 values
+	void readFloats(const SourceAttribute& attribute, uint32_t vertex, float* values) {
+		if (attribute.data)
+			std::memcpy(values, attribute.data + vertex * attribute.stride, attribute.component.Count * sizeof(float));
+		else
+			std::fill(values, values + attribute.component.Count, 0.0f);
+	}
+
+	template<typename Encode>
+	void encodeAttribute(SourceAttribute& attribute, uint32_t vertexCount, const VertexComponent& component, Encode encode) {
+		uint32_t size = component.GetByteSize();
+		std::vector<uint8_t> encoded((size_t)vertexCount * size);
+		float values[4];
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+			readFloats(attribute, vertex, values);
+			encode(values, encoded.data() + (size_t)vertex * size);
 		}
 
-		// Fill layout map
-		for (auto it = componentMap.begin(); it != componentMap.end();) {
-			uint32_t key = it->first;
-			VertexLayout layout;
+		attribute.component = component;
+		attribute.encoded = std::move(encoded);
+		attribute.data = attribute.encoded.data();
+		attribute.stride = size;
+	}
 
-			auto range = componentMap.equal_range(key);
-			for (auto rangeIt = range.first; rangeIt != range.second; rangeIt++) {
-				VertexComponent component = rangeIt->second.second;
-				layout.AddComponent(component);
-			}
+	bool isFloatAttribute(const SourceAttribute& attribute, const char* name, uint32_t count) {
+		return attribute.component.Name == name && attribute.component.Type == LType::Float && attribute.component.Count == count;
+	}
+
+	void encodePositions(SourceAttribute& attribute, uint32_t vertexCount, PositionEncoding encoding, VertexDecoding& decoding) {
+		BoundingBox bounds;
+		float values[4];
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+			readFloats(attribute, vertex, values);
+			bounds.GrowToInclude(glm::vec3(values[0], values[1], values[2]));
+		}
+		if (!bounds.IsValid())
+			return;
+
+		// Four components keep every vertex 4 byte aligned, the shader ignores w
+		glm::vec3 center = bounds.GetCenter();
+		if (encoding == PositionEncoding::Half) {
+			encodeAttribute(attribute, vertexCount, { "POSITION", LType::HalfFloat, 4 }, [&](const float* position, uint8_t* out) {
+				uint16_t half[4] = { glm::packHalf1x16(position[0] - center.x), glm::packHalf1x16(position[1] - center.y), glm::packHalf1x16(position[2] - center.z), glm::packHalf1x16(1.0f) };
+				std::memcpy(out, half, sizeof(half));
+			});
+			decoding.positionOffset = center;
+			return;
+		}
+
+		// Flat axes keep a scale of 1 so the transform stays invertible
+		glm::vec3 extent = bounds.GetSize() * 0.5f;
+		glm::vec3 scale(extent.x > 0.0f ? extent.x : 1.0f, extent.y > 0.0f ? extent.y : 1.0f, extent.z > 0.0f ? extent.z : 1.0f);
+		encodeAttribute(attribute, vertexCount, { "POSITION", LType::Short, 4, 0, true }, [&](const float* position, uint8_t* out) {
+			int16_t snorm[4] = { toSnorm16((position[0] - center.x) / scale.x), toSnorm16((position[1] - center.y) / scale.y), toSnorm16((position[2] - center.z) / scale.z), 32767 };
+			std::memcpy(out, snorm, sizeof(snorm));
+		});
+		decoding.positionScale = scale;
+		decoding.positionOffset = center;
+	}
+
+	// Attributes that are not 32 bit floats already come encoded and are kept as they are
+	void encodeAttributes(std::vector<SourceAttribute>& attributes, uint32_t vertexCount, const MeshImportSettings& settings, VertexDecoding& decoding) {
+		// One switch decodes normals and tangents together, so either both are encoded or neither
+		bool octahedral = settings.octahedralNormals;
+		for (const auto& attribute : attributes) {
+			if ((attribute.component.Name == "NORMAL" && !isFloatAttribute(attribute, "NORMAL", 3))
+				|| (attribute.component.Name == "TANGENT" && !isFloatAttribute(attribute, "TANGENT", 4)))
+				octahedral = false;
+		}
 
-			uint32_t vertexCount = range.first->second.first;
-			layoutDescriptors[key] = std::make_pair(vertexCount, layout);
-			it = range.second;
+		for (auto& attribute : attributes) {
+			if (settings.positionEncoding != PositionEncoding::Float && isFloatAttribute(attribute, "POSITION", 3)) {
+				encodePositions(attribute, vertexCount, settings.positionEncoding, decoding);
+			}
+			else if (octahedral && attribute.component.Name == "NORMAL") {
+				encodeAttribute(attribute, vertexCount, { "NORMAL", LType::Short, 2, 0, true }, [](const float* normal, uint8_t* out) {
+					glm::vec2 octahedron = octahedralEncode({ normal[0], normal[1], normal[2] });
+					int16_t snorm[2] = { toSnorm16(octahedron.x), toSnorm16(octahedron.y) };
+					std::memcpy(out, snorm, sizeof(snorm));
+				});
+				decoding.octahedralNormals = true;
+			}
+			else if (octahedral && attribute.component.Name == "TANGENT") {
+				encodeAttribute(attribute, vertexCount, { "TANGENT", LType::Byte, 4, 0, true }, [](const float* tangent, uint8_t* out) {
+					glm::vec2 octahedron = octahedralEncode({ tangent[0], tangent[1], tangent[2] });
+					int8_t snorm[4] = { toSnorm8(octahedron.x), toSnorm8(octahedron.y), (int8_t)(tangent[3] < 0.0f ? -127 : 127), 0 };
+					std::memcpy(out, snorm, sizeof(snorm));
+				});
+				decoding.octahedralNormals = true;
+			}
+			else if (settings.unormTexCoords && attribute.component.Name.rfind("TEXCOORD_", 0) == 0
+				&& attribute.component.Type == LType::Float && attribute.component.Count == 2) {
+				// Wrapping coordinates would be clamped, those sets stay float
+				bool inRange = true;
+				float uv[2];
+				for (uint32_t vertex = 0; vertex < vertexCount && inRange; vertex++) {
+					readFloats(attribute, vertex, uv);
+					inRange = uv[0] >= 0.0f && uv[0] <= 1.0f && uv[1] >= 0.0f && uv[1] <= 1.0f;
+				}
+				if (!inRange)
+					continue;
+
+				encodeAttribute(attribute, vertexCount, { attribute.component.Name, LType::UnsignedShort, 2, 0, true }, [](const float* uv, uint8_t* out) {
+					uint16_t unorm[2] = { toUnorm16(uv[0]), toUnorm16(uv[1]) };
+					std::memcpy(out, unorm, sizeof(unorm));
+				});
+			}
 		}
 	}
+}
+
+std::string MeshImportSettings::GetKey() const {
+	return "streams=" + std::to_string((int)streamLayout) + "|positions=" + std::to_string((int)positionEncoding) +
+		"|octahedral=" + std::to_string(octahedralNormals) + "|unormUVs=" + std::to_string(unormTexCoords) + "|optimize=" + std::to_string(optimize);
+}
+
+bool GltfIO::ImportPrimitive(const GltfModel& gltf, const tinygltf::Primitive& primitive, SubmeshData& submesh, const MeshImportSettings& settings) {
+	const tinygltf::Model& model = gltf.model;
+
+	// Every attribute is read through its accessor, wherever and however strided its bufferView stores it
+	std::vector<SourceAttribute> attributes;
+	uint32_t vertexCount = 0;
+	for (const auto& [attributeName, index] : primitive.attributes) {
+		// tinygltf leaves accessor and buffer view indices unchecked
+		if (index < 0 || index >= (int)model.accessors.size()) {
+			ENGINE_ERROR("[GltfIO::ImportPrimitive] Attribute {} references missing accessor {}", attributeName, index);
+			return false;
+		}
+		const tinygltf::Accessor& accessor = model.accessors[index];
 
-	std::shared_ptr<VertexArrayObject> vao = std::make_shared<VertexArrayObject>();
+		SourceAttribute attribute;
+		attribute.component = { attributeName, (LType)accessor.componentType, getNumComponents(accessor.type), 0, accessor.normalized };
+		uint32_t elementSize = attribute.component.GetByteSize();
 
-	// Vertex Buffers
-	for (const auto& [bufferViewIndex, layoutDescriptor] : layoutDescriptors) {
-		const tinygltf::BufferView& bufferView = model.bufferViews[bufferViewIndex];
-		const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+		if (attributes.empty())
+			vertexCount = (uint32_t)accessor.count;
+		else if (accessor.count != vertexCount) {
+			ENGINE_ERROR("[GltfIO::ImportPrimitive] Attribute {} has {} elements, expected {}", attributeName, accessor.count, vertexCount);
+			return false;
+		}
+
+		if (accessor.sparse.isSparse)
+			ENGINE_WARN("[GltfIO::ImportPrimitive] Sparse accessor {} is not supported, only its base values are used", attributeName);
+
+		if (accessor.bufferView >= (int)model.bufferViews.size()) {
+			ENGINE_ERROR("[GltfIO::ImportPrimitive] Attribute {} references missing buffer view {}", attributeName, accessor.bufferView);
+			return false;
+		}
+
+		if (accessor.bufferView >= 0 && vertexCount > 0) {
+			const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+			attribute.stride = bufferView.byteStride > 0 ? bufferView.byteStride : elementSize;
+			uint64_t size = (uint64_t)(vertexCount - 1) * attribute.stride + elementSize;
+			attribute.data = gltf.GetBufferData(bufferView.buffer, bufferView.byteOffset + accessor.byteOffset, size);
+			if (!attribute.data || accessor.byteOffset + size > bufferView.byteLength) {
+				ENGINE_ERROR("[GltfIO::ImportPrimitive] Attribute {} lies outside its buffer view", attributeName);
+				return false;
+			}
+		}
+
+		attributes.push_back(std::move(attribute));
+	}
 
-		const unsigned char* data = &buffer.data[bufferView.byteOffset];
+	std::stable_sort(attributes.begin(), attributes.end(), [](const SourceAttribute& a, const SourceAttribute& b) {
+		return attributeRank(a.component.Name) < attributeRank(b.component.Name);
+	});
+
+	encodeAttributes(attributes, vertexCount, settings, submesh.decoding);
+
+	// Attributes are packed tightly into as few streams as the settings allow
+	std::vector<std::vector<const SourceAttribute*>> streamAttributes(1);
+	for (const auto& attribute : attributes) {
+		bool split = settings.streamLayout == VertexStreamLayout::SplitPosition && attribute.component.Name == "POSITION";
+		if (split && !streamAttributes.back().empty())
+			streamAttributes.emplace_back();
+		streamAttributes.back().push_back(&attribute);
+		if (split)
+			streamAttributes.emplace_back();
+	}
 
-		std::shared_ptr<VertexBufferObject> vbo = std::make_shared<VertexBufferObject>();
-		uint32_t vertexCount = layoutDescriptor.first;
-		VertexLayout layout = layoutDescriptor.second;
-		vbo->SetData(data, vertexCount, layout);
-		vao->AddVertexBuffer(vbo);
+	for (const auto& sources : streamAttributes) {
+		if (sources.empty())
+			continue;
+
+		VertexStreamData stream;
+		stream.vertexCount = vertexCount;
+		for (const auto* source : sources)
+			stream.layout.AddComponent(source->component);
+
+		uint32_t stride = stream.layout.GetStride();
+		stream.data.assign((size_t)vertexCount * stride, 0);
+
+		uint32_t offset = 0;
+		for (const auto* source : sources) {
+			uint32_t elementSize = source->component.GetByteSize();
+			if (source->data) {
+				uint8_t* destination = stream.data.data() + offset;
+				for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+					std::memcpy(destination + (size_t)vertex * stride, source->data + vertex * source->stride, elementSize);
+			}
+			offset += elementSize;
+		}
+
+		submesh.streams.push_back(std::move(stream));
 	}
 
 	// Index Buffers
-	{
+	if (primitive.indices >= 0) {
+		if (primitive.indices >= (int)model.accessors.size()) {
+			ENGINE_ERROR("[GltfIO::ImportPrimitive] Indices reference missing accessor {}", primitive.indices);
+			return false;
+		}
+
+		// Valid files can leave the buffer view out (eg. Draco compressed or sparse accessors), there is nothing to read then
 		const tinygltf::Accessor& accessor = model.accessors[primitive.indices];
+		if (accessor.bufferView < 0 || accessor.bufferView >= (int)model.bufferViews.size()) {
+			ENGINE_ERROR("[GltfIO::ImportPrimitive] Indices have no buffer view ({})", accessor.bufferView);
+			return false;
+		}
+
 		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-		const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+		uint64_t size = (uint64_t)accessor.count * getComponentByteSize(accessor.componentType);
+		const unsigned char* data = gltf.GetBufferData(bufferView.buffer, bufferView.byteOffset + accessor.byteOffset, size);
+		if (!data || accessor.byteOffset + size > bufferView.byteLength) {
+			ENGINE_ERROR("[GltfIO::ImportPrimitive] Indices lie outside their buffer view");
+			return false;
+		}
 
-		const unsigned char* data = &buffer.data[bufferView.byteOffset + accessor.byteOffset];
+		submesh.indexType = (LType)accessor.componentType;
+		submesh.indexCount = (uint32_t)accessor.count;
+		submesh.indices.assign(data, data + size);
+	}
+
+	submesh.drawMode = (DrawMode)primitive.mode;
 
-		std::shared_ptr<IndexBufferObject> ibo = std::make_shared<IndexBufferObject>();
-		ibo->SetData(data, (LType)accessor.componentType, (uint32_t)accessor.count);
-		vao->SetIndexBuffer(ibo);
+	// The spec requires min and max on position accessors
+	auto positionIt = primitive.attributes.find("POSITION");
+	if (positionIt != primitive.attributes.end()) {
+		const tinygltf::Accessor& accessor = model.accessors[positionIt->second];
+		if (accessor.minValues.size() == 3 && accessor.maxValues.size() == 3) {
+			submesh.bounds = BoundingBox(
+				{ accessor.minValues[0], accessor.minValues[1], accessor.minValues[2] },
+				{ accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2] });
+		}
+		else {
+			ENGINE_WARN("[GltfIO::ImportPrimitive] Position accessor has no bounds, primitive will not be culled");
+		}
 	}
 
-	vao->Compute();
-	vao->SetDrawMode((DrawMode)primitive.mode);
+	return true;
+}
 
-	return vao;
+bool GltfIO::ImportMesh(const GltfModel& gltf, uint32_t meshIndex, MeshFileData& data, const MeshImportSettings& settings) {
+	if (meshIndex >= gltf.model.meshes.size()) {
+		ENGINE_ERROR("[GltfIO::ImportMesh] Mesh index out of bounds");
+		return false;
+	}
+
+	const auto& primitives = gltf.model.meshes[meshIndex].primitives;
+	for (uint32_t i = 0; i < (uint32_t)primitives.size(); i++) {
+		SubmeshData submesh;
+		if (!ImportPrimitive(gltf, primitives[i], submesh, settings))
+			continue;
+
+		MeshOptimizerStats stats;
+		if (settings.optimize && MeshOptimizer::Optimize(submesh, stats)) {
+			ENGINE_INFO("[GltfIO::ImportMesh] Primitive {}: {} -> {} vertices, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, {} clusters",
+				i, stats.verticesBefore, stats.verticesAfter, stats.acmrBefore, stats.acmrAfter, stats.atvrBefore, stats.atvrAfter, stats.clusters);
+		}
+		data.submeshes.push_back(std::move(submesh));
+	}
+	return true;
 }
 
-std::shared_ptr<Mesh> GltfIO::LoadMesh(const tinygltf::Model& model, uint32_t meshIndex) {
-	std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+std::shared_ptr<VertexArrayObject> GltfIO::LoadPrimitive(const GltfModel& gltf, const tinygltf::Primitive& primitive) {
+	SubmeshData submesh;
+	if (!ImportPrimitive(gltf, primitive, submesh))
+		return nullptr;
+	return Mesh::Utils::CreateSubmesh(submesh.GetView());
+}
 
-	if (meshIndex >= model.meshes.size()) {
-		ENGINE_ERROR("[GltfIO::LoadMesh] Mesh index out of bounds");
+std::shared_ptr<Mesh> GltfIO::LoadMesh(const GltfModel& gltf, uint32_t meshIndex) {
+	MeshFileData data;
+	if (!ImportMesh(gltf, meshIndex, data))
 		return nullptr;
-	}
+	return Mesh::Utils::FromMeshFileData(data);
+}
 
-	auto& gltfMesh = model.meshes[meshIndex];
-	for (auto& gltfPrimitive : gltfMesh.primitives) {
-		auto va = LoadPrimitive(model, gltfPrimitive);
-		mesh->AddSubmesh(va);
+std::shared_ptr<Mesh> GltfIO::LoadMeshCached(const std::string& path, uint32_t meshIndex, const MeshImportSettings& settings) {
+	auto start = std::chrono::steady_clock::now();
+	std::string key = MeshCache::MakeKey(path, "mesh-" + std::to_string(meshIndex) + "|" + settings.GetKey());
+
+	auto cached = MeshCache::Load(key);
+	if (cached) {
+		auto mesh = Mesh::Utils::FromMeshFile(*cached);
+		float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		ENGINE_INFO("[GltfIO::LoadMeshCached] {} mesh {} loaded from the cache in {:.1f} ms", path, meshIndex, milliseconds);
+		return mesh;
 	}
 
-	return mesh;
+	GltfModel gltf = LoadModel(path);
+	MeshFileData data;
+	if (!ImportMesh(gltf, meshIndex, data, settings))
+		return nullptr;
+	MeshCache::Store(key, data);
+
+	float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	ENGINE_INFO("[GltfIO::LoadMeshCached] {} mesh {} imported in {:.1f} ms", path, meshIndex, milliseconds);
+	return Mesh::Utils::FromMeshFileData(data);
 }
 
 int GetTinyGLTFComponentType(LType type) {
@@ -177,8 +554,73 @@ int GetTinyGLTFDrawMode(DrawMode mode) {
 	}
 }
 
+namespace {
+	// The core glTF attribute a stored component is written as, there is no half float component type and quantized
+	// positions or octahedral directions need KHR_mesh_quantization. Count is 0 when the component cannot be written.
+	VertexComponent exportComponent(const VertexComponent& component, const VertexDecoding& decoding) {
+		VertexComponent exported = component;
+		if (component.Name == "POSITION")
+			exported = { component.Name, LType::Float, 3 };
+		else if (decoding.octahedralNormals && component.Name == "NORMAL")
+			exported = { component.Name, LType::Float, 3 };
+		else if (decoding.octahedralNormals && component.Name == "TANGENT")
+			exported = { component.Name, LType::Float, 4 };
+		else if (component.Type == LType::HalfFloat)
+			exported = { component.Name, LType::Float, component.Count };
+
+		if (GetTinyGLTFComponentType(exported.Type) < 0 || GetTinyGLTFType(exported.Count) < 0)
+			exported.Count = 0;
+		return exported;
+	}
+
+	// Normalized integers are mapped the way GL reads them
+	template<typename T>
+	float readValue(const uint8_t* data, bool normalized) {
+		T value;
+		std::memcpy(&value, data, sizeof(value));
+		if (!normalized)
+			return (float)value;
+		return std::max((float)value / (float)std::numeric_limits<T>::max(), -1.0f);
+	}
+
+	glm::vec4 readComponent(const uint8_t* data, const VertexComponent& component) {
+		glm::vec4 values(0.0f);
+		for (uint32_t i = 0; i < std::min(component.Count, 4u); i++) {
+			const uint8_t* value = data + i * GetLTypeSize(component.Type);
+			switch (component.Type) {
+			case LType::Float: values[i] = readValue<float>(value, false); break;
+			case LType::HalfFloat: values[i] = glm::unpackHalf1x16((uint16_t)readValue<uint16_t>(value, false)); break;
+			case LType::Byte: values[i] = readValue<int8_t>(value, component.Normalized); break;
+			case LType::UnsignedByte: values[i] = readValue<uint8_t>(value, component.Normalized); break;
+			case LType::Short: values[i] = readValue<int16_t>(value, component.Normalized); break;
+			case LType::UnsignedShort: values[i] = readValue<uint16_t>(value, component.Normalized); break;
+			case LType::Int: values[i] = readValue<int32_t>(value, component.Normalized); break;
+			case LType::UnsignedInt: values[i] = readValue<uint32_t>(value, component.Normalized); break;
+			}
+		}
+		return values;
+	}
+
+	glm::vec3 octahedralDecode(const glm::vec2& octahedron) {
+		glm::vec3 direction(octahedron.x, octahedron.y, 1.0f - std::abs(octahedron.x) - std::abs(octahedron.y));
+		if (direction.z < 0.0f) {
+			direction.x = (1.0f - std::abs(octahedron.y)) * (octahedron.x >= 0.0f ? 1.0f : -1.0f);
+			direction.y = (1.0f - std::abs(octahedron.x)) * (octahedron.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return glm::normalize(direction);
+	}
+}
+
 void GltfIO::ExportMeshToGltf(const Mesh& mesh, const std::string& path) {
-	tinygltf::Model model;
+	if (auto gltfExport = ExportMeshToGltfAsync(mesh, path))
+		gltfExport->Wait();
+}
+
+std::shared_ptr<GltfExport> GltfIO::ExportMeshToGltfAsync(const Mesh& mesh, const std::string& path) {
+	auto gltfExport = std::make_shared<GltfExport>();
+	gltfExport->_path = path;
+
+	tinygltf::Model& model = gltfExport->_model;
 	tinygltf::Asset& asset = model.asset;
 	asset.version = "2.0";
 	asset.generator = "Mesh to GLTF Exporter";
@@ -187,56 +629,87 @@ void GltfIO::ExportMeshToGltf(const Mesh& mesh, const std::string& path) {
 		const VertexArrayObject& vao = mesh.GetSubmesh(i);
 		tinygltf::Primitive primitive;
 
-		// Vertex Buffers
+		const VertexDecoding& decoding = vao.GetVertexDecoding();
+
+		// Vertex Buffers, one buffer per vertex buffer with an accessor per interleaved component
 		for (uint32_t j = 0; j < vao.GetVertexBufferCount(); j++) {
 			const VertexBufferObject& vbo = vao.GetVertexBuffer(j);
 			const VertexLayout& layout = vbo.GetLayout();
 
-			tinygltf::Accessor accessor;
-			tinygltf::BufferView bufferView;
-			tinygltf::Buffer buffer;
+			GltfExport::VertexStream stream = { (uint32_t)model.buffers.size(), vao.ReadRawVertexDataAsync(j), layout, decoding, vao.GetVertexCount() };
+
+			uint32_t stride = 0;
+			uint32_t exportedCount = 0;
+			for (const auto& component : layout.GetComponents()) {
+				VertexComponent exported = exportComponent(component, decoding);
+				stride += exported.Count > 0 ? exported.GetByteSize() : 0;
+				exportedCount += exported.Count > 0 ? 1 : 0;
+			}
 
-			buffer.data = vbo.GetRawData();
+			tinygltf::BufferView bufferView;
 			bufferView.buffer = (uint32_t)model.buffers.size();
 			bufferView.byteOffset = 0;
-			bufferView.byteLength = (uint32_t)buffer.data.size();
-
-			for (const auto& component : layout.GetComponents()) {
-				accessor.componentType = GetTinyGLTFComponentType(component.Type);
-				accessor.count = vbo.GetCount();
-				accessor.type = GetTinyGLTFType(component.Count);
-				accessor.bufferView = (uint32_t)model.bufferViews.size();
-				accessor.byteOffset = 0;
+			bufferView.byteLength = (size_t)vao.GetVertexCount() * stride;
+			if (exportedCount > 1)
+				bufferView.byteStride = stride;
+			bufferView.target = TINYGLTF_TARGET_ARRAY_BUFFER;
 
-				model.accessors.emplace_back(accessor);
-				model.bufferViews.emplace_back(bufferView);
-				model.buffers.emplace_back(buffer);
+			model.buffers.emplace_back();
+			model.bufferViews.emplace_back(std::move(bufferView));
 
+			uint32_t offset = 0;
+			for (const auto& component : layout.GetComponents()) {
+				VertexComponent exported = exportComponent(component, decoding);
+				if (exported.Count == 0) {
+					ENGINE_WARN("[GltfIO::ExportMeshToGltfAsync] Attribute {} has no glTF component type, it is left out", component.Name);
+					continue;
+				}
+
+				tinygltf::Accessor accessor;
+				accessor.componentType = GetTinyGLTFComponentType(exported.Type);
+				accessor.normalized = exported.Normalized;
+				accessor.count = vao.GetVertexCount();
+				accessor.type = GetTinyGLTFType(exported.Count);
+				accessor.bufferView = (uint32_t)model.bufferViews.size() - 1;
+				accessor.byteOffset = offset;
+				offset += exported.GetByteSize();
+
+				model.accessors.emplace_back(std::move(accessor));
 				primitive.attributes[component.Name] = (uint32_t)model.accessors.size() - 1;
+				if (component.Name == "POSITION")
+					stream.positionAccessor = (int)model.accessors.size() - 1;
 			}
+
+			gltfExport->_vertexStreams.push_back(std::move(stream));
+		}
+
+		if (primitive.attributes.find("POSITION") == primitive.attributes.end()) {
+			ENGINE_ERROR("[GltfIO::ExportMeshToGltfAsync] Submesh {} has no POSITION that can be written, {} is not exported", i, path);
+			return nullptr;
 		}
 
 		// Index Buffer
 		if (vao.HasIndices()) {
 			const IndexBufferObject& ibo = vao.GetIndexBuffer();
+			gltfExport->_readbacks.push_back({ (uint32_t)model.buffers.size(), vao.ReadRawIndexDataAsync() });
+
 			tinygltf::Accessor accessor;
 			tinygltf::BufferView bufferView;
-			tinygltf::Buffer buffer;
 
-			buffer.data = ibo.GetRawData();
 			bufferView.buffer = (uint32_t)model.buffers.size();
 			bufferView.byteOffset = 0;
-			bufferView.byteLength = (uint32_t)buffer.data.size();
+			bufferView.byteLength = (size_t)vao.GetIndexCount() * GetLTypeSize(ibo.GetType());
+			bufferView.target = TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER;
 
 			accessor.componentType = GetTinyGLTFComponentType(ibo.GetType());
-			accessor.count = ibo.GetCount();
+			accessor.count = vao.GetIndexCount();
 			accessor.type = TINYGLTF_TYPE_SCALAR;
 			accessor.bufferView = (uint32_t)model.bufferViews.size();
 			accessor.byteOffset = 0;
 
 			model.accessors.emplace_back(std::move(accessor));
 			model.bufferViews.emplace_back(std::move(bufferView));
-			model.buffers.emplace_back(std::move(buffer));
+			model.buffers.emplace_back();
 
 			primitive.indices = (uint32_t)model.accessors.size() - 1;
 		}
@@ -246,8 +719,106 @@ void GltfIO::ExportMeshToGltf(const Mesh& mesh, const std::string& path) {
 		model.meshes.back().primitives.emplace_back(std::move(primitive));
 	}
 
+	return gltfExport;
+}
+
+bool GltfExport::Poll() {
+	if (_done)
+		return true;
+
+	for (auto& stream : _vertexStreams) {
+		if (!stream.readback->IsReady())
+			return false;
+	}
+	for (auto& [bufferIndex, readback] : _readbacks) {
+		if (!readback->IsReady())
+			return false;
+	}
+
+	write();
+	return true;
+}
+
+void GltfExport::Wait() {
+	if (_done)
+		return;
+
+	write();
+}
+
+void GltfExport::write() {
+	for (const auto& stream : _vertexStreams)
+		writeVertexStream(stream);
+	_vertexStreams.clear();
+	for (auto& [bufferIndex, readback] : _readbacks)
+		_model.buffers[bufferIndex].data = readback->GetData();
+	_readbacks.clear();
+
 	tinygltf::TinyGLTF writer;
-	writer.WriteGltfSceneToFile(&model, path, true, true, true, false);
+	if (!writer.WriteGltfSceneToFile(&_model, _path, true, true, true, false))
+		ENGINE_ERROR("[GltfExport::write] Failed to write {}", _path);
+	_done = true;
+}
+
+void GltfExport::writeVertexStream(const VertexStream& stream) {
+	const std::vector<uint8_t>& data = stream.readback->GetData();
+	const uint32_t sourceStride = stream.layout.GetStride();
+	const glm::mat4 positionTransform = stream.decoding.GetPositionTransform();
+
+	std::vector<VertexComponent> exported;
+	uint32_t stride = 0;
+	for (const auto& component : stream.layout.GetComponents()) {
+		exported.push_back(exportComponent(component, stream.decoding));
+		stride += exported.back().Count > 0 ? exported.back().GetByteSize() : 0;
+	}
+
+	glm::vec3 min(std::numeric_limits<float>::max());
+	glm::vec3 max(std::numeric_limits<float>::lowest());
+	uint32_t vertexCount = std::min<uint32_t>(stream.vertexCount, sourceStride > 0 ? (uint32_t)(data.size() / sourceStride) : 0);
+	std::vector<uint8_t>& out = _model.buffers[stream.buffer].data;
+	out.assign((size_t)stream.vertexCount * stride, 0);
+
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		const uint8_t* source = data.data() + (size_t)v * sourceStride;
+		uint8_t* target = out.data() + (size_t)v * stride;
+		for (size_t c = 0; c < exported.size(); c++) {
+			const VertexComponent& component = stream.layout.GetComponents()[c];
+			const uint32_t size = component.GetByteSize();
+			if (exported[c].Count == 0) {
+				source += size;
+				continue;
+			}
+
+			if (exported[c].Type == component.Type && exported[c].Count == component.Count && component.Name != "POSITION") {
+				std::memcpy(target, source, size);
+			}
+			else {
+				glm::vec4 values = readComponent(source, component);
+				if (component.Name == "POSITION") {
+					glm::vec3 position = glm::vec3(positionTransform * glm::vec4(glm::vec3(values), 1.0f));
+					min = glm::min(min, position);
+					max = glm::max(max, position);
+					values = glm::vec4(position, 0.0f);
+				}
+				else if (stream.decoding.octahedralNormals && component.Name == "NORMAL") {
+					values = glm::vec4(octahedralDecode({ values.x, values.y }), 0.0f);
+				}
+				else if (stream.decoding.octahedralNormals && component.Name == "TANGENT") {
+					values = glm::vec4(octahedralDecode({ values.x, values.y }), values.z < 0.0f ? -1.0f : 1.0f);
+				}
+				std::memcpy(target, &values[0], exported[c].GetByteSize());
+			}
+			source += size;
+			target += exported[c].GetByteSize();
+		}
+	}
+
+	// Required on POSITION by the spec
+	if (stream.positionAccessor >= 0 && vertexCount > 0) {
+		tinygltf::Accessor& accessor = _model.accessors[stream.positionAccessor];
+		accessor.minValues = { min.x, min.y, min.z };
+		accessor.maxValues = { max.x, max.y, max.z };
+	}
 }
 
 uint32_t GltfIO::getNumComponents(uint32_t type) {
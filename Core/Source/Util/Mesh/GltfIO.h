@@ -10,17 +10,107 @@
 #include "Rendering/Platform/Buffer/VertexArrayObject.h"
 #include "Rendering/Platform/Buffer/VertexBufferObject.h"
 #include "Rendering/Platform/Buffer/IndexBufferObject.h"
+#include "Rendering/Platform/Buffer/BufferReadback.h"
 
 #include "Rendering/Platform/Mesh.h"
+#include "Util/MappedFile.h"
 
 namespace Engine {
+	enum class VertexStreamLayout {
+		Interleaved,  // Every attribute in one vertex buffer
+		SplitPosition // Positions in a buffer of their own and the rest interleaved, so depth only passes fetch just the positions
+	};
+
+	// Positions are stored relative to the submesh bounds, the vertex array's VertexDecoding maps them back
+	enum class PositionEncoding {
+		Float,
+		Half,   // Half floats of the offset from the center
+		SNorm16 // The offset from the center divided by the half extent, 16 bits over the whole box on every axis
+	};
+
+	struct MeshImportSettings {
+		VertexStreamLayout streamLayout = VertexStreamLayout::Interleaved;
+		PositionEncoding positionEncoding = PositionEncoding::Float;
+		// Normals as two snorm16 and tangents as four snorm8, octahedral coordinates plus the tangent's handedness
+		bool octahedralNormals = false;
+		// Texture coordinates as unorm16, for every set that stays inside [0, 1]
+		bool unormTexCoords = false;
+		// Weld and reorder vertices and triangles with MeshOptimizer
+		bool optimize = true;
+
+		// Part of the MeshCache key
+		std::string GetKey() const;
+	};
+
+	// A parsed glTF whose buffers are left where they already are: the BIN chunk of a .glb and external .bin
+	// files stay memory mapped, only data URIs are decoded into model.buffers. Images are not loaded,
+	// textures go through their own assets.
+	struct GltfModel {
+		tinygltf::Model model;
+		std::vector<std::shared_ptr<MappedFile>> files;
+		std::vector<std::pair<const uint8_t*, uint64_t>> buffers; // Data and size of each of model.buffers
+
+		GltfModel() = default;
+		GltfModel(GltfModel&&) = default;
+		GltfModel& operator=(GltfModel&&) = default;
+		// The buffers point into the model's own data
+		GltfModel(const GltfModel&) = delete;
+		GltfModel& operator=(const GltfModel&) = delete;
+
+		// nullptr if the range is not inside the buffer
+		const uint8_t* GetBufferData(uint32_t buffer, uint64_t offset, uint64_t size) const;
+	};
+
+	// An export waiting for its buffers to come back from the GPU, the file is written by the Poll that sees the last one arrive
+	class GltfExport {
+	public:
+		// Returns true once the file has been written
+		bool Poll();
+		void Wait();
+		inline bool IsDone() const { return _done; }
+	private:
+		// A vertex buffer as it is stored on the GPU, rewritten to the core glTF attributes its accessors describe
+		struct VertexStream {
+			uint32_t buffer; // model buffer index
+			std::shared_ptr<BufferReadback> readback;
+			VertexLayout layout;
+			VertexDecoding decoding;
+			uint32_t vertexCount;
+			int positionAccessor = -1; // gets its min/max once the positions are decoded
+		};
+
+		void write();
+		void writeVertexStream(const VertexStream& stream);
+	private:
+		tinygltf::Model _model;
+		std::string _path;
+		std::vector<VertexStream> _vertexStreams;
+		std::vector<std::pair<uint32_t, std::shared_ptr<BufferReadback>>> _readbacks; // model buffer index, readback
+		bool _done = false;
+
+		friend class GltfIO;
+	};
+
 	class GltfIO {
 	public:
-		static tinygltf::Model LoadModel(const std::string& path);
-		static std::shared_ptr<VertexArrayObject> LoadPrimitive(const tinygltf::Model& model, const tinygltf::Primitive& primitive);
-		static std::shared_ptr<Mesh> LoadMesh(const tinygltf::Model& model, uint32_t meshIndex = 0);
+		// .gltf or .glb, an empty model if the file cannot be read
+		static GltfModel LoadModel(const std::string& path);
+		static std::shared_ptr<VertexArrayObject> LoadPrimitive(const GltfModel& gltf, const tinygltf::Primitive& primitive);
+		static std::shared_ptr<Mesh> LoadMesh(const GltfModel& gltf, uint32_t meshIndex = 0);
+		// Goes through the MeshCache, the model is only parsed when the source has changed since the last import
+		static std::shared_ptr<Mesh> LoadMeshCached(const std::string& path, uint32_t meshIndex = 0, const MeshImportSettings& settings = {});
+
+		// The CPU side of loading, without touching GL. Attributes are repacked into tightly interleaved streams
+		// with POSITION, NORMAL, TEXCOORD_0 and TANGENT first, in that order, so attribute locations stay the same
+		// no matter how the file lays them out. Primitives that fail to import are left out of the mesh.
+		static bool ImportPrimitive(const GltfModel& gltf, const tinygltf::Primitive& primitive, SubmeshData& submesh, const MeshImportSettings& settings = {});
+		static bool ImportMesh(const GltfModel& gltf, uint32_t meshIndex, MeshFileData& data, const MeshImportSettings& settings = {});
 
+		// Blocks until the mesh has been read back and written
 		static void ExportMeshToGltf(const Mesh& mesh, const std::string& path);
+		// Only queues the readbacks, poll the result from the render loop to finish the export without stalling.
+		// Quantized positions and octahedral normals are decoded back to floats, nullptr if a submesh has no POSITION to write.
+		static std::shared_ptr<GltfExport> ExportMeshToGltfAsync(const Mesh& mesh, const std::string& path);
 	private:
 		static uint32_t getNumComponents(uint32_t type);
 		static uint32_t getComponentByteSize(uint32_t componentType);
@@ -0,0 +1,40 @@
+#include "MeshCache.h"
+
+#include <filesystem>
+
+#include "Logging/Logging.h"
+#include "Util/CacheKey.h"
+
+using namespace Engine;
+
+namespace {
+	// Bump whenever the import changes so old entries are rebuilt
+	const uint32_t CACHE_VERSION = 2;
+}
+
+std::string MeshCache::_directory = ".cache/meshes";
+
+std::string MeshCache::MakeKey(const std::string& sourcePath, const std::string& settings) {
+	// Entries written with an older file layout are rebuilt too
+	return CacheKey::Make(sourcePath, settings + "|" + std::to_string(MeshFile::VERSION), CACHE_VERSION);
+}
+
+std::shared_ptr<MeshFile> MeshCache::Load(const std::string& key) {
+	if (key.empty() || !std::filesystem::exists(getPath(key)))
+		return nullptr;
+
+	auto file = MeshFile::Open(getPath(key));
+	if (!file)
+		ENGINE_WARN("[MeshCache::Load] Ignoring invalid cache entry {}", key);
+	return file;
+}
+
+bool MeshCache::Store(const std::string& key, const MeshFileData& data) {
+	if (key.empty())
+		return false;
+	return MeshFile::Write(getPath(key), data);
+}
+
+std::string MeshCache::getPath(const std::string& key) {
+	return (std::filesystem::path(_directory) / (key + ".emesh")).string();
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <memory>
+#include <string>
+
+#include "MeshFile.h"
+
+namespace Engine {
+	// Imported meshes kept on disk as mesh files between runs, so each source model is only parsed and
+	// converted once. Keyed like the TextureCache on the source file's path, size and modification time
+	// along with the import settings.
+	class MeshCache {
+	public:
+		static void SetDirectory(const std::string& directory) { _directory = directory; }
+		static const std::string& GetDirectory() { return _directory; }
+
+		// Empty if the source file does not exist
+		static std::string MakeKey(const std::string& sourcePath, const std::string& settings);
+
+		// Mapped rather than read, nullptr on a miss
+		static std::shared_ptr<MeshFile> Load(const std::string& key);
+		static bool Store(const std::string& key, const MeshFileData& data);
+	private:
+		static std::string getPath(const std::string& key);
+	private:
+		static std::string _directory;
+	};
+}
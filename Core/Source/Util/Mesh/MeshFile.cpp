@@ -0,0 +1,301 @@
+#include "MeshFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "Logging/Logging.h"
+
+using namespace Engine;
+
+namespace {
+	const uint32_t MESH_MAGIC = 0x48534D45; // "EMSH"
+	const uint64_t DATA_ALIGNMENT = 16;
+
+	struct FileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t submeshCount;
+		uint32_t streamCount;
+		uint32_t componentCount;
+		uint32_t reserved;
+	};
+
+	struct FileSubmesh {
+		uint32_t drawMode;
+		uint32_t indexType;
+		uint32_t indexCount;
+		uint32_t firstStream;
+		uint32_t streamCount;
+		uint32_t hasBounds;
+		float boundsMin[3];
+		float boundsMax[3];
+		uint32_t decodingFlags;
+		float positionScale[3];
+		float positionOffset[3];
+		uint32_t reserved;
+		uint64_t indexOffset;
+	};
+
+	struct FileStream {
+		uint32_t vertexCount;
+		uint32_t firstComponent;
+		uint32_t componentCount;
+		uint32_t stride;
+		uint64_t offset;
+	};
+
+	struct FileComponent {
+		char name[32];
+		uint32_t type;
+		uint32_t count;
+		uint32_t normalized;
+	};
+
+	uint64_t align(uint64_t offset) {
+		return (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+	}
+
+	const uint32_t DECODE_OCTAHEDRAL_NORMALS = 1 << 0;
+
+	bool isIndexType(uint32_t type) {
+		return type == (uint32_t)LType::UnsignedByte || type == (uint32_t)LType::UnsignedShort || type == (uint32_t)LType::UnsignedInt;
+	}
+}
+
+SubmeshView SubmeshData::GetView() const {
+	SubmeshView view;
+	for (const auto& stream : streams)
+		view.streams.push_back({ stream.layout, stream.vertexCount, stream.data.data() });
+	view.indexType = indexType;
+	view.indexCount = indexCount;
+	view.indices = indices.empty() ? nullptr : indices.data();
+	view.drawMode = drawMode;
+	view.bounds = bounds;
+	view.decoding = decoding;
+	return view;
+}
+
+std::shared_ptr<MeshFile> MeshFile::Open(const std::string& path) {
+	auto file = std::make_shared<MeshFile>();
+	if (!file->_file.Open(path))
+		return nullptr;
+	if (!file->parse(path))
+		return nullptr;
+	return file;
+}
+
+bool MeshFile::parse(const std::string& path) {
+	const uint8_t* data = _file.GetData();
+	uint64_t size = _file.GetSize();
+
+	FileHeader header;
+	if (size < sizeof(header)) {
+		ENGINE_ERROR("[MeshFile::parse] '{}' is truncated", path);
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (header.magic != MESH_MAGIC) {
+		ENGINE_ERROR("[MeshFile::parse] '{}' is not a mesh file", path);
+		return false;
+	}
+	if (header.version != VERSION) {
+		ENGINE_WARN("[MeshFile::parse] '{}' is version {}, expected {}", path, header.version, VERSION);
+		return false;
+	}
+
+	uint64_t submeshTable = sizeof(FileHeader);
+	uint64_t streamTable = submeshTable + (uint64_t)header.submeshCount * sizeof(FileSubmesh);
+	uint64_t componentTable = streamTable + (uint64_t)header.streamCount * sizeof(FileStream);
+	if (componentTable + (uint64_t)header.componentCount * sizeof(FileComponent) > size) {
+		ENGINE_ERROR("[MeshFile::parse] '{}' is truncated", path);
+		return false;
+	}
+
+	std::vector<FileStream> streams(header.streamCount);
+	std::vector<FileComponent> components(header.componentCount);
+	if (header.streamCount > 0)
+		std::memcpy(streams.data(), data + streamTable, streams.size() * sizeof(FileStream));
+	if (header.componentCount > 0)
+		std::memcpy(components.data(), data + componentTable, components.size() * sizeof(FileComponent));
+
+	_submeshes.clear();
+	for (uint32_t i = 0; i < header.submeshCount; i++) {
+		FileSubmesh submesh;
+		std::memcpy(&submesh, data + submeshTable + i * sizeof(FileSubmesh), sizeof(submesh));
+		if ((uint64_t)submesh.firstStream + submesh.streamCount > header.streamCount || submesh.drawMode > (uint32_t)DrawMode::TriangleFan) {
+			ENGINE_ERROR("[MeshFile::parse] Submesh {} of '{}' is invalid", i, path);
+			return false;
+		}
+
+		SubmeshView view;
+		view.drawMode = (DrawMode)submesh.drawMode;
+		if (submesh.hasBounds)
+			view.bounds = BoundingBox({ submesh.boundsMin[0], submesh.boundsMin[1], submesh.boundsMin[2] },
+				{ submesh.boundsMax[0], submesh.boundsMax[1], submesh.boundsMax[2] });
+		view.decoding.positionScale = { submesh.positionScale[0], submesh.positionScale[1], submesh.positionScale[2] };
+		view.decoding.positionOffset = { submesh.positionOffset[0], submesh.positionOffset[1], submesh.positionOffset[2] };
+		view.decoding.octahedralNormals = (submesh.decodingFlags & DECODE_OCTAHEDRAL_NORMALS) != 0;
+
+		if (submesh.indexCount > 0) {
+			if (!isIndexType(submesh.indexType) || submesh.indexOffset + submesh.indexCount * GetLTypeSize((LType)submesh.indexType) > size) {
+				ENGINE_ERROR("[MeshFile::parse] Indices of submesh {} of '{}' are invalid", i, path);
+				return false;
+			}
+			view.indexType = (LType)submesh.indexType;
+			view.indexCount = submesh.indexCount;
+			view.indices = data + submesh.indexOffset;
+		}
+
+		for (uint32_t s = submesh.firstStream; s < submesh.firstStream + submesh.streamCount; s++) {
+			const FileStream& stream = streams[s];
+			if ((uint64_t)stream.firstComponent + stream.componentCount > header.componentCount) {
+				ENGINE_ERROR("[MeshFile::parse] Stream {} of '{}' is invalid", s, path);
+				return false;
+			}
+
+			SubmeshView::Stream viewStream;
+			for (uint32_t c = stream.firstComponent; c < stream.firstComponent + stream.componentCount; c++) {
+				const FileComponent& component = components[c];
+				char name[sizeof(component.name) + 1] = {};
+				std::memcpy(name, component.name, sizeof(component.name));
+				viewStream.layout.AddComponent({ name, (LType)component.type, component.count, 0, component.normalized != 0 });
+			}
+
+			if (viewStream.layout.GetStride() != stream.stride || stream.offset + (uint64_t)stream.vertexCount * stream.stride > size) {
+				ENGINE_ERROR("[MeshFile::parse] Stream {} of '{}' does not match its layout or lies outside the file", s, path);
+				return false;
+			}
+			viewStream.vertexCount = stream.vertexCount;
+			viewStream.data = data + stream.offset;
+			view.streams.push_back(std::move(viewStream));
+		}
+
+		_submeshes.push_back(std::move(view));
+	}
+
+	return true;
+}
+
+bool MeshFile::Write(const std::string& path, const MeshFileData& data) {
+	FileHeader header = {};
+	header.magic = MESH_MAGIC;
+	header.version = VERSION;
+	header.submeshCount = (uint32_t)data.submeshes.size();
+
+	std::vector<FileSubmesh> submeshes;
+	std::vector<FileStream> streams;
+	std::vector<FileComponent> components;
+	std::vector<std::pair<uint64_t, const std::vector<uint8_t>*>> blobs; // File offset, data
+
+	for (const auto& submesh : data.submeshes) {
+		header.streamCount += (uint32_t)submesh.streams.size();
+		for (const auto& stream : submesh.streams)
+			header.componentCount += (uint32_t)stream.layout.GetComponents().size();
+	}
+
+	uint64_t offset = align(sizeof(FileHeader) + header.submeshCount * sizeof(FileSubmesh) +
+		header.streamCount * sizeof(FileStream) + header.componentCount * sizeof(FileComponent));
+
+	for (const auto& submesh : data.submeshes) {
+		FileSubmesh fileSubmesh = {};
+		fileSubmesh.drawMode = (uint32_t)submesh.drawMode;
+		fileSubmesh.indexType = (uint32_t)submesh.indexType;
+		fileSubmesh.indexCount = submesh.indexCount;
+		fileSubmesh.firstStream = (uint32_t)streams.size();
+		fileSubmesh.streamCount = (uint32_t)submesh.streams.size();
+		fileSubmesh.hasBounds = submesh.bounds.IsValid() ? 1 : 0;
+		if (fileSubmesh.hasBounds) {
+			for (int axis = 0; axis < 3; axis++) {
+				fileSubmesh.boundsMin[axis] = submesh.bounds.min[axis];
+				fileSubmesh.boundsMax[axis] = submesh.bounds.max[axis];
+			}
+		}
+		fileSubmesh.decodingFlags = submesh.decoding.octahedralNormals ? DECODE_OCTAHEDRAL_NORMALS : 0;
+		for (int axis = 0; axis < 3; axis++) {
+			fileSubmesh.positionScale[axis] = submesh.decoding.positionScale[axis];
+			fileSubmesh.positionOffset[axis] = submesh.decoding.positionOffset[axis];
+		}
+
+		if (submesh.indexCount > 0) {
+			if (submesh.indices.size() != submesh.indexCount * GetLTypeSize(submesh.indexType)) {
+				ENGINE_ERROR("[MeshFile::Write] Expected {} indices, got {} bytes", submesh.indexCount, submesh.indices.size());
+				return false;
+			}
+			fileSubmesh.indexOffset = offset;
+			blobs.push_back({ offset, &submesh.indices });
+			offset = align(offset + submesh.indices.size());
+		}
+
+		for (const auto& stream : submesh.streams) {
+			FileStream fileStream = {};
+			fileStream.vertexCount = stream.vertexCount;
+			fileStream.firstComponent = (uint32_t)components.size();
+			fileStream.componentCount = (uint32_t)stream.layout.GetComponents().size();
+			fileStream.stride = stream.layout.GetStride();
+			if (stream.data.size() != (uint64_t)stream.vertexCount * fileStream.stride) {
+				ENGINE_ERROR("[MeshFile::Write] Expected {} vertices of {} bytes, got {} bytes", stream.vertexCount, fileStream.stride, stream.data.size());
+				return false;
+			}
+
+			for (const auto& component : stream.layout.GetComponents()) {
+				FileComponent fileComponent = {};
+				if (component.Name.size() >= sizeof(fileComponent.name)) {
+					ENGINE_ERROR("[MeshFile::Write] Attribute name '{}' is too long", component.Name);
+					return false;
+				}
+				std::memcpy(fileComponent.name, component.Name.data(), component.Name.size());
+				fileComponent.type = (uint32_t)component.Type;
+				fileComponent.count = component.Count;
+				fileComponent.normalized = component.Normalized ? 1 : 0;
+				components.push_back(fileComponent);
+			}
+
+			fileStream.offset = offset;
+			blobs.push_back({ offset, &stream.data });
+			offset = align(offset + stream.data.size());
+			streams.push_back(fileStream);
+		}
+
+		submeshes.push_back(fileSubmesh);
+	}
+
+	std::error_code error;
+	std::filesystem::path parent = std::filesystem::path(path).parent_path();
+	if (!parent.empty())
+		std::filesystem::create_directories(parent, error);
+
+	// Same as TextureFile::WriteKTX2, never leave a partial file behind
+	std::string temporaryPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			ENGINE_ERROR("[MeshFile::Write] Could not write to {}", temporaryPath);
+			return false;
+		}
+
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)submeshes.data(), submeshes.size() * sizeof(FileSubmesh));
+		file.write((const char*)streams.data(), streams.size() * sizeof(FileStream));
+		file.write((const char*)components.data(), components.size() * sizeof(FileComponent));
+
+		for (const auto& [blobOffset, blob] : blobs) {
+			static const char padding[DATA_ALIGNMENT] = {};
+			file.write(padding, blobOffset - (uint64_t)file.tellp());
+			file.write((const char*)blob->data(), blob->size());
+		}
+
+		if (!file) {
+			ENGINE_ERROR("[MeshFile::Write] Failed writing {}", temporaryPath);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error) {
+		ENGINE_ERROR("[MeshFile::Write] Could not move {} into place: {}", temporaryPath, error.message());
+		return false;
+	}
+	return true;
+}
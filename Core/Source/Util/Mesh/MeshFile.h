@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Rendering/Platform/Buffer/VertexArrayObject.h"
+#include "Rendering/Platform/Buffer/VertexBufferObject.h"
+#include "Util/Math/BoundingBox.h"
+#include "Util/MappedFile.h"
+
+namespace Engine {
+	// Where one submesh's data lies, inside a MeshFile's mapping or a MeshFileData
+	struct SubmeshView {
+		struct Stream {
+			VertexLayout layout;
+			uint32_t vertexCount = 0;
+			const uint8_t* data = nullptr; // vertexCount * layout stride bytes
+		};
+
+		std::vector<Stream> streams;
+		LType indexType = LType::UnsignedInt;
+		uint32_t indexCount = 0; // 0 draws the vertices in order
+		const uint8_t* indices = nullptr;
+		DrawMode drawMode = DrawMode::Triangles;
+		BoundingBox bounds; // Invalid if unknown
+		VertexDecoding decoding;
+	};
+
+	struct VertexStreamData {
+		VertexLayout layout;
+		uint32_t vertexCount = 0;
+		std::vector<uint8_t> data;
+	};
+
+	struct SubmeshData {
+		std::vector<VertexStreamData> streams;
+		LType indexType = LType::UnsignedInt;
+		uint32_t indexCount = 0;
+		std::vector<uint8_t> indices;
+		DrawMode drawMode = DrawMode::Triangles;
+		BoundingBox bounds;
+		VertexDecoding decoding;
+
+		SubmeshView GetView() const;
+	};
+
+	struct MeshFileData {
+		std::vector<SubmeshData> submeshes;
+	};
+
+	// The engine's own mesh format, a table of submeshes and their vertex layouts followed by the vertex
+	// and index data exactly as it is uploaded. Mapped into memory so loading is a validation of the tables
+	// and one upload per buffer.
+	class MeshFile {
+	public:
+		// Bump whenever the layout of the file changes, older files are rejected
+		static const uint32_t VERSION = 2;
+
+		// nullptr if the file is not a valid mesh file of the current version
+		static std::shared_ptr<MeshFile> Open(const std::string& path);
+		static bool Write(const std::string& path, const MeshFileData& data);
+
+		inline uint32_t GetSubmeshCount() const { return (uint32_t)_submeshes.size(); }
+		inline const SubmeshView& GetSubmesh(uint32_t index) const { return _submeshes[index]; }
+	private:
+		bool parse(const std::string& path);
+	private:
+		MappedFile _file;
+		std::vector<SubmeshView> _submeshes;
+	};
+}
@@ -0,0 +1,506 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+#include <glm/gtc/packing.hpp>
+
+#include "Logging/Logging.h"
+
+using namespace Engine;
+
+namespace {
+	const uint32_t NO_VERTEX = ~0u;
+
+	// Forsyth's scoring: vertices near the front of the cache and vertices with few triangles left score higher
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	float vertexScore(int32_t cachePosition, uint32_t remainingTriangles) {
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			// The last triangle's vertices get a fixed score, otherwise the next triangle would just reuse them
+			if (cachePosition < 3)
+				score = LAST_TRIANGLE_SCORE;
+			else
+				score = std::pow(1.0f - (float)(cachePosition - 3) / (MeshOptimizer::VERTEX_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+		return score + VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+	}
+
+	// A vertex is a hit if fewer than size misses happened since it was loaded
+	struct FifoCache {
+		std::vector<uint32_t> loadedAt;
+		uint32_t size;
+		uint32_t time;
+
+		FifoCache(uint32_t vertexCount, uint32_t cacheSize)
+			: loadedAt(vertexCount, 0), size(cacheSize), time(cacheSize + 1) {}
+
+		// Returns 1 on a miss
+		uint32_t Access(uint32_t vertex) {
+			if (time - loadedAt[vertex] <= size)
+				return 0;
+			loadedAt[vertex] = time++;
+			return 1;
+		}
+
+		void Flush() { time += size; }
+	};
+
+	uint32_t countMisses(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+		FifoCache cache(vertexCount, cacheSize);
+		uint32_t misses = 0;
+		for (uint32_t index : indices)
+			misses += cache.Access(index);
+		return misses;
+	}
+
+	bool readIndices(const SubmeshData& submesh, std::vector<uint32_t>& indices) {
+		size_t indexSize = GetLTypeSize(submesh.indexType);
+		if (indexSize == 0 || submesh.indices.size() != submesh.indexCount * indexSize)
+			return false;
+
+		indices.resize(submesh.indexCount);
+		const uint8_t* data = submesh.indices.data();
+		for (uint32_t i = 0; i < submesh.indexCount; i++) {
+			switch (submesh.indexType) {
+			case LType::UnsignedByte:
+				indices[i] = data[i];
+				break;
+			case LType::UnsignedShort: {
+				uint16_t index;
+				std::memcpy(&index, data + i * sizeof(uint16_t), sizeof(uint16_t));
+				indices[i] = index;
+				break;
+			}
+			case LType::UnsignedInt:
+				std::memcpy(&indices[i], data + i * sizeof(uint32_t), sizeof(uint32_t));
+				break;
+			default:
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void writeIndices(SubmeshData& submesh, const std::vector<uint32_t>& indices, uint32_t vertexCount) {
+		// 0xFFFF is left alone in case primitive restart is ever turned on
+		submesh.indexCount = (uint32_t)indices.size();
+		if (vertexCount <= 0xFFFF) {
+			submesh.indexType = LType::UnsignedShort;
+			submesh.indices.resize(indices.size() * sizeof(uint16_t));
+			for (size_t i = 0; i < indices.size(); i++) {
+				uint16_t index = (uint16_t)indices[i];
+				std::memcpy(submesh.indices.data() + i * sizeof(uint16_t), &index, sizeof(uint16_t));
+			}
+		}
+		else {
+			submesh.indexType = LType::UnsignedInt;
+			submesh.indices.resize(indices.size() * sizeof(uint32_t));
+			std::memcpy(submesh.indices.data(), indices.data(), submesh.indices.size());
+		}
+	}
+
+	// Moves every vertex to remap[vertex] in each stream, NO_VERTEX drops it
+	void remapVertices(SubmeshData& submesh, const std::vector<uint32_t>& remap, uint32_t vertexCount) {
+		for (auto& stream : submesh.streams) {
+			uint32_t stride = stream.layout.GetStride();
+			std::vector<uint8_t> data((size_t)vertexCount * stride);
+			for (uint32_t vertex = 0; vertex < stream.vertexCount; vertex++) {
+				if (remap[vertex] != NO_VERTEX)
+					std::memcpy(data.data() + (size_t)remap[vertex] * stride, stream.data.data() + (size_t)vertex * stride, stride);
+			}
+			stream.data = std::move(data);
+			stream.vertexCount = vertexCount;
+		}
+	}
+
+	// Local space positions, false if the submesh has none in a format read here
+	bool readPositions(const SubmeshData& submesh, std::vector<glm::vec3>& positions) {
+		for (const auto& stream : submesh.streams) {
+			uint32_t offset = 0;
+			for (const auto& component : stream.layout.GetComponents()) {
+				if (component.Name != "POSITION") {
+					offset += component.GetByteSize();
+					continue;
+				}
+
+				bool readable = component.Count >= 3 && (component.Type == LType::Float || component.Type == LType::HalfFloat
+					|| (component.Type == LType::Short && component.Normalized));
+				if (!readable)
+					return false;
+
+				uint32_t stride = stream.layout.GetStride();
+				glm::mat4 transform = submesh.decoding.GetPositionTransform();
+				positions.resize(stream.vertexCount);
+				for (uint32_t vertex = 0; vertex < stream.vertexCount; vertex++) {
+					const uint8_t* element = stream.data.data() + (size_t)vertex * stride + offset;
+					glm::vec3 position;
+					for (int axis = 0; axis < 3; axis++) {
+						if (component.Type == LType::Float) {
+							std::memcpy(&position[axis], element + axis * sizeof(float), sizeof(float));
+						}
+						else if (component.Type == LType::HalfFloat) {
+							uint16_t half;
+							std::memcpy(&half, element + axis * sizeof(uint16_t), sizeof(uint16_t));
+							position[axis] = glm::unpackHalf1x16(half);
+						}
+						else {
+							int16_t snorm;
+							std::memcpy(&snorm, element + axis * sizeof(int16_t), sizeof(int16_t));
+							position[axis] = std::max(snorm / 32767.0f, -1.0f);
+						}
+					}
+					positions[vertex] = glm::vec3(transform * glm::vec4(position, 1.0f));
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+bool MeshOptimizer::Optimize(SubmeshData& submesh, MeshOptimizerStats& stats) {
+	if (submesh.drawMode != DrawMode::Triangles || submesh.streams.empty())
+		return false;
+
+	uint32_t vertexCount = submesh.streams[0].vertexCount;
+	for (const auto& stream : submesh.streams) {
+		if (stream.vertexCount != vertexCount)
+			return false;
+	}
+
+	// Plain triangle lists get indices, welding is what makes them worth having
+	std::vector<uint32_t> indices;
+	if (submesh.indexCount > 0) {
+		if (!readIndices(submesh, indices))
+			return false;
+	}
+	else {
+		indices.resize(vertexCount);
+		std::iota(indices.begin(), indices.end(), 0);
+	}
+
+	if (indices.empty() || indices.size() % 3 != 0) {
+		ENGINE_WARN("[MeshOptimizer::Optimize] {} indices is not a triangle list", indices.size());
+		return false;
+	}
+	for (uint32_t index : indices) {
+		if (index >= vertexCount) {
+			ENGINE_WARN("[MeshOptimizer::Optimize] Index {} is out of range of {} vertices", index, vertexCount);
+			return false;
+		}
+	}
+
+	stats.verticesBefore = vertexCount;
+	stats.acmrBefore = ComputeACMR(indices, vertexCount);
+	stats.atvrBefore = ComputeATVR(indices, vertexCount);
+
+	std::vector<uint32_t> remap;
+	uint32_t weldedCount = WeldVertices(submesh, remap);
+	if (weldedCount < vertexCount) {
+		for (uint32_t& index : indices)
+			index = remap[index];
+		remapVertices(submesh, remap, weldedCount);
+		vertexCount = weldedCount;
+	}
+
+	OptimizeVertexCache(indices, vertexCount);
+
+	std::vector<glm::vec3> positions;
+	stats.clusters = readPositions(submesh, positions) ? OptimizeOverdraw(indices, positions) : 0;
+
+	vertexCount = OptimizeVertexFetch(indices, vertexCount, remap);
+	remapVertices(submesh, remap, vertexCount);
+	writeIndices(submesh, indices, vertexCount);
+
+	stats.verticesAfter = vertexCount;
+	stats.acmrAfter = ComputeACMR(indices, vertexCount);
+	stats.atvrAfter = ComputeATVR(indices, vertexCount);
+	return true;
+}
+
+uint32_t MeshOptimizer::WeldVertices(const SubmeshData& submesh, std::vector<uint32_t>& remap) {
+	uint32_t vertexCount = submesh.streams.empty() ? 0 : submesh.streams[0].vertexCount;
+
+	// Vertices are keyed by index and compared by their bytes in every stream
+	auto hash = [&](uint32_t vertex) {
+		uint64_t value = 14695981039346656037ull;
+		for (const auto& stream : submesh.streams) {
+			uint32_t stride = stream.layout.GetStride();
+			const uint8_t* bytes = stream.data.data() + (size_t)vertex * stride;
+			for (uint32_t i = 0; i < stride; i++)
+				value = (value ^ bytes[i]) * 1099511628211ull;
+		}
+		return (size_t)value;
+	};
+	auto equal = [&](uint32_t a, uint32_t b) {
+		for (const auto& stream : submesh.streams) {
+			uint32_t stride = stream.layout.GetStride();
+			if (std::memcmp(stream.data.data() + (size_t)a * stride, stream.data.data() + (size_t)b * stride, stride) != 0)
+				return false;
+		}
+		return true;
+	};
+
+	std::unordered_map<uint32_t, uint32_t, decltype(hash), decltype(equal)> unique(vertexCount, hash, equal);
+	remap.resize(vertexCount);
+	uint32_t count = 0;
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+		auto [it, inserted] = unique.emplace(vertex, count);
+		if (inserted)
+			count++;
+		remap[vertex] = it->second;
+	}
+	return count;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount) {
+	uint32_t triangleCount = (uint32_t)indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles of every vertex, the first remaining[vertex] of its range are the ones not emitted yet
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (uint32_t index : indices)
+		remaining[index]++;
+
+	std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		firstTriangle[vertex + 1] = firstTriangle[vertex] + remaining[vertex];
+
+	std::vector<uint32_t> vertexTriangles(indices.size());
+	std::vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+	for (uint32_t i = 0; i < (uint32_t)indices.size(); i++)
+		vertexTriangles[fill[indices[i]]++] = i / 3;
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		vertexScores[vertex] = vertexScore(-1, remaining[vertex]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	uint32_t bestTriangle = 0;
+	for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+		const uint32_t* vertices = &indices[triangle * 3];
+		triangleScores[triangle] = vertexScores[vertices[0]] + vertexScores[vertices[1]] + vertexScores[vertices[2]];
+		if (triangleScores[triangle] > triangleScores[bestTriangle])
+			bestTriangle = triangle;
+	}
+
+	std::vector<uint32_t> cache, nextCache;
+	cache.reserve(VERTEX_CACHE_SIZE + 3);
+	nextCache.reserve(VERTEX_CACHE_SIZE + 3);
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	uint32_t deadEndCursor = 0;
+
+	while (output.size() < indices.size()) {
+		// Nothing in the cache has triangles left, carry on with the first triangle of the input that is left
+		if (bestTriangle == NO_VERTEX) {
+			while (emitted[deadEndCursor])
+				deadEndCursor++;
+			bestTriangle = deadEndCursor;
+		}
+
+		const uint32_t* vertices = &indices[bestTriangle * 3];
+		emitted[bestTriangle] = true;
+		output.insert(output.end(), vertices, vertices + 3);
+
+		for (int k = 0; k < 3; k++) {
+			uint32_t vertex = vertices[k];
+			uint32_t* triangles = &vertexTriangles[firstTriangle[vertex]];
+			for (uint32_t i = 0; i < remaining[vertex]; i++) {
+				if (triangles[i] == bestTriangle) {
+					std::swap(triangles[i], triangles[remaining[vertex] - 1]);
+					remaining[vertex]--;
+					break;
+				}
+			}
+		}
+
+		// The triangle's vertices go to the front, the rest shift back and the last ones fall out
+		nextCache.clear();
+		for (int k = 0; k < 3; k++) {
+			if (std::find(nextCache.begin(), nextCache.end(), vertices[k]) == nextCache.end())
+				nextCache.push_back(vertices[k]);
+		}
+		for (uint32_t vertex : cache) {
+			if (vertex != vertices[0] && vertex != vertices[1] && vertex != vertices[2])
+				nextCache.push_back(vertex);
+		}
+
+		for (uint32_t i = 0; i < (uint32_t)nextCache.size(); i++) {
+			uint32_t vertex = nextCache[i];
+			cachePositions[vertex] = i < VERTEX_CACHE_SIZE ? (int32_t)i : -1;
+			vertexScores[vertex] = vertexScore(cachePositions[vertex], remaining[vertex]);
+		}
+
+		// Only triangles touching the cache changed, the best of them is the next one
+		bestTriangle = NO_VERTEX;
+		float bestScore = -FLT_MAX;
+		for (uint32_t vertex : nextCache) {
+			const uint32_t* triangles = &vertexTriangles[firstTriangle[vertex]];
+			for (uint32_t i = 0; i < remaining[vertex]; i++) {
+				uint32_t triangle = triangles[i];
+				const uint32_t* triangleVertices = &indices[triangle * 3];
+				float score = vertexScores[triangleVertices[0]] + vertexScores[triangleVertices[1]] + vertexScores[triangleVertices[2]];
+				triangleScores[triangle] = score;
+				if (score > bestScore) {
+					bestScore = score;
+					bestTriangle = triangle;
+				}
+			}
+		}
+
+		if (nextCache.size() > VERTEX_CACHE_SIZE)
+			nextCache.resize(VERTEX_CACHE_SIZE);
+		cache.swap(nextCache);
+	}
+
+	indices.swap(output);
+}
+
+uint32_t MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, float threshold) {
+	uint32_t triangleCount = (uint32_t)indices.size() / 3;
+	if (triangleCount == 0)
+		return 0;
+
+	uint32_t vertexCount = (uint32_t)positions.size();
+	float cacheAcmr = ComputeACMR(indices, vertexCount);
+
+	// Hard boundaries are where the cache order starts over, with every vertex of the triangle missing
+	FifoCache cache(vertexCount, STATS_CACHE_SIZE);
+	std::vector<uint32_t> hardBoundaries;
+	for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+		uint32_t misses = cache.Access(indices[triangle * 3]) + cache.Access(indices[triangle * 3 + 1]) + cache.Access(indices[triangle * 3 + 2]);
+		if (triangle == 0 || misses == 3)
+			hardBoundaries.push_back(triangle);
+	}
+	hardBoundaries.push_back(triangleCount);
+
+	// Soft boundaries split those further wherever a cluster's ACMR has come down to within the threshold
+	// of what the whole run of triangles reaches, so the cache restart costs little
+	std::vector<uint32_t> clusterStarts;
+	for (uint32_t i = 0; i + 1 < (uint32_t)hardBoundaries.size(); i++) {
+		uint32_t start = hardBoundaries[i], end = hardBoundaries[i + 1];
+
+		cache.Flush();
+		uint32_t misses = 0;
+		for (uint32_t index = start * 3; index < end * 3; index++)
+			misses += cache.Access(indices[index]);
+		float targetAcmr = (float)misses / (end - start) * threshold;
+
+		cache.Flush();
+		clusterStarts.push_back(start);
+		uint32_t clusterStart = start, clusterMisses = 0;
+		for (uint32_t triangle = start; triangle < end; triangle++) {
+			for (int k = 0; k < 3; k++)
+				clusterMisses += cache.Access(indices[triangle * 3 + k]);
+
+			if (triangle + 1 < end && (float)clusterMisses / (triangle + 1 - clusterStart) <= targetAcmr) {
+				clusterStarts.push_back(triangle + 1);
+				clusterStart = triangle + 1;
+				clusterMisses = 0;
+				cache.Flush();
+			}
+		}
+
+		// Whatever is left at the end of the run never came down to the target, it goes back into the cluster before it
+		if (clusterStart != start && (float)clusterMisses / (end - clusterStart) > targetAcmr)
+			clusterStarts.pop_back();
+	}
+
+	auto triangleArea = [&](uint32_t triangle, glm::vec3& normal, glm::vec3& centroid) {
+		const glm::vec3& a = positions[indices[triangle * 3]];
+		const glm::vec3& b = positions[indices[triangle * 3 + 1]];
+		const glm::vec3& c = positions[indices[triangle * 3 + 2]];
+		normal = glm::cross(b - a, c - a);
+		centroid = (a + b + c) / 3.0f;
+		return glm::length(normal);
+	};
+
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+		glm::vec3 normal, centroid;
+		float area = triangleArea(triangle, normal, centroid);
+		meshCenter += centroid * area;
+		meshArea += area;
+	}
+	if (meshArea > 0.0f)
+		meshCenter /= meshArea;
+
+	// Clusters facing away from the center are on the outside of the mesh and likely to occlude the rest, they draw first
+	struct Cluster {
+		uint32_t start;
+		uint32_t end;
+		float order;
+	};
+	std::vector<Cluster> clusters;
+	clusterStarts.push_back(triangleCount);
+	for (uint32_t i = 0; i + 1 < (uint32_t)clusterStarts.size(); i++) {
+		glm::vec3 clusterNormal(0.0f), clusterCenter(0.0f);
+		float clusterArea = 0.0f;
+		for (uint32_t triangle = clusterStarts[i]; triangle < clusterStarts[i + 1]; triangle++) {
+			glm::vec3 normal, centroid;
+			float area = triangleArea(triangle, normal, centroid);
+			clusterNormal += normal;
+			clusterCenter += centroid * area;
+			clusterArea += area;
+		}
+
+		float order = 0.0f;
+		float normalLength = glm::length(clusterNormal);
+		if (clusterArea > 0.0f && normalLength > 0.0f)
+			order = glm::dot(clusterCenter / clusterArea - meshCenter, clusterNormal / normalLength);
+		clusters.push_back({ clusterStarts[i], clusterStarts[i + 1], order });
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+		return a.order > b.order;
+	});
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (const auto& cluster : clusters)
+		output.insert(output.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+
+	// Cluster boundaries only bound the cost per run, check the whole order still keeps to the budget
+	if (ComputeACMR(output, vertexCount) > cacheAcmr * threshold)
+		return 0;
+
+	indices.swap(output);
+	return (uint32_t)clusters.size();
+}
+
+uint32_t MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& remap) {
+	remap.assign(vertexCount, NO_VERTEX);
+	uint32_t count = 0;
+	for (uint32_t& index : indices) {
+		if (remap[index] == NO_VERTEX)
+			remap[index] = count++;
+		index = remap[index];
+	}
+	return count;
+}
+
+float MeshOptimizer::ComputeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+	uint32_t triangleCount = (uint32_t)indices.size() / 3;
+	return triangleCount > 0 ? (float)countMisses(indices, vertexCount, cacheSize) / triangleCount : 0.0f;
+}
+
+float MeshOptimizer::ComputeATVR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+	return vertexCount > 0 ? (float)countMisses(indices, vertexCount, cacheSize) / vertexCount : 0.0f;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "MeshFile.h"
+
+namespace Engine {
+	struct MeshOptimizerStats {
+		uint32_t verticesBefore = 0;
+		uint32_t verticesAfter = 0;
+		// Vertices transformed per triangle and per vertex, simulated with a FIFO cache of STATS_CACHE_SIZE entries
+		float acmrBefore = 0.0f;
+		float acmrAfter = 0.0f;
+		float atvrBefore = 0.0f;
+		float atvrAfter = 0.0f;
+		uint32_t clusters = 0; // Triangle groups reordered for overdraw, 0 if the cache order was kept
+	};
+
+	// Reorders a submesh's triangles and vertices for the GPU, meant to run once when a mesh is imported.
+	// Duplicate vertices are welded, triangles are ordered for the post transform cache (Forsyth) and then
+	// split into clusters drawn outside in to cut overdraw, and vertices end up in the order they are first
+	// used so that fetching them walks memory forwards.
+	class MeshOptimizer {
+	public:
+		static const uint32_t VERTEX_CACHE_SIZE = 32; // LRU size the triangle order is scored for
+		static const uint32_t STATS_CACHE_SIZE = 16;
+		// Clusters may raise the ACMR of their triangles by this factor
+		static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+		// Only indexed or plain triangle lists are changed, others return false and are left as they are.
+		// Indices end up 16 bit if the vertex count allows it, 32 bit otherwise.
+		static bool Optimize(SubmeshData& submesh, MeshOptimizerStats& stats);
+
+		// The steps Optimize runs, each works on 32 bit triangle list indices
+		// Returns the new vertex count, remap holds the surviving vertex of every input vertex
+		static uint32_t WeldVertices(const SubmeshData& submesh, std::vector<uint32_t>& remap);
+		static void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+		// Indices already in vertex cache order, returns the number of clusters. The order is kept and 0 returned
+		// if reordering would raise the ACMR by more than threshold.
+		static uint32_t OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, float threshold = OVERDRAW_THRESHOLD);
+		// Returns the new vertex count, unreferenced vertices are dropped and get a remap of ~0
+		static uint32_t OptimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& remap);
+
+		static float ComputeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = STATS_CACHE_SIZE);
+		static float ComputeATVR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = STATS_CACHE_SIZE);
+	};
+}
@@ -0,0 +1,90 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace Engine;
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	_workers.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; i++)
+		_workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_jobAvailable.notify_all();
+
+	for (auto& worker : _workers)
+		worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(std::move(job));
+	}
+	_jobAvailable.notify_one();
+}
+
+void ThreadPool::WaitIdle() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_idle.wait(lock, [this]() { return _jobs.empty() && _running == 0; });
+}
+
+void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& body) {
+	std::atomic<uint32_t> next = 0;
+	auto run = [&]() {
+		for (uint32_t i = next++; i < count; i = next++)
+			body(i);
+	};
+
+	uint32_t helpers = std::min(count, GetThreadCount());
+	uint32_t finished = 0;
+	std::mutex finishedMutex;
+	std::condition_variable allFinished;
+	for (uint32_t i = 0; i < helpers; i++) {
+		Submit([&]() {
+			run();
+			std::lock_guard<std::mutex> lock(finishedMutex);
+			if (++finished == helpers)
+				allFinished.notify_one();
+		});
+	}
+
+	run();
+	std::unique_lock<std::mutex> lock(finishedMutex);
+	allFinished.wait(lock, [&]() { return finished == helpers; });
+}
+
+uint32_t ThreadPool::GetPendingCount() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return (uint32_t)_jobs.size() + _running;
+}
+
+void ThreadPool::workerLoop() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_jobAvailable.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+		if (_jobs.empty())
+			return; // Only reached when stopping
+
+		auto job = std::move(_jobs.front());
+		_jobs.pop_front();
+		_running++;
+
+		lock.unlock();
+		job();
+		lock.lock();
+
+		_running--;
+		if (_jobs.empty() && _running == 0)
+			_idle.notify_all();
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+namespace Engine {
+	// Fixed set of worker threads running submitted jobs in order of submission
+	class ThreadPool {
+	public:
+		// 0 uses every hardware thread except the one submitting
+		ThreadPool(uint32_t threadCount = 0);
+		// Finishes the queued jobs before joining the workers
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void Submit(std::function<void()> job);
+		// Blocks until the queue is empty and no job is running
+		void WaitIdle();
+		// Calls body for every index in [0, count) across the workers and the calling thread, returns once all calls have
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& body);
+
+		inline uint32_t GetThreadCount() const { return (uint32_t)_workers.size(); }
+		uint32_t GetPendingCount();
+	private:
+		void workerLoop();
+	private:
+		std::vector<std::thread> _workers;
+		std::deque<std::function<void()>> _jobs;
+		std::mutex _mutex;
+		std::condition_variable _jobAvailable;
+		std::condition_variable _idle;
+		uint32_t _running = 0;
+		bool _stopping = false;
+	};
+}
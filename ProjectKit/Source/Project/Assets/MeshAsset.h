@@ -10,8 +10,7 @@ namespace Engine {
 		MeshAsset(AssetBank& assetBank) : Asset(assetBank, AssetType::Mesh), _meshIndex(0) {}
 
 		void Load() override {
-			auto model = GltfIO::LoadModel(_meshPath);
-			_internalMesh = GltfIO::LoadMesh(model, _meshIndex);
+			_internalMesh = GltfIO::LoadMeshCached(_meshPath, _meshIndex, _importSettings);
 			_loaded = true;
 		}
 
@@ -29,6 +28,13 @@ namespace Engine {
 			nlohmann::json data = Asset::Serialize();
 			data["meshPath"] = _meshPath;
 			data["meshIndex"] = _meshIndex;
+			data["importSettings"] = {
+				{ "streamLayout", _importSettings.streamLayout },
+				{ "positionEncoding", _importSettings.positionEncoding },
+				{ "octahedralNormals", _importSettings.octahedralNormals },
+				{ "unormTexCoords", _importSettings.unormTexCoords },
+				{ "optimize", _importSettings.optimize }
+			};
 			return data;
 		}
 
@@ -36,6 +42,15 @@ namespace Engine {
 			Asset::Deserialize(data);
 			_meshPath = data["meshPath"].get<std::string>();
 			_meshIndex = data["meshIndex"].get<uint32_t>();
+
+			// Assets saved before the settings existed import with the defaults
+			MeshImportSettings defaults;
+			const nlohmann::json settings = data.value("importSettings", nlohmann::json::object());
+			_importSettings.streamLayout = settings.value("streamLayout", defaults.streamLayout);
+			_importSettings.positionEncoding = settings.value("positionEncoding", defaults.positionEncoding);
+			_importSettings.octahedralNormals = settings.value("octahedralNormals", defaults.octahedralNormals);
+			_importSettings.unormTexCoords = settings.value("unormTexCoords", defaults.unormTexCoords);
+			_importSettings.optimize = settings.value("optimize", defaults.optimize);
 			if (_loaded) Unload();
 		}
 
@@ -50,9 +65,16 @@ namespace Engine {
 			if (meshIndex != _meshIndex) Unload(); // If index changed, unload the mesh
 			_meshIndex = meshIndex;
 		}
+
+		const MeshImportSettings& GetImportSettings() const { return _importSettings; }
+		void SetImportSettings(const MeshImportSettings& importSettings) {
+			if (importSettings.GetKey() != _importSettings.GetKey()) Unload(); // If the encoding changed, reimport the mesh
+			_importSettings = importSettings;
+		}
 	private:
 		std::shared_ptr<Mesh> _internalMesh = nullptr;
 		std::string _meshPath;
 		uint32_t _meshIndex;
+		MeshImportSettings _importSettings;
 	};
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Project/AssetSystem.h";
 #include "Rendering/Platform/Texture2D.h"
 #include "Rendering/Platform/TextureCubeMap.h"
+#include "Rendering/TextureLoader.h"
 
 namespace Engine {
 	class TextureAsset : public Asset {
@@ -13,11 +14,11 @@ namespace Engine {
 			// Load texture from file
 			switch (_type) {
 			case TextureType::Tex2D:
-				_internalTexture = Texture2D::Utils::FromFile(_texturePath);
+				// A placeholder until the decode pool has finished with it
+				_internalTexture = TextureLoader::LoadAsync({ _texturePath, true, MipGeneration::GPU, _compression });
 				break;
 			case TextureType::TexCubemap:
-				auto texture2D = Texture2D::Utils::FromFile(_texturePath);
-				_internalTexture = TextureCubemap::Utils::FromTexture2D(texture2D, TextureCubemap::Utils::Texture2DCubemapFormat::Equirectangle);
+				_internalTexture = TextureCubemap::Utils::FromEquirectangularFile(_texturePath);
 				break;
 			}
 			_loaded = true;
@@ -32,6 +33,7 @@ namespace Engine {
 			nlohmann::json data = Asset::Serialize();
 			data["texturePath"] = _texturePath;
 			data["type"] = _type;
+			data["compression"] = _compression;
 			return data;
 		}
 
@@ -39,6 +41,7 @@ namespace Engine {
 			Asset::Deserialize(data);
 			_texturePath = data["texturePath"];
 			_type = data["type"];
+			_compression = data.value("compression", TextureCompression::None);
 			if (_loaded) Unload();
 		}
 
@@ -61,10 +64,19 @@ namespace Engine {
 			_type = type;
 		}
 
+		// Only applies to 2D textures, cubemaps are rendered from an uncompressed source
+		TextureCompression GetCompression() const { return _compression; }
+		void SetCompression(TextureCompression compression) {
+			if (compression != _compression)
+				Unload();
+			_compression = compression;
+		}
+
 	protected:
 		std::shared_ptr<BaseTexture> _internalTexture = nullptr;
 
 		std::string _texturePath;
 		TextureType _type;
+		TextureCompression _compression = TextureCompression::None;
 	};
 }
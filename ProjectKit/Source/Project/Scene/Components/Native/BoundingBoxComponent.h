@@ -28,8 +28,7 @@ namespace Engine {
 			spdlog::stopwatch sw;
 			uint32_t sCount = mesh.GetSubmeshCount();
 			for (uint32_t sIndex = 0; sIndex < sCount; sIndex++) {
-				const auto& vbo = mesh.GetSubmesh(sIndex).GetVertexBuffer(0);
-				const auto& points = vbo.GetData<glm::vec3>();
+				const auto& points = mesh.GetSubmesh(sIndex).GetVertexData<glm::vec3>(0);
 
 				for (int i = 0; i < points.size(); i++) {
 					GrowToInclude(points[i]);
@@ -5,6 +5,7 @@
 
 #include "Rendering/Platform/Buffer/VertexArrayObject.h"
 #include "Rendering/Platform/Buffer/VertexBufferObject.h"
+#include "Rendering/Platform/Buffer/StreamingBuffer.h"
 
 namespace Engine {
 #pragma region Shaders
@@ -335,6 +336,8 @@ namespace Engine {
 	}
 
 	void DebugShapeManager::initialize() {
+        shapeStream = std::make_shared<StreamingBuffer>();
+
         /* Points */
         {
             pointShader = std::make_shared<Shader>();
@@ -344,15 +347,14 @@ namespace Engine {
             pointShader->Link();
             pointShader->BindUniformBlock("CameraData", 0);
 
-            pointInfoVbo = std::make_shared<VertexBufferObject>(BufferUsage::Dynamic);
-            pointInfoVbo->SetData(nullptr, 0, {
+            pointLayout = {
                         { "aPos", Engine::LType::Float, 3 },
                         { "aRadius", Engine::LType::Float, 1 },
                         { "aColor", Engine::LType::Float, 4 }
-                                  });
+                                  };
 
             pointInfoVao = std::make_shared<VertexArrayObject>();
-            pointInfoVao->AddVertexBuffer(pointInfoVbo);
+            pointInfoVao->AddVertexBuffer(shapeStream, pointLayout);
             pointInfoVao->Compute();
         }
 
@@ -365,15 +367,14 @@ namespace Engine {
             lineShader->Link();
             lineShader->BindUniformBlock("CameraData", 0);
 
-            lineInfoVbo = std::make_shared<VertexBufferObject>(BufferUsage::Dynamic);
-            lineInfoVbo->SetData(nullptr, 0, {
+            lineLayout = {
                         { "aStartPos", Engine::LType::Float, 3 },
                         { "aEndPos", Engine::LType::Float, 3 },
                         { "aColor", Engine::LType::Float, 4 }
-                                 });
+                                 };
 
             lineInfoVao = std::make_shared<VertexArrayObject>();
-            lineInfoVao->AddVertexBuffer(lineInfoVbo);
+            lineInfoVao->AddVertexBuffer(shapeStream, lineLayout);
             lineInfoVao->Compute();
         }
 
@@ -386,17 +387,16 @@ namespace Engine {
             quadShader->Link();
             quadShader->BindUniformBlock("CameraData", 0);
 
-			quadInfoVbo = std::make_shared<VertexBufferObject>(BufferUsage::Dynamic);
-            quadInfoVbo->SetData(nullptr, 0, {
+			quadLayout = {
 						{ "aP1", Engine::LType::Float, 3 },
 						{ "aP2", Engine::LType::Float, 3 },
 						{ "aP3", Engine::LType::Float, 3 },
 						{ "aP4", Engine::LType::Float, 3 },
 						{ "aColor", Engine::LType::Float, 4 }
-								  });
+								  };
 
 			quadInfoVao = std::make_shared<VertexArrayObject>();
-			quadInfoVao->AddVertexBuffer(quadInfoVbo);
+			quadInfoVao->AddVertexBuffer(shapeStream, quadLayout);
 			quadInfoVao->Compute();
         }
 	}
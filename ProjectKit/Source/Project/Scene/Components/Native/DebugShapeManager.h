@@ -11,6 +11,8 @@
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
+#include "Rendering/Platform/Buffer/VertexBufferObject.h"
+
 
 namespace Engine {
 	class Entity;
@@ -18,17 +20,20 @@ namespace Engine {
 	class Shader;
 
 	class VertexArrayObject;
-	class VertexBufferObject;
+	class StreamingBuffer;
 
 	struct DebugShapeManager : BaseComponent {
 	public:
 		bool renderDebugShapes = true;
 
+		// Every shape type is written into the same per frame stream, each one at a multiple of its own stride
+		std::shared_ptr<StreamingBuffer> shapeStream;
+
 		struct PointSpec { glm::vec3 pos; float size; glm::vec4 color; };
 		std::vector<PointSpec> pointData;
 
 		std::shared_ptr<VertexArrayObject> pointInfoVao;
-		std::shared_ptr<VertexBufferObject> pointInfoVbo;
+		VertexLayout pointLayout;
 		std::shared_ptr<Shader> pointShader;
 
 		void DrawPoint(const PointSpec& spec);
@@ -37,7 +42,7 @@ namespace Engine {
 		std::vector<LineSpec> lineData;
 
 		std::shared_ptr<VertexArrayObject> lineInfoVao;
-		std::shared_ptr<VertexBufferObject> lineInfoVbo;
+		VertexLayout lineLayout;
 		std::shared_ptr<Shader> lineShader;
 
 		void DrawLine(const LineSpec& spec);
@@ -46,7 +51,7 @@ namespace Engine {
 		std::vector<QuadSpec> quadData;
 
 		std::shared_ptr<VertexArrayObject> quadInfoVao;
-		std::shared_ptr<VertexBufferObject> quadInfoVbo;
+		VertexLayout quadLayout;
 		std::shared_ptr<Shader> quadShader;
 
 		void DrawQuad(const QuadSpec& spec);
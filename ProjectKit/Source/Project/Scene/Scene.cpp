@@ -12,6 +12,12 @@ Scene::Scene() {
 		e.AddComponent<DebugShapeManager>();
 		_debugShapeManager = e.GetInstanceID();
 	}
+
+	_registry.on_destroy<MeshFilterComponent>().connect<&Scene::onMeshFilterDestroyed>(*this);
+}
+
+Scene::~Scene() {
+	_registry.on_destroy<MeshFilterComponent>().disconnect(this);
 }
 
 Entity Scene::CreateEntity(const std::string& name) {
@@ -46,7 +52,31 @@ Entity Scene::GetEntity(const std::string& name) {
 }
 
 void Scene::UpdateScene(float ts) {
+	updateSpatialIndex();
+}
+
+void Scene::updateSpatialIndex() {
+	// Transforms are edited in place, so changes are found by comparing the world bounds
+	auto view = _registry.view<const TransformComponent, const MeshFilterComponent>();
+	for (auto entity : view) {
+		auto& filter = view.get<const MeshFilterComponent>(entity);
+		auto& transform = view.get<const TransformComponent>(entity);
+
+		uint32_t key = (uint32_t)entity;
+		if (!filter.meshAsset || !filter.meshAsset->GetInternal()->GetBounds().IsValid()) {
+			_spatialIndex.Remove(key);
+			continue;
+		}
+
+		const BoundingBox& bounds = filter.meshAsset->GetInternal()->GetBounds();
+		_spatialIndex.Update(key, bounds.Transformed(transform.GetTransformMatrix()));
+	}
+
+	_spatialIndex.Commit();
+}
 
+void Scene::onMeshFilterDestroyed(entt::registry&, entt::entity entity) {
+	_spatialIndex.Remove((uint32_t)entity);
 }
 
 void Scene::RenderScene() {
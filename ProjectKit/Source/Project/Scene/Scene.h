@@ -1,6 +1,7 @@
 #pragma once
 #include <entt/entt.hpp>
 #include "Project/Scene/Components/Native/DebugShapeManager.h"
+#include "Util/Math/BoundingVolumeHierarchy.h"
 
 namespace Engine {
 	class Entity;
@@ -8,7 +9,7 @@ namespace Engine {
 	class Scene {
 	public:
 		Scene();
-		~Scene() = default;
+		~Scene();
 
 		Entity CreateEntity(const std::string& name = "");
 		void DestroyEntity(Entity entity);
@@ -28,9 +29,16 @@ namespace Engine {
 		entt::registry& GetRegistry() { return _registry; }
 
 		DebugShapeManager& GetDebugRenderer() { return _registry.get<DebugShapeManager>(_debugShapeManager); }
+
+		// World bounds of every entity with a bounded mesh, keyed by entity, brought up to date by UpdateScene
+		const BoundingVolumeHierarchy& GetSpatialIndex() const { return _spatialIndex; }
+	private:
+		void updateSpatialIndex();
+		void onMeshFilterDestroyed(entt::registry& registry, entt::entity entity);
 	private:
 		entt::registry _registry;
 		entt::entity _debugShapeManager;
+		BoundingVolumeHierarchy _spatialIndex;
 
 		friend class Entity;
 	};
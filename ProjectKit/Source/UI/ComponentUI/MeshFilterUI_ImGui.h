@@ -47,7 +47,7 @@ namespace Engine {
 
 											ImGui::EndTable();
 										}
-										ImGui::Text("Count: %d", vb.GetCount());
+										ImGui::Text("Count: %d", va.GetVertexCount());
 										ImGui::TreePop();
 									}
 								}
@@ -59,7 +59,7 @@ namespace Engine {
 
 								if (ImGui::TreeNode("Index Buffer")) {
 									ImGui::Text("Type: %s", UIUtil::LTypeToString(ib.GetType()).c_str());
-									ImGui::Text("Count: %d", ib.GetCount());
+									ImGui::Text("Count: %d", va.GetIndexCount());
 									ImGui::TreePop();
 								}
 							}
@@ -2,6 +2,7 @@
     "guid": "8ab2ef3fc8945c9b59c8b1e9fa4d3163",
     "shaderPath": "Resources/Shaders/PBR.glsl",
     "uniformBlockMap": {
-        "CameraData": 0
+        "CameraData": 0,
+        "ObjectData": 2
     }
 }
\ No newline at end of file
@@ -6,21 +6,43 @@ layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNor;
 layout(location = 2) in vec2 aTex;
 
+// per instance, only read when drawing instanced
+layout(location = 8) in mat4 iModel;
+layout(location = 12) in mat3 iNormalMatrix;
+
 layout (std140) uniform CameraData {
 	mat4 projection;
 	mat4 view;
 };
-uniform mat4 model;
+layout (std140) uniform ObjectData {
+	mat4 model;
+	mat4 normalMatrix;
+	uint entityId;
+};
+uniform bool useInstancing;
+// aNor.xy holds octahedral coordinates, see MeshImportSettings
+uniform bool octahedralNormals;
 
 out vec3 vPos;
 out vec3 vNor;
 out vec2 vTex;
 
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
 void main()
 {
 	vTex = aTex;
-    vNor = mat3(transpose(inverse(model))) * aNor;
-    vPos = vec3(model * vec4(aPos, 1.0));
+    mat4 m = useInstancing ? iModel : model;
+    mat3 n = useInstancing ? iNormalMatrix : mat3(normalMatrix);
+
+    vNor = n * (octahedralNormals ? octahedralDecode(aNor.xy) : aNor);
+    vPos = vec3(m * vec4(aPos, 1.0));
 
     gl_Position = projection * view * vec4(vPos, 1.0);
 }
@@ -33,22 +55,25 @@ in vec3 vPos;
 in vec3 vNor;
 in vec2 vTex;
 
-// material parameters
-uniform vec3 albedo;
-uniform float metallic;
-uniform float roughness;
-uniform float ao;
+// material parameters and lights, ordered to pack tightly under std140
+layout (std140) uniform MaterialData {
+	vec3 albedo;
+	float metallic;
+	vec3 lightPosition;
+	float roughness;
+	vec3 lightColor;
+	float ao;
+};
 
 // IBL
 uniform samplerCube irradianceMap;
-
-// lights
-uniform vec3 lightPosition;
-uniform vec3 lightColor;
+uniform samplerCube prefilterMap; // Roughness increases down the levels
+uniform sampler2D brdfLUT;
 
 uniform vec3 camPos;
 
 const float PI = 3.14159265359;
+uniform float prefilterMaxLod; // levels of prefilterMap - 1, set by EnvironmentLighting
 
 // ----------------------------------------------------------------------------
 float DistributionGGX(vec3 N, vec3 H, float roughness)
@@ -91,6 +116,11 @@ vec3 fresnelSchlick(float cosTheta, vec3 F0)
     return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }
 // ----------------------------------------------------------------------------
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
+{
+    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+// ----------------------------------------------------------------------------
 void main()
 {		
     vec3 N = vNor;
@@ -144,12 +174,19 @@ void main()
 
 
     // ambient lighting (we now use IBL as the ambient term)
-    vec3 kS = fresnelSchlick(max(dot(N, V), 0.0), F0);
+    float NdotV = max(dot(N, V), 0.0);
+    vec3 kS = fresnelSchlickRoughness(NdotV, F0, roughness);
     vec3 kD = 1.0 - kS;
     kD *= 1.0 - metallic;	  
     vec3 irradiance = texture(irradianceMap, N).rgb;
     vec3 diffuse      = irradiance * albedo;
-    vec3 ambient = (kD * diffuse) * ao;
+
+    // split sum: the prefiltered environment scaled and biased by the BRDF lookup
+    vec3 prefilteredColor = textureLod(prefilterMap, R, roughness * prefilterMaxLod).rgb;
+    vec2 brdf = texture(brdfLUT, vec2(NdotV, roughness)).rg;
+    vec3 specular = prefilteredColor * (kS * brdf.x + brdf.y);
+
+    vec3 ambient = (kD * diffuse + specular) * ao;
     // vec3 ambient = vec3(0.002);
     
     vec3 color = ambient + Lo;
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <imgui.h>
+
+#include "Rendering/FrustumCuller.h"
+#include "Util/Math/Frustum.h"
+#include "Util/Math/BoundingBox.h"
+
+// Compares the batch frustum culler against testing every box with Frustum::Intersects in a plain loop
+class CullingBenchmark {
+public:
+	int objectCount = 100000;
+	int iterations = 20;
+
+	struct Result { const char* name; double milliseconds; uint32_t visible; bool matches; };
+	std::vector<Result> results;
+
+	void Run() {
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> size(0.1f, 4.0f);
+
+		std::vector<Engine::BoundingBox> boxes((size_t)objectCount);
+		Engine::FrustumCuller culler;
+		culler.Reserve((uint32_t)objectCount);
+		for (auto& box : boxes) {
+			glm::vec3 center = { position(rng), position(rng), position(rng) };
+			glm::vec3 extents = { size(rng), size(rng), size(rng) };
+			box = Engine::BoundingBox(center - extents, center + extents);
+			culler.Add(box);
+		}
+
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.2f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		Engine::Frustum frustum = Engine::Frustum::FromMatrix(projection * view);
+
+		results.clear();
+
+		std::vector<uint32_t> reference;
+		double naiveTime = time([&]() {
+			reference.clear();
+			for (uint32_t i = 0; i < (uint32_t)boxes.size(); i++)
+				if (frustum.Intersects(boxes[i]))
+					reference.push_back(i);
+		});
+		results.push_back({ "Naive glm loop", naiveTime, (uint32_t)reference.size(), true });
+
+		std::vector<uint32_t> visible;
+		for (auto path : { Engine::FrustumCuller::Path::Scalar, Engine::FrustumCuller::Path::SSE, Engine::FrustumCuller::Path::AVX }) {
+			if (!Engine::FrustumCuller::IsPathSupported(path))
+				continue;
+
+			double pathTime = time([&]() { culler.Cull(frustum, visible, path); });
+			results.push_back({ Engine::FrustumCuller::GetPathName(path), pathTime, (uint32_t)visible.size(), visible == reference });
+		}
+	}
+private:
+	// Average milliseconds per run
+	template<typename Func>
+	double time(Func func) {
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iterations; i++)
+			func();
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count() / std::max(iterations, 1);
+	}
+};
+
+class CullingBenchmarkUI_ImGui {
+public:
+	static void RenderUI(CullingBenchmark& benchmark) {
+		if (ImGui::TreeNodeEx("Culling Benchmark", ImGuiTreeNodeFlags_Framed)) {
+			ImGui::SliderInt("Objects", &benchmark.objectCount, 1000, 1000000);
+			ImGui::SliderInt("Iterations", &benchmark.iterations, 1, 100);
+			if (ImGui::Button("Run"))
+				benchmark.Run();
+
+			double baseline = benchmark.results.empty() ? 0.0 : benchmark.results[0].milliseconds;
+			for (const auto& result : benchmark.results) {
+				ImGui::Text("%s: %.3fms (%.1fx), %u visible%s", result.name, result.milliseconds,
+					result.milliseconds > 0.0 ? baseline / result.milliseconds : 0.0, result.visible, result.matches ? "" : " MISMATCH");
+			}
+
+			ImGui::TreePop();
+		}
+	}
+};
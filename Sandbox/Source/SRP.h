@@ -7,6 +7,12 @@
 #include "Rendering/Platform/Buffer/UniformBufferObject.h"
 #include "Rendering/Platform/Framebuffer.h"
 #include "Rendering/RenderManager.h"
+#include "Rendering/GLStateCache.h"
+#include "Rendering/RenderQueue.h"
+#include "Rendering/GeometryPool.h"
+#include "Rendering/FrustumCuller.h"
+#include "Rendering/Platform/Buffer/StreamingBuffer.h"
+#include "Util/Math/Frustum.h"
 #include "Project/Scene/Components/Native/Components.h"
 
 #pragma region Skybox Shader
@@ -93,6 +99,21 @@ private:
 	std::shared_ptr<Engine::VertexArrayObject> _fullscreenQuadVao;
 	std::shared_ptr<Engine::Shader> _postProcessShader;
 
+	Engine::RenderQueue _opaqueQueue;
+	Engine::GeometryPool _geometryPool;
+	bool _useGeometryPool = true;
+	bool _frustumCulling = true;
+	bool _spatialIndexCulling = true; // Query the scene BVH, otherwise test every bounded mesh with the FrustumCuller
+	uint32_t _culledCount = 0;
+	std::vector<uint32_t> _visibleEntities;
+
+	// Bounded objects wait here until the whole batch has been culled
+	struct CullCandidate { Engine::Material* material; Engine::Mesh* mesh; glm::mat4 model; float depth; uint32_t entityId; };
+	std::vector<CullCandidate> _cullCandidates;
+	std::vector<uint32_t> _visibleCandidates;
+	Engine::FrustumCuller _frustumCuller;
+	int _cullPath = -1; // -1 picks the best supported path
+
 	float _exposure = 1.0f;
 public:
 	virtual void Initialize(std::shared_ptr<Engine::Framebuffer> mainFramebuffer) {
@@ -204,14 +225,14 @@ public:
 
 		framebuffer->Bind();
 
-		glEnable(GL_DEPTH_TEST);
+		Engine::GLStateCache::SetDepthTest(true);
 		Engine::RenderCommands::SetClearColor(camera.backgroundColor.r, camera.backgroundColor.g, camera.backgroundColor.b);
 		Engine::RenderCommands::ClearBuffers(camera.clearFlags);
 
 		_cameraDataUbo->Bind();
 		_cameraDataUbo->SetData(&cameraData, sizeof(CameraData), 0);
 
-		RenderOpaqueObjects(scene, cameraTransform);
+		RenderOpaqueObjects(scene, cameraTransform, Engine::Frustum::FromMatrix(cameraData.projection * cameraData.view));
 		RenderDebugMeshes(scene, viewportSize);
 
 		// Render Skybox
@@ -224,9 +245,9 @@ public:
 			auto skyboxCubemap = camera.skyboxCubemap->GetInternal();
 			skyboxCubemap->Bind(0);
 
-			glDepthMask(GL_FALSE);
+			Engine::GLStateCache::SetDepthMask(false);
 			Engine::RenderCommands::RenderMesh(*_skyboxVao, *_skyboxShader);
-			glDepthMask(GL_TRUE);
+			Engine::GLStateCache::SetDepthMask(true);
 		}
 
 		framebuffer->Unbind();
@@ -234,7 +255,7 @@ public:
 		// Apply Post Processing
 		_mainFb->Bind();
 		Engine::RenderCommands::SetClearColor(0.2f, 0.5f, 0.1f);
-		glDisable(GL_DEPTH_TEST);
+		Engine::GLStateCache::SetDepthTest(false);
 		Engine::RenderCommands::ClearBuffers(FlagSet(Engine::BufferBit::Color));
 		_windowFramebuffer->GetColorAttachment(0)->Bind(0);
 		Engine::RenderCommands::RenderMesh(*_fullscreenQuadVao, *_postProcessShader);
@@ -242,15 +263,39 @@ public:
 
 		if (ImGui::DragFloat("Scene Exposure", &_exposure, 0.05f, 0.0f, 100.0f))
 			_postProcessShader->SetUniform("exposure", _exposure);
+		bool instancing = _opaqueQueue.IsInstancingEnabled();
+		if (ImGui::Checkbox("GPU Instancing", &instancing))
+			_opaqueQueue.SetInstancingEnabled(instancing);
+		ImGui::Checkbox("Geometry Pool (Multi Draw)", &_useGeometryPool);
+		ImGui::Checkbox("Frustum Culling", &_frustumCulling);
+		ImGui::Checkbox("Cull With Scene BVH", &_spatialIndexCulling);
+		ImGui::SliderInt("Cull Path", &_cullPath, -1, (int)Engine::FrustumCuller::Path::AVX, _cullPath < 0 ? "Best" : Engine::FrustumCuller::GetPathName((Engine::FrustumCuller::Path)_cullPath));
+		const auto& queueStats = _opaqueQueue.GetStats();
+		ImGui::Text("Opaque: %u objects, %u draw calls, %u instanced batches, %u multi draws", queueStats.packets, queueStats.drawCalls, queueStats.instancedBatches, queueStats.multiDrawBatches);
+		ImGui::Text("Binds: %u shader, %u material", queueStats.shaderBinds, queueStats.materialBinds);
+		ImGui::Text("Culled: %u objects", _culledCount);
 	}
 
-	void RenderOpaqueObjects(Engine::Scene& scene, Engine::TransformComponent& cameraTransform) {
+	void RenderOpaqueObjects(Engine::Scene& scene, Engine::TransformComponent& cameraTransform, const Engine::Frustum& frustum) {
 		auto& reg = scene.GetRegistry();
+		_opaqueQueue.Clear();
+		_culledCount = 0;
+		_cullCandidates.clear();
+		_frustumCuller.Clear();
+		_geometryPool.NewFrame();
+		_opaqueQueue.SetGeometryPool(_useGeometryPool ? &_geometryPool : nullptr);
+
+		const auto& spatialIndex = scene.GetSpatialIndex();
+		bool useSpatialIndex = _frustumCulling && _spatialIndexCulling;
 
 		/* Render Meshes */
 		{
 			auto view = reg.view<const Engine::TransformComponent, Engine::MeshFilterComponent, Engine::MeshRendererComponent>();
 			for (auto entity : view) {
+				// Bounded meshes are found by the spatial index query below
+				if (useSpatialIndex && spatialIndex.Contains((uint32_t)entity))
+					continue;
+
 				auto& filter = view.get<Engine::MeshFilterComponent>(entity);
 				auto& renderer = view.get<Engine::MeshRendererComponent>(entity);
 				auto& transform = view.get<Engine::TransformComponent>(entity);
@@ -268,11 +313,56 @@ public:
 				auto& materialAsset = *renderer.materialAsset;
 				auto& meshAsset = *filter.meshAsset;
 
-				materialAsset.SetUniform("model", transform.GetTransformMatrix());
+				auto& mesh = *meshAsset.GetInternal();
+				glm::mat4 model = transform.GetTransformMatrix();
+
+				float depth = glm::length(transform.position - cameraTransform.position);
+
+				// Meshes without bounds are always drawn
+				if (_frustumCulling && !useSpatialIndex && mesh.GetBounds().IsValid()) {
+					_frustumCuller.Add(mesh.GetBounds().Transformed(model));
+					_cullCandidates.push_back({ materialAsset.GetInternal().get(), &mesh, model, depth, (uint32_t)entity });
+					continue;
+				}
+
+				_opaqueQueue.Submit(*materialAsset.GetInternal(), mesh, model, depth, (uint32_t)entity);
+			}
+		}
+
+		/* Query Bounded Meshes */
+		if (useSpatialIndex) {
+			// The scene keeps the index up to date with every bounded mesh, so only visible ones are visited
+			_visibleEntities.clear();
+			spatialIndex.QueryFrustum(frustum, _visibleEntities);
+			_culledCount = spatialIndex.GetCount() - (uint32_t)_visibleEntities.size();
+
+			for (uint32_t key : _visibleEntities) {
+				entt::entity entity = (entt::entity)key;
+				auto* renderer = reg.try_get<Engine::MeshRendererComponent>(entity);
+				if (!renderer || !renderer->materialAsset)
+					continue;
+
+				auto& filter = reg.get<Engine::MeshFilterComponent>(entity);
+				auto& transform = reg.get<Engine::TransformComponent>(entity);
+				float depth = glm::length(transform.position - cameraTransform.position);
+				_opaqueQueue.Submit(*renderer->materialAsset->GetInternal(), *filter.meshAsset->GetInternal(), transform.GetTransformMatrix(), depth, key);
+			}
+		}
+
+		/* Cull Bounded Meshes */
+		if (!_cullCandidates.empty()) {
+			auto path = _cullPath < 0 ? Engine::FrustumCuller::GetBestPath() : (Engine::FrustumCuller::Path)_cullPath;
+			_frustumCuller.Cull(frustum, _visibleCandidates, path);
+			_culledCount = (uint32_t)(_cullCandidates.size() - _visibleCandidates.size());
 
-				Engine::RenderCommands::RenderMesh(*meshAsset.GetInternal(), *materialAsset.GetInternal());
+			for (uint32_t index : _visibleCandidates) {
+				auto& candidate = _cullCandidates[index];
+				_opaqueQueue.Submit(*candidate.material, *candidate.mesh, candidate.model, candidate.depth, candidate.entityId);
 			}
 		}
+
+		_opaqueQueue.Sort();
+		_opaqueQueue.Execute();
 	}
 
 	void RenderDebugMeshes(Engine::Scene& scene, const glm::vec2& viewportSize) {
@@ -293,31 +383,51 @@ public:
 		if (!dsm.renderDebugShapes)
 			return;
 
+		auto& stream = *dsm.shapeStream;
+		stream.BeginFrame();
+
+		// Worst case including the padding that lines each shape type up with its stride
+		uint64_t requiredSize = dsm.pointData.size() * dsm.pointLayout.GetStride() + dsm.pointLayout.GetStride()
+			+ dsm.lineData.size() * dsm.lineLayout.GetStride() + dsm.lineLayout.GetStride()
+			+ dsm.quadData.size() * dsm.quadLayout.GetStride() + dsm.quadLayout.GetStride();
+		if (stream.Reserve(requiredSize)) {
+			dsm.pointInfoVao->Compute();
+			dsm.lineInfoVao->Compute();
+			dsm.quadInfoVao->Compute();
+		}
+
 		RenderPoints(dsm, viewportSize);
 		RenderLines(dsm);
 		RenderQuads(dsm);
 
+		stream.EndFrame();
 		dsm.Clear();
 	}
 
+	// Copies the shapes into the stream, first is the vertex to start drawing from
+	template<typename T>
+	bool StreamShapes(Engine::StreamingBuffer& stream, const std::vector<T>& shapes, const Engine::VertexLayout& layout, uint32_t& first) {
+		uint32_t stride = layout.GetStride();
+		uint64_t offset;
+		if (!stream.Write(shapes.data(), shapes.size() * stride, stride, offset))
+			return false;
+
+		first = (uint32_t)(offset / stride);
+		return true;
+	}
+
 	void RenderPoints(Engine::DebugShapeManager& dsm, const glm::vec2& viewportSize) {
 		auto& shader = *dsm.pointShader;
 		shader.SetUniform("viewportSize", viewportSize);
 
 		auto& vao = *dsm.pointInfoVao;
-		auto& vbo = *dsm.pointInfoVbo;
 
 		uint32_t pointCount = (uint32_t)dsm.pointData.size();
-		if (pointCount == 0)
+		uint32_t first;
+		if (pointCount == 0 || !StreamShapes(*dsm.shapeStream, dsm.pointData, dsm.pointLayout, first))
 			return;
 
-		vbo.SetData(dsm.pointData.data(), pointCount, {
-			{ "aPos", Engine::LType::Float, 3 },
-			{ "aRadius", Engine::LType::Float, 1 },
-			{ "aColor", Engine::LType::Float, 4 }
-					});
-
-		Engine::RenderCommands::RenderPoints(vao, pointCount, shader);
+		Engine::RenderCommands::RenderPoints(vao, pointCount, shader, first);
 	}
 
 	void RenderLines(Engine::DebugShapeManager& dsm) {
@@ -325,39 +435,25 @@ public:
 		shader.SetUniform("thickness", 0.005f);
 
 		auto& vao = *dsm.lineInfoVao;
-		auto& vbo = *dsm.lineInfoVbo;
 
 		uint32_t lineCount = (uint32_t)dsm.lineData.size();
-		if (lineCount == 0)
+		uint32_t first;
+		if (lineCount == 0 || !StreamShapes(*dsm.shapeStream, dsm.lineData, dsm.lineLayout, first))
 			return;
 
-		vbo.SetData(dsm.lineData.data(), lineCount, {
-			{ "aStartPos", Engine::LType::Float, 3 },
-			{ "aEndPos", Engine::LType::Float, 3 },
-			{ "aColor", Engine::LType::Float, 4 }
-					});
-
-		Engine::RenderCommands::RenderPoints(vao, lineCount, shader);
+		Engine::RenderCommands::RenderPoints(vao, lineCount, shader, first);
 	}
 
 	void RenderQuads(Engine::DebugShapeManager& dsm) {
 		auto& shader = *dsm.quadShader;
 
 		auto& vao = *dsm.quadInfoVao;
-		auto& vbo = *dsm.quadInfoVbo;
 
 		uint32_t quadCount = (uint32_t)dsm.quadData.size();
-		if (quadCount == 0)
+		uint32_t first;
+		if (quadCount == 0 || !StreamShapes(*dsm.shapeStream, dsm.quadData, dsm.quadLayout, first))
 			return;
 
-		vbo.SetData(dsm.quadData.data(), quadCount, {
-			{ "aP1", Engine::LType::Float, 3 },
-			{ "aP2", Engine::LType::Float, 3 },
-			{ "aP3", Engine::LType::Float, 3 },
-			{ "aP4", Engine::LType::Float, 3 },
-			{ "aColor", Engine::LType::Float, 4 }
-					});
-
-		Engine::RenderCommands::RenderPoints(vao, quadCount, shader);
+		Engine::RenderCommands::RenderPoints(vao, quadCount, shader, first);
 	}
 };
\ No newline at end of file
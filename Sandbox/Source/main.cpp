@@ -11,6 +11,11 @@
 #include "Rendering/Platform/Buffer/UniformBufferObject.h"
 #include "Rendering/Platform/Texture2D.h"
 #include "Rendering/Platform/TextureCubeMap.h"
+#include "Rendering/GLStateCache.h"
+#include "Rendering/EnvironmentLighting.h"
+#include "Rendering/TextureLoader.h"
+#include "Rendering/TextureUploadQueue.h"
+#include "Rendering/TextureResidency.h"
 
 #include "Util/Mesh/GltfIO.h"
 
@@ -21,6 +26,7 @@
 
 #include "FPSCameraController.h"
 #include "OrbitCameraController.h"
+#include "CullingBenchmark.h"
 
 #include "SRP.h"
 
@@ -43,6 +49,7 @@ private:
 	Engine::Entity _camera;
 	FPSCameraController _fpsCameraController;
 	OrbitCameraController _orbitCameraController;
+	CullingBenchmark _cullingBenchmark;
 
 	bool _renderWireframe = false;
 public:
@@ -70,116 +77,15 @@ public:
 		_camera = _sceneAsset->GetInternal()->GetEntity("Camera");
 		_camera.GetComponent<Engine::CameraComponent>().renderPipeline = _standardRenderPipeline;
 
-		/* Create Irradiance Map */
-		std::shared_ptr<Engine::TextureCubemap> irradianceCubemap;
-		{
-			glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-			glm::mat4 captureViews[] = {
-				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
-			};
-
-			auto skyboxAsset = _camera.GetComponent<Engine::CameraComponent>().skyboxCubemap;
-			auto skyboxCubemap = skyboxAsset->GetInternal();
-
-		#pragma region Skybox Data
-			float skyboxVertices[] = {
-				// positions          
-				-1.0f,  1.0f, -1.0f,
-				-1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-				 1.0f,  1.0f, -1.0f,
-				-1.0f,  1.0f, -1.0f,
-
-				-1.0f, -1.0f,  1.0f,
-				-1.0f, -1.0f, -1.0f,
-				-1.0f,  1.0f, -1.0f,
-				-1.0f,  1.0f, -1.0f,
-				-1.0f,  1.0f,  1.0f,
-				-1.0f, -1.0f,  1.0f,
-
-				 1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-
-				-1.0f, -1.0f,  1.0f,
-				-1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f, -1.0f,  1.0f,
-				-1.0f, -1.0f,  1.0f,
-
-				-1.0f,  1.0f, -1.0f,
-				 1.0f,  1.0f, -1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				-1.0f,  1.0f,  1.0f,
-				-1.0f,  1.0f, -1.0f,
-
-				-1.0f, -1.0f, -1.0f,
-				-1.0f, -1.0f,  1.0f,
-				 1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-				-1.0f, -1.0f,  1.0f,
-				 1.0f, -1.0f,  1.0f
-			};
-		#pragma endregion
-			auto cubeVa = std::make_shared<Engine::VertexArrayObject>();
-			auto skyboxVbo = std::make_shared<Engine::VertexBufferObject>(Engine::BufferUsage::Static);
-			skyboxVbo->SetData(skyboxVertices, 36, {
-				{ "aPos", Engine::LType::Float, 3 }
-							   });
-			cubeVa->AddVertexBuffer(skyboxVbo);
-			cubeVa->Compute();
-			auto cubeMesh = std::make_shared<Engine::Mesh>();
-			cubeMesh->AddSubmesh(cubeVa);
-
-			auto irradianceShader = Engine::Shader::Utils::FromFile("Resources/Shaders/SkyboxConvolution.vert", "Resources/Shaders/SkyboxConvolution.frag");
-			auto irradianceMaterial = std::make_shared<Engine::Material>(irradianceShader);
-			irradianceMaterial->SetTexture("environmentMap", skyboxCubemap);
-			irradianceMaterial->SetUniform("projection", captureProjection);
-
-			uint32_t captureSize = 32;
-
-			auto textureSpec = Engine::TextureSpec{
-				captureSize,
-				captureSize,
-				Engine::ImageFormat::RGB16F
-			};
-			irradianceCubemap = std::make_shared<Engine::TextureCubemap>(textureSpec);
-
-			auto framebufferSpec = Engine::Framebuffer::FramebufferSpec{
-				captureSize,
-				captureSize,
-				{ Engine::ImageFormat::RGB16F },
-				true
-			};
-			auto captureFrambuffer = std::make_shared<Engine::Framebuffer>(framebufferSpec);
-
-			captureFrambuffer->Bind();
-			for (uint32_t i = 0; i < 6; i++) {
-				//captureFrambuffer->ModifyColorAttachment(0, (Engine::TextureTarget)((int)Engine::TextureTarget::CubemapPosX + i), *cubemap);
-				irradianceMaterial->SetUniform("view", captureViews[i]);
-				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceCubemap->GetInstanceID(), 0);
-
-				Engine::RenderCommands::ClearBuffers(Engine::BufferBit::Color | Engine::BufferBit::Depth);
-				Engine::RenderCommands::RenderMesh(*cubeMesh, *irradianceMaterial);
-			}
-			captureFrambuffer->Unbind();
-		}
+		/* Image Based Lighting */
+		// Baked on the CPU on the first run, mapped from the texture cache after that
+		auto skyboxAsset = _camera.GetComponent<Engine::CameraComponent>().skyboxCubemap;
+		auto environment = Engine::EnvironmentLighting::Utils::FromEquirectangularFile(skyboxAsset->GetTexturePath());
 
-		// Set Irradiance Map
 		auto materialAsset = Engine::AssetRef(Engine::GUID("da42cc67d876c4dd408c17b052483920")).Resolve<Engine::MaterialAsset>(_project->GetAssetBank());
 		_pbrMaterial = materialAsset->GetInternal();
-		_pbrMaterial->SetTexture("irradianceMap", irradianceCubemap);
+		if (environment)
+			environment->ApplyTo(*_pbrMaterial);
 		
 		// Camera Controls
 		_fpsCameraController = FPSCameraController(_inputManager);
@@ -254,9 +160,32 @@ public:
 			ImGui::Text("FPS: %.1f", 1.0f / ts);
 			glm::vec2 mp = _inputManager->GetMousePosition();
 			ImGui::Text("Mouse Position: %.1f,%.1f", mp.x, mp.y);
+			const auto& glStats = Engine::GLStateCache::GetLastFrameStats();
+			ImGui::Text("GL State Changes: %llu issued, %llu skipped", glStats.issued, glStats.skipped);
+			const auto& vboStats = Engine::VertexBufferObject::GetStats();
+			ImGui::Text("Vertex Buffers: %u, %.2f / %.2f MB used, %u reallocations, %u shrinks, %u orphans", vboStats.buffers,
+				vboStats.usedBytes / (1024.0 * 1024.0), vboStats.allocatedBytes / (1024.0 * 1024.0), vboStats.reallocations, vboStats.shrinks, vboStats.orphans);
+			const auto& loaderStats = Engine::TextureLoader::GetStats();
+			ImGui::Text("Textures: %u loaded, %u loading, %u failed", loaderStats.completed, loaderStats.GetPending(), loaderStats.failed);
+			const auto& uploadStats = Engine::TextureUploadQueue::GetStats();
+			ImGui::Text("Texture Uploads: %.2f MB this frame, %.2f MB in %u textures pending", uploadStats.bytesLastFrame / (1024.0 * 1024.0),
+				uploadStats.bytesPending / (1024.0 * 1024.0), uploadStats.texturesPending);
+			float uploadBudget = Engine::TextureUploadQueue::GetBudget();
+			if (ImGui::SliderFloat("Upload Budget (MB/frame)", &uploadBudget, 0.25f, 64.0f))
+				Engine::TextureUploadQueue::SetBudget(uploadBudget);
+			const auto& residencyStats = Engine::TextureResidency::GetStats();
+			ImGui::Text("Texture Memory: %.2f / %.2f MB, %u managed (%.2f MB), %u reduced, %u evictions, %u restores",
+				residencyStats.storageBytes / (1024.0 * 1024.0), residencyStats.budgetBytes / (1024.0 * 1024.0), residencyStats.managed,
+				residencyStats.managedBytes / (1024.0 * 1024.0), residencyStats.reduced, residencyStats.evictions, residencyStats.restores);
+			float textureBudget = Engine::TextureResidency::GetBudget();
+			if (ImGui::SliderFloat("Texture Budget (MB)", &textureBudget, 16.0f, 4096.0f))
+				Engine::TextureResidency::SetBudget(textureBudget);
+			const auto& bvhStats = _sceneAsset->GetInternal()->GetSpatialIndex().GetStats();
+			ImGui::Text("BVH: %u items, %u nodes, depth %u, cost %.1f (built %.1f), %u rebuilds, %u refits", bvhStats.items, bvhStats.nodes, bvhStats.depth, bvhStats.cost, bvhStats.builtCost, bvhStats.rebuilds, bvhStats.refits);
 
 			ImGui::Separator();
 			FPSCameraControllerUI_ImGui::RenderUI(_fpsCameraController);
+			CullingBenchmarkUI_ImGui::RenderUI(_cullingBenchmark);
 
 			ImGui::End();
 